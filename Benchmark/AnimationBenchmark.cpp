@@ -0,0 +1,166 @@
+#include "Curve/KnotDeformer.h"
+#include "Curve/SplineGeometry.h"
+#include "Util/JobSystem.h"
+
+#include <QThread>
+#include <QVector>
+#include <QVector3D>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace BSplineRenderer;
+
+namespace
+{
+    constexpr int CURVE_COUNT = 1 << 10;
+    constexpr int KNOTS_PER_CURVE = 1 << 10;
+    constexpr int KNOT_COUNT = CURVE_COUNT * KNOTS_PER_CURVE;
+    constexpr int KNOTS_PER_JOB = 1 << 14;
+    constexpr int FRAMES = 15;
+
+    // The same layout as AnimationManager, the rest pose of all curves in one structure of arrays
+    struct Scene
+    {
+        std::vector<std::unique_ptr<SplineGeometry>> curves;
+        QVector<SplineGeometry*> geometries;
+        SampleArray rest;
+        SampleArray pose;
+        std::vector<float> indices;
+        std::vector<KnotPtr> knots;
+    };
+
+    void CreateScene(Scene& scene)
+    {
+        scene.rest.Resize(KNOT_COUNT);
+        scene.pose.Resize(KNOT_COUNT);
+
+        for (int c = 0; c < CURVE_COUNT; ++c)
+        {
+            auto curve = std::make_unique<SplineGeometry>();
+
+            for (int i = 0; i < KNOTS_PER_CURVE; ++i)
+            {
+                const float t = 0.1f * i;
+                const int index = scene.knots.size();
+                const QVector3D position(5.0f * std::cos(t) + c, 0.01f * i, 5.0f * std::sin(t));
+
+                scene.rest.x[index] = position.x();
+                scene.rest.y[index] = position.y();
+                scene.rest.z[index] = position.z();
+                scene.indices.push_back(i);
+                scene.knots.push_back(curve->AddKnot(position));
+            }
+
+            scene.geometries << curve.get();
+            scene.curves.push_back(std::move(curve));
+        }
+
+        SplineGeometry::UpdateBatch(scene.geometries);
+    }
+
+    double Median(std::vector<double> timings)
+    {
+        std::nth_element(timings.begin(), timings.begin() + timings.size() / 2, timings.end());
+        return timings[timings.size() / 2];
+    }
+
+    // Median milliseconds of deforming every knot on one thread, without writing the knots back
+    double MeasureKernel(Scene& scene, KnotDeformer::Deformation deformation)
+    {
+        std::vector<double> timings;
+
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            KnotDeformer::Deform(deformation, 0.1f * frame, 1.0f, scene.rest, scene.indices, scene.pose, 0, KNOT_COUNT);
+            const auto end = std::chrono::steady_clock::now();
+            timings.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        return Median(timings);
+    }
+
+    // Median milliseconds of the parallel deformation with write back and of the parallel re-solve of all curves
+    void MeasureFrame(Scene& scene, KnotDeformer::Deformation deformation, double& deform, double& solve)
+    {
+        std::vector<int> jobs;
+
+        for (int first = 0; first < KNOT_COUNT; first += KNOTS_PER_JOB)
+        {
+            jobs.push_back(first);
+        }
+
+        std::vector<double> deformTimings;
+        std::vector<double> solveTimings;
+
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+            const float time = 0.1f * frame;
+            const auto start = std::chrono::steady_clock::now();
+
+            JobSystem::Instance().Map(jobs, [&scene, deformation, time](int first) {
+                const int count = std::min(KNOTS_PER_JOB, KNOT_COUNT - first);
+                KnotDeformer::Deform(deformation, time, 1.0f, scene.rest, scene.indices, scene.pose, first, count);
+
+                for (int i = first; i < first + count; ++i)
+                {
+                    scene.knots[i]->SetPosition(scene.pose.x[i], scene.pose.y[i], scene.pose.z[i]);
+                }
+            });
+
+            for (const auto& curve : scene.curves)
+            {
+                curve->MakeDirty();
+            }
+
+            const auto middle = std::chrono::steady_clock::now();
+            SplineGeometry::UpdateBatch(scene.geometries);
+            const auto end = std::chrono::steady_clock::now();
+
+            deformTimings.push_back(std::chrono::duration<double, std::milli>(middle - start).count());
+            solveTimings.push_back(std::chrono::duration<double, std::milli>(end - middle).count());
+        }
+
+        deform = Median(deformTimings);
+        solve = Median(solveTimings);
+    }
+}
+
+int main()
+{
+    Scene scene;
+    CreateScene(scene);
+
+    const struct
+    {
+        const char* name;
+        KnotDeformer::Deformation deformation;
+    } cases[] = {
+        { "Wave", KnotDeformer::Deformation::Wave },
+        { "Spiral", KnotDeformer::Deformation::Spiral },
+    };
+
+    std::printf("%d curves x %d knots, %d threads\n\n", CURVE_COUNT, KNOTS_PER_CURVE, QThread::idealThreadCount());
+    std::printf("%-8s %8s %16s %16s %16s %12s\n", "Type", "SIMD", "Kernel (ms)", "Deform (ms)", "Re-solve (ms)", "Frames / s");
+
+    for (const auto& benchmark : cases)
+    {
+        for (const bool simd : { false, true })
+        {
+            KnotDeformer::SetSimdEnabled(simd);
+
+            double deform = 0.0;
+            double solve = 0.0;
+            const double kernel = MeasureKernel(scene, benchmark.deformation);
+            MeasureFrame(scene, benchmark.deformation, deform, solve);
+
+            std::printf("%-8s %8s %16.3f %16.3f %16.3f %12.1f\n", benchmark.name, simd ? "On" : "Off", kernel, deform, solve, 1000.0 / (deform + solve));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "Curve/SplineEvaluator.h"
+
+#include <QVector>
+#include <QVector3D>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace BSplineRenderer;
+
+namespace
+{
+    QVector<QVector3D> CreatePatches(int count)
+    {
+        QVector<QVector3D> points;
+        points.reserve(4 * count);
+
+        for (int i = 0; i < 4 * count; ++i)
+        {
+            const float t = 0.1f * i;
+            points << QVector3D(5.0f * std::cos(t), 0.01f * i, 5.0f * std::sin(t));
+        }
+
+        return points;
+    }
+
+    // Median evaluations per second of EvaluateUniform
+    double Measure(const QVector<QVector3D>& points, const std::vector<float>& t, int outputs)
+    {
+        constexpr int REPETITIONS = 15;
+
+        const int patchCount = points.size() / 4;
+        SplineSamples samples;
+        std::vector<double> timings;
+
+        for (int i = 0; i < REPETITIONS; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            SplineEvaluator::EvaluateUniform(points.constData(), patchCount, t.data(), t.size(), samples, outputs);
+            const auto end = std::chrono::steady_clock::now();
+            timings.push_back(std::chrono::duration<double>(end - start).count());
+        }
+
+        std::nth_element(timings.begin(), timings.begin() + timings.size() / 2, timings.end());
+
+        return samples.count / timings[timings.size() / 2];
+    }
+
+    // Largest difference between the vectorized and the scalar kernel
+    float Compare(const QVector<QVector3D>& points, const std::vector<float>& t)
+    {
+        const int outputs = SplineEvaluator::POSITION | SplineEvaluator::FIRST_DERIVATIVE | SplineEvaluator::FRAME;
+        SplineSamples simd;
+        SplineSamples scalar;
+
+        SplineEvaluator::SetSimdEnabled(true);
+        SplineEvaluator::EvaluateUniform(points.constData(), points.size() / 4, t.data(), t.size(), simd, outputs);
+        SplineEvaluator::SetSimdEnabled(false);
+        SplineEvaluator::EvaluateUniform(points.constData(), points.size() / 4, t.data(), t.size(), scalar, outputs);
+
+        float error = 0.0f;
+
+        for (int i = 0; i < simd.count; ++i)
+        {
+            error = std::max(error, (simd.position.At(i) - scalar.position.At(i)).length());
+            error = std::max(error, (simd.tangent.At(i) - scalar.tangent.At(i)).length());
+            error = std::max(error, (simd.normal.At(i) - scalar.normal.At(i)).length());
+        }
+
+        return error;
+    }
+}
+
+int main()
+{
+    constexpr int PATCH_COUNT = 1 << 14;
+    constexpr int SAMPLES_PER_PATCH = 64;
+
+    const QVector<QVector3D> points = CreatePatches(PATCH_COUNT);
+
+    std::vector<float> t(SAMPLES_PER_PATCH);
+
+    for (int i = 0; i < SAMPLES_PER_PATCH; ++i)
+    {
+        t[i] = i / float(SAMPLES_PER_PATCH - 1);
+    }
+
+    const struct
+    {
+        const char* name;
+        int outputs;
+    } cases[] = {
+        { "Position", SplineEvaluator::POSITION },
+        { "Position + Derivatives", SplineEvaluator::POSITION | SplineEvaluator::FIRST_DERIVATIVE | SplineEvaluator::SECOND_DERIVATIVE },
+        { "Position + Frame", SplineEvaluator::POSITION | SplineEvaluator::FRAME },
+    };
+
+    std::printf("%d patches x %d samples, single thread\n\n", PATCH_COUNT, SAMPLES_PER_PATCH);
+    std::printf("%-24s %8s %16s\n", "Outputs", "Kernel", "M Evals / s");
+
+    for (const auto& benchmark : cases)
+    {
+        for (const bool simd : { false, true })
+        {
+            SplineEvaluator::SetSimdEnabled(simd);
+            const double rate = Measure(points, t, benchmark.outputs);
+            std::printf("%-24s %8s %16.1f\n", benchmark.name, SplineEvaluator::GetKernelName(), rate / 1e6);
+        }
+    }
+
+    std::printf("\nMax. difference between the kernels: %.3e\n", Compare(points, t));
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "Curve/KnotDeformer.h"
+#include "Curve/SplineGeometry.h"
+#include "Util/Frustum.h"
+#include "Util/JobSystem.h"
+#include "Util/TaskGraph.h"
+
+#include <QMatrix4x4>
+#include <QThread>
+#include <QVector>
+#include <QVector3D>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace BSplineRenderer;
+
+namespace
+{
+    constexpr int CURVE_COUNT = 1 << 12;
+    constexpr int KNOTS_PER_CURVE = 64;
+    constexpr int KNOT_COUNT = CURVE_COUNT * KNOTS_PER_CURVE;
+    constexpr int KNOTS_PER_JOB = 1 << 14;
+    constexpr int CURVES_PER_JOB = 256;
+    constexpr int WARM_UP_FRAMES = 3;
+    constexpr int FRAMES = 20;
+
+    // The frame of the application without OpenGL: a Wave animation, the re-solve, then culling and statistics
+    struct Scene
+    {
+        std::vector<std::unique_ptr<SplineGeometry>> curves;
+        QVector<SplineGeometry*> geometries;
+        SampleArray rest;
+        SampleArray pose;
+        std::vector<float> indices;
+        std::vector<KnotPtr> knots;
+
+        QMatrix4x4 viewProjection;
+        float time{ 0.0f };
+        std::atomic<int> visibleCount{ 0 };
+        std::atomic<int> patchCount{ 0 };
+    };
+
+    // Helices on a grid, the camera sees about half of them
+    void CreateScene(Scene& scene)
+    {
+        scene.rest.Resize(KNOT_COUNT);
+        scene.pose.Resize(KNOT_COUNT);
+
+        for (int c = 0; c < CURVE_COUNT; ++c)
+        {
+            auto curve = std::make_unique<SplineGeometry>();
+            const QVector3D origin(4.0f * (c % 64) - 128.0f, 4.0f * (c / 64) - 128.0f, 0.0f);
+
+            for (int i = 0; i < KNOTS_PER_CURVE; ++i)
+            {
+                const float t = 0.4f * i;
+                const int index = scene.knots.size();
+                const QVector3D position = origin + QVector3D(std::cos(t), std::sin(t), -0.25f * i);
+
+                scene.rest.x[index] = position.x();
+                scene.rest.y[index] = position.y();
+                scene.rest.z[index] = position.z();
+                scene.indices.push_back(i);
+                scene.knots.push_back(curve->AddKnot(position));
+            }
+
+            scene.geometries << curve.get();
+            scene.curves.push_back(std::move(curve));
+        }
+
+        SplineGeometry::UpdateBatch(scene.geometries);
+
+        QMatrix4x4 view;
+        view.lookAt(QVector3D(-64.0f, -64.0f, 120.0f), QVector3D(-64.0f, -64.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f));
+
+        scene.viewProjection.perspective(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+        scene.viewProjection *= view;
+    }
+
+    void CreateTasks(Scene& scene, TaskGraph& graph)
+    {
+        const int deform = graph.AddTask("Deform", [&scene]() {
+            JobSystem::Instance().ParallelFor(KNOT_COUNT, KNOTS_PER_JOB, [&scene](int first, int count) {
+                KnotDeformer::Deform(KnotDeformer::Deformation::Wave, scene.time, 1.0f, scene.rest, scene.indices, scene.pose, first, count);
+
+                for (int i = first; i < first + count; ++i)
+                {
+                    scene.knots[i]->SetPosition(scene.pose.x[i], scene.pose.y[i], scene.pose.z[i]);
+                }
+            });
+
+            for (const auto& curve : scene.curves)
+            {
+                curve->MakeDirty();
+            }
+        });
+
+        const int solve = graph.AddTask("Solve", [&scene]() { SplineGeometry::UpdateBatch(scene.geometries); });
+
+        const int culling = graph.AddTask("Culling", [&scene]() {
+            const Frustum frustum(scene.viewProjection);
+            scene.visibleCount = 0;
+
+            JobSystem::Instance().ParallelFor(CURVE_COUNT, CURVES_PER_JOB, [&scene, &frustum](int first, int count) {
+                int visible = 0;
+
+                for (int i = first; i < first + count; ++i)
+                {
+                    const auto [min, max] = scene.curves[i]->GetPatchBounds();
+                    visible += frustum.Intersects(min, max);
+                }
+
+                scene.visibleCount += visible;
+            });
+        });
+
+        const int statistics = graph.AddTask("Statistics", [&scene]() {
+            scene.patchCount = 0;
+
+            JobSystem::Instance().ParallelFor(CURVE_COUNT, CURVES_PER_JOB, [&scene](int first, int count) {
+                int patches = 0;
+
+                for (int i = first; i < first + count; ++i)
+                {
+                    patches += scene.curves[i]->GetPatchCount();
+                    scene.curves[i]->GetTotalLength();
+                }
+
+                scene.patchCount += patches;
+            });
+        });
+
+        graph.AddDependency(solve, deform);
+        graph.AddDependency(culling, solve);
+        graph.AddDependency(statistics, solve);
+    }
+
+    double Median(std::vector<double> timings)
+    {
+        std::nth_element(timings.begin(), timings.begin() + timings.size() / 2, timings.end());
+        return timings[timings.size() / 2];
+    }
+
+    // Median milliseconds of the whole frame and of each task
+    void MeasureFrames(Scene& scene, TaskGraph& graph, double& frame, std::vector<double>& tasks)
+    {
+        std::vector<double> frameTimings;
+        std::vector<std::vector<double>> taskTimings(graph.GetTaskCount());
+
+        for (int i = 0; i < WARM_UP_FRAMES + FRAMES; ++i)
+        {
+            scene.time = 0.05f * i;
+            graph.Run();
+
+            if (i < WARM_UP_FRAMES)
+                continue;
+
+            frameTimings.push_back(graph.GetRunTime());
+
+            for (int task = 0; task < graph.GetTaskCount(); ++task)
+            {
+                taskTimings[task].push_back(graph.GetTaskTime(task));
+            }
+        }
+
+        frame = Median(frameTimings);
+        tasks.clear();
+
+        for (const auto& timings : taskTimings)
+        {
+            tasks.push_back(Median(timings));
+        }
+    }
+}
+
+int main()
+{
+    Scene scene;
+    CreateScene(scene);
+
+    TaskGraph graph;
+    CreateTasks(scene, graph);
+
+    const int maxThreadCount = std::max(1, QThread::idealThreadCount());
+    std::vector<int> threadCounts;
+
+    for (int threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+    {
+        threadCounts.push_back(threadCount);
+    }
+
+    threadCounts.push_back(maxThreadCount);
+
+    std::printf("%d curves x %d knots, up to %d threads\n\n", CURVE_COUNT, KNOTS_PER_CURVE, maxThreadCount);
+    std::printf("%8s %12s", "Threads", "Frame (ms)");
+
+    for (int task = 0; task < graph.GetTaskCount(); ++task)
+    {
+        std::printf(" %12s", graph.GetTaskName(task).c_str());
+    }
+
+    std::printf(" %10s %12s\n", "Speedup", "Efficiency");
+
+    double serialFrame = 0.0;
+
+    for (const int threadCount : threadCounts)
+    {
+        JobSystem::Instance().SetThreadCount(threadCount);
+
+        double frame = 0.0;
+        std::vector<double> tasks;
+        MeasureFrames(scene, graph, frame, tasks);
+
+        if (threadCount == 1)
+            serialFrame = frame;
+
+        std::printf("%8d %12.3f", threadCount, frame);
+
+        for (const double task : tasks)
+        {
+            std::printf(" %12.3f", task);
+        }
+
+        std::printf(" %10.2f %11.0f%%\n", serialFrame / frame, 100.0 * serialFrame / frame / threadCount);
+    }
+
+    std::printf("\n%d of %d curves visible, %d patches\n", scene.visibleCount.load(), CURVE_COUNT, scene.patchCount.load());
+
+    return 0;
+}
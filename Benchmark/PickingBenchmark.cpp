@@ -0,0 +1,155 @@
+#include "Curve/KnotOctree.h"
+#include "Curve/Spline.h"
+
+#include <QVector>
+#include <QVector3D>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+using namespace BSplineRenderer;
+
+namespace
+{
+    constexpr int CURVE_COUNT = 10000;
+    constexpr int KNOTS_PER_CURVE = 1000;
+    constexpr int MOVED_KNOT_COUNT = 100;
+    constexpr int QUERY_COUNT = 1000;
+    constexpr int LINEAR_QUERY_COUNT = 10;
+    constexpr float PICK_RADIUS_SCALE = 3.0f;
+    constexpr float SCENE_SIZE = 1000.0f;
+
+    double Milliseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // What EventHandler did before the octree, over all curves instead of the selected one
+    KnotPtr ScanClosestKnot(const QVector<SplinePtr>& curves, const QVector3D& origin, const QVector3D& direction)
+    {
+        float best = std::numeric_limits<float>::infinity();
+        KnotPtr closest = nullptr;
+
+        for (const auto& curve : curves)
+        {
+            for (const auto& knot : curve->GetKnots())
+            {
+                const QVector3D difference = curve->MapToWorld(knot->GetPosition()) - origin;
+                const float t = QVector3D::dotProduct(difference, direction);
+                const float distance = (difference - t * direction).length();
+
+                if (t >= 0.0f && distance < best && distance < PICK_RADIUS_SCALE * curve->GetRadius())
+                {
+                    best = distance;
+                    closest = knot;
+                }
+            }
+        }
+
+        return closest;
+    }
+}
+
+int main()
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> uniform(-0.5f * SCENE_SIZE, 0.5f * SCENE_SIZE);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+
+    // Random walks scattered over the scene
+    QVector<SplinePtr> curves;
+    QVector<SplineGeometry*> geometries;
+    QVector<QVector3D> positions(KNOTS_PER_CURVE);
+
+    for (int c = 0; c < CURVE_COUNT; ++c)
+    {
+        QVector3D position(uniform(generator), uniform(generator), uniform(generator));
+
+        for (int i = 0; i < KNOTS_PER_CURVE; ++i)
+        {
+            position += QVector3D(step(generator), step(generator), step(generator));
+            positions[i] = position;
+        }
+
+        auto curve = std::make_shared<Spline>();
+        curve->AddKnots(positions.constData(), KNOTS_PER_CURVE);
+        geometries << curve.get();
+        curves << curve;
+    }
+
+    SplineGeometry::UpdateBatch(geometries);
+
+    std::printf("%d curves x %d knots\n\n", CURVE_COUNT, KNOTS_PER_CURVE);
+
+    KnotOctree octree;
+
+    auto start = std::chrono::steady_clock::now();
+    octree.Update(curves);
+    std::printf("%-28s %10.3f ms\n", "Build", Milliseconds(start));
+
+    start = std::chrono::steady_clock::now();
+    octree.Update(curves);
+    std::printf("%-28s %10.3f ms\n", "Update, nothing moved", Milliseconds(start));
+
+    for (int i = 0; i < MOVED_KNOT_COUNT; ++i)
+    {
+        const SplinePtr& curve = curves[generator() % CURVE_COUNT];
+        const KnotPtr& knot = curve->GetKnots()[generator() % KNOTS_PER_CURVE];
+        knot->SetPosition(knot->GetPosition() + 10.0f * QVector3D(step(generator), step(generator), step(generator)));
+        curve->MakeKnotDirty(knot);
+        curve->Update();
+    }
+
+    start = std::chrono::steady_clock::now();
+    octree.Update(curves);
+    std::printf("%-28s %10.3f ms, %d moved between leaves\n", "Update, 100 knots moved", Milliseconds(start), octree.GetMoveCount());
+
+    // Rays from outside the scene through random knots, as if the mouse was over them
+    const QVector3D origin(0.0f, 0.0f, SCENE_SIZE);
+    std::vector<QVector3D> directions;
+
+    for (int i = 0; i < QUERY_COUNT; ++i)
+    {
+        const SplinePtr& curve = curves[generator() % CURVE_COUNT];
+        const QVector3D target = curve->MapToWorld(curve->GetKnots()[generator() % KNOTS_PER_CURVE]->GetPosition());
+        directions.push_back((target - origin).normalized());
+    }
+
+    int hitCount = 0;
+    start = std::chrono::steady_clock::now();
+
+    for (const auto& direction : directions)
+    {
+        KnotHit hit;
+        hitCount += octree.IntersectRay(origin, direction, PICK_RADIUS_SCALE, hit);
+    }
+
+    std::printf("%-28s %10.4f ms, %d of %d hit\n", "Ray query", Milliseconds(start) / QUERY_COUNT, hitCount, QUERY_COUNT);
+
+    int mismatchCount = 0;
+    start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < LINEAR_QUERY_COUNT; ++i)
+    {
+        KnotHit hit;
+        octree.IntersectRay(origin, directions[i], PICK_RADIUS_SCALE, hit);
+        mismatchCount += ScanClosestKnot(curves, origin, directions[i]) != hit.knot;
+    }
+
+    std::printf("%-28s %10.4f ms, %d mismatches\n", "Linear scan", Milliseconds(start) / LINEAR_QUERY_COUNT, mismatchCount);
+
+    int knotCount = 0;
+    start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < QUERY_COUNT; ++i)
+    {
+        const SplinePtr& curve = curves[i % CURVE_COUNT];
+        knotCount += octree.QueryRadius(curve->MapToWorld(curve->GetKnots().front()->GetPosition()), 5.0f).size();
+    }
+
+    std::printf("%-28s %10.4f ms, %.1f knots each\n", "Radius query", Milliseconds(start) / QUERY_COUNT, double(knotCount) / QUERY_COUNT);
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "Curve/RopeSimulation.h"
+#include "Curve/SplineGeometry.h"
+#include "Util/JobSystem.h"
+
+#include <QThread>
+#include <QVector>
+#include <QVector3D>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace BSplineRenderer;
+
+namespace
+{
+    constexpr int CABLE_COUNT = 1 << 12;
+    constexpr int KNOTS_PER_CABLE = 64;
+    constexpr int KNOT_COUNT = CABLE_COUNT * KNOTS_PER_CABLE;
+    constexpr int KNOTS_PER_JOB = 1 << 14;
+    constexpr int FRAMES = 30;
+
+    struct Scene
+    {
+        std::vector<std::unique_ptr<SplineGeometry>> cables;
+        QVector<SplineGeometry*> geometries;
+        std::vector<KnotPtr> knots;
+        RopeSimulation rope;
+    };
+
+    // Straight horizontal cables on a grid, pinned at both ends
+    void CreateScene(Scene& scene)
+    {
+        QVector<QVector3D> positions(KNOTS_PER_CABLE);
+
+        for (int c = 0; c < CABLE_COUNT; ++c)
+        {
+            auto cable = std::make_unique<SplineGeometry>();
+
+            for (int i = 0; i < KNOTS_PER_CABLE; ++i)
+            {
+                positions[i] = QVector3D(0.25f * i, 0.5f * (c / 64), 0.5f * (c % 64));
+                scene.knots.push_back(cable->AddKnot(positions[i]));
+            }
+
+            const int first = scene.rope.AddRope(positions.constData(), KNOTS_PER_CABLE);
+            scene.rope.SetPinned(first, true);
+            scene.rope.SetPinned(first + KNOTS_PER_CABLE - 1, true);
+
+            scene.geometries << cable.get();
+            scene.cables.push_back(std::move(cable));
+        }
+
+        SplineGeometry::UpdateBatch(scene.geometries);
+    }
+
+    double Median(std::vector<double> timings)
+    {
+        std::nth_element(timings.begin(), timings.begin() + timings.size() / 2, timings.end());
+        return timings[timings.size() / 2];
+    }
+
+    // Median milliseconds of one 60 Hz frame split into the simulation, the write back to the knots and the re-solve
+    void MeasureFrame(Scene& scene, double& simulate, double& write, double& solve)
+    {
+        std::vector<int> jobs;
+
+        for (int first = 0; first < KNOT_COUNT; first += KNOTS_PER_JOB)
+        {
+            jobs.push_back(first);
+        }
+
+        std::vector<double> simulateTimings;
+        std::vector<double> writeTimings;
+        std::vector<double> solveTimings;
+
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            scene.rope.Advance(1.0f / 60.0f);
+            const auto simulated = std::chrono::steady_clock::now();
+
+            JobSystem::Instance().Map(jobs, [&scene](int first) {
+                const SampleArray& positions = scene.rope.GetPositions();
+                const int count = std::min(KNOTS_PER_JOB, KNOT_COUNT - first);
+
+                for (int i = first; i < first + count; ++i)
+                {
+                    scene.knots[i]->SetPosition(positions.x[i], positions.y[i], positions.z[i]);
+                }
+            });
+
+            for (const auto& cable : scene.cables)
+            {
+                cable->MakeDirty();
+            }
+
+            const auto written = std::chrono::steady_clock::now();
+            SplineGeometry::UpdateBatch(scene.geometries);
+            const auto end = std::chrono::steady_clock::now();
+
+            simulateTimings.push_back(std::chrono::duration<double, std::milli>(simulated - start).count());
+            writeTimings.push_back(std::chrono::duration<double, std::milli>(written - simulated).count());
+            solveTimings.push_back(std::chrono::duration<double, std::milli>(end - written).count());
+        }
+
+        simulate = Median(simulateTimings);
+        write = Median(writeTimings);
+        solve = Median(solveTimings);
+    }
+}
+
+int main()
+{
+    Scene scene;
+    CreateScene(scene);
+
+    const RopeParameters& parameters = scene.rope.GetParameters();
+
+    std::printf("%d cables x %d knots, %d threads, %.0f Hz steps, %d iterations\n\n", CABLE_COUNT, KNOTS_PER_CABLE, QThread::idealThreadCount(),
+                1.0f / parameters.timeStep, parameters.iterations);
+    std::printf("%16s %16s %16s %12s\n", "Simulate (ms)", "Write (ms)", "Re-solve (ms)", "Frames / s");
+
+    double simulate = 0.0;
+    double write = 0.0;
+    double solve = 0.0;
+    MeasureFrame(scene, simulate, write, solve);
+
+    std::printf("%16.3f %16.3f %16.3f %12.1f\n", simulate, write, solve, 1000.0 / (simulate + write + solve));
+
+    return 0;
+}
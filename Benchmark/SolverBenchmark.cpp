@@ -0,0 +1,76 @@
+#include "Curve/Knot.h"
+#include "Curve/SplineSolver.h"
+
+#include <QVector>
+#include <QVector3D>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace BSplineRenderer;
+
+namespace
+{
+    QVector<KnotPtr> CreateKnots(int count)
+    {
+        QVector<KnotPtr> knots;
+        knots.reserve(count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const float t = 0.1f * i;
+            knots << std::make_shared<Knot>(5.0f * std::cos(t), 0.01f * i, 5.0f * std::sin(t));
+        }
+
+        return knots;
+    }
+
+    // Largest violation of D(i-1) + 4 D(i) + D(i+1) = 6 P(i) over the interior rows
+    float ComputeResidual(const QVector<KnotPtr>& knots, const QVector<QVector3D>& controlPoints)
+    {
+        float residual = 0.0f;
+
+        for (int i = 1; i < knots.size() - 1; ++i)
+        {
+            const QVector3D lhs = controlPoints[i - 1] + 4.0f * controlPoints[i] + controlPoints[i + 1];
+            residual = std::max(residual, (lhs - 6.0f * knots[i]->GetPosition()).length());
+        }
+
+        return residual;
+    }
+}
+
+int main()
+{
+    constexpr int MAX_KNOTS = 1 << 20;
+
+    std::printf("%12s %14s %14s %14s\n", "# of Knots", "Median (us)", "ns / Knot", "Residual");
+
+    for (int count = 4; count <= MAX_KNOTS; count *= 4)
+    {
+        const QVector<KnotPtr> knots = CreateKnots(count);
+        QVector<QVector3D> controlPoints;
+
+        // Keep the total amount of work per row roughly constant
+        const int repetitions = std::clamp(MAX_KNOTS / count, 5, 10000);
+        std::vector<double> timings;
+        timings.reserve(repetitions);
+
+        for (int i = 0; i < repetitions; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            SplineSolver::Solve(knots, controlPoints);
+            const auto end = std::chrono::steady_clock::now();
+            timings.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        std::nth_element(timings.begin(), timings.begin() + timings.size() / 2, timings.end());
+        const double median = timings[timings.size() / 2];
+
+        std::printf("%12d %14.3f %14.3f %14.3e\n", count, median, 1000.0 * median / count, ComputeResidual(knots, controlPoints));
+    }
+
+    return 0;
+}
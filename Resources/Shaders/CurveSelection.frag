@@ -2,12 +2,11 @@
 
 in vec3 fs_Position;
 in vec3 fs_Normal;
-
-uniform int curveIndex;
+flat in int fs_CurveIndex;
 
 layout(location = 0) out ivec4 out_CurveInfo;
 
 void main()
 {
-    out_CurveInfo = ivec4(curveIndex, 0, 0, 1);
+    out_CurveInfo = ivec4(fs_CurveIndex, 0, 0, 1);
 }
@@ -0,0 +1,32 @@
+#version 450 core
+
+flat in vec3 fs_A;
+flat in vec3 fs_B;
+flat in float fs_Radius;
+flat in int fs_CurveIndex;
+in vec4 fs_Near;
+in vec4 fs_Far;
+
+layout(location = 0) out ivec4 out_CurveInfo;
+
+#include "Impostor.glsl"
+
+void main()
+{
+    vec3 origin;
+    vec3 direction;
+    GetViewRay(fs_Near, fs_Far, origin, direction);
+
+    float t = IntersectCapsule(origin, direction, fs_A, fs_B, fs_Radius);
+
+    if (t < 0.0)
+    {
+        discard;
+    }
+
+    vec3 position = origin + t * direction;
+
+    WriteDepth(position);
+
+    out_CurveInfo = ivec4(fs_CurveIndex, 0, 0, 1);
+}
@@ -0,0 +1,71 @@
+// Ray casting of the impostors on their screen aligned quads, included by their fragment shaders
+
+// The quad is at the nearest depth of the impostor
+layout(depth_greater) out float gl_FragDepth;
+
+// World space ray through the fragment from the homogeneous points on the near and the far plane
+void GetViewRay(vec4 near, vec4 far, out vec3 origin, out vec3 direction)
+{
+    origin = near.xyz / near.w;
+    direction = normalize(far.xyz / far.w - origin);
+}
+
+// Distance along the ray to the sphere, negative if it is missed
+float IntersectSphere(vec3 origin, vec3 direction, vec3 center, float radius)
+{
+    vec3 oc = origin - center;
+    float b = dot(direction, oc);
+    float h = b * b - dot(oc, oc) + radius * radius;
+    return h < 0.0 ? -1.0 : -b - sqrt(h);
+}
+
+// Distance along the ray to the capsule, negative if it is missed
+float IntersectCapsule(vec3 origin, vec3 direction, vec3 a, vec3 b, float radius)
+{
+    vec3 ba = b - a;
+    vec3 oa = origin - a;
+    float baba = dot(ba, ba);
+    float bard = dot(ba, direction);
+    float baoa = dot(ba, oa);
+
+    // The infinite cylinder, unless the ray runs along the axis
+    float k2 = baba - bard * bard;
+
+    if (k2 > 1e-6 * baba)
+    {
+        float k1 = baba * dot(oa, direction) - baoa * bard;
+        float k0 = baba * dot(oa, oa) - baoa * baoa - radius * radius * baba;
+        float h = k1 * k1 - k2 * k0;
+
+        if (h < 0.0)
+        {
+            return -1.0;
+        }
+
+        float t = (-k1 - sqrt(h)) / k2;
+        float y = baoa + t * bard;
+
+        if (0.0 < y && y < baba)
+        {
+            return t;
+        }
+    }
+
+    // The caps
+    float ta = IntersectSphere(origin, direction, a, radius);
+    float tb = IntersectSphere(origin, direction, b, radius);
+
+    if (ta < 0.0 || tb < 0.0)
+    {
+        return max(ta, tb);
+    }
+
+    return min(ta, tb);
+}
+
+// Depth of the hit instead of the quad's
+void WriteDepth(vec3 position)
+{
+    vec4 clip = viewProjectionMatrix * vec4(position, 1.0);
+    gl_FragDepth = 0.5 * clip.z / clip.w + 0.5;
+}
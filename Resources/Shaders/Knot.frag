@@ -0,0 +1,26 @@
+#version 450 core
+
+uniform float ambient;
+uniform float diffuse;
+
+in vec3 fs_Normal;
+flat in int fs_State;
+
+layout(location = 0) out vec4 out_Color;
+
+// KnotRenderer::State
+const int SELECTED = 2;
+
+void main()
+{
+    vec4 color = fs_State == SELECTED ? vec4(0.0, 1.0, 0.0, 1.0) : vec4(1.0, 1.0, 0.0, 1.0);
+
+    // Ambient
+    float ambientTerm = light.ambient * ambient;
+
+    // Diffuse
+    float diffuseTerm = max(dot(fs_Normal, -light.direction), 0.0) * light.diffuse * diffuse;
+
+    // Combine
+    out_Color = (ambientTerm + diffuseTerm) * color * light.color;
+}
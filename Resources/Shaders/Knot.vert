@@ -0,0 +1,22 @@
+#version 450 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+// Per instance: world position and scale of the knot, and its highlight state
+layout(location = 2) in vec4 knot;
+layout(location = 3) in int state;
+
+// KnotRenderer::HIGHLIGHT_SCALE, highlighted knots are drawn larger
+const float HIGHLIGHT_SCALE = 1.25;
+
+out vec3 fs_Normal;
+flat out int fs_State;
+
+void main()
+{
+    float scale = state != 0 ? HIGHLIGHT_SCALE * knot.w : knot.w;
+    fs_Normal = normal;
+    fs_State = state;
+    gl_Position = viewProjectionMatrix * vec4(knot.xyz + scale * position, 1.0);
+}
@@ -0,0 +1,47 @@
+#version 450 core
+
+uniform float ambient;
+uniform float diffuse;
+
+flat in vec3 fs_Center;
+flat in float fs_Radius;
+flat in int fs_State;
+in vec4 fs_Near;
+in vec4 fs_Far;
+
+layout(location = 0) out vec4 out_Color;
+
+// KnotRenderer::State
+const int SELECTED = 2;
+
+#include "Impostor.glsl"
+
+void main()
+{
+    vec3 origin;
+    vec3 direction;
+    GetViewRay(fs_Near, fs_Far, origin, direction);
+
+    float t = IntersectSphere(origin, direction, fs_Center, fs_Radius);
+
+    if (t < 0.0)
+    {
+        discard;
+    }
+
+    vec3 position = origin + t * direction;
+    vec3 normal = (position - fs_Center) / fs_Radius;
+
+    WriteDepth(position);
+
+    vec4 color = fs_State == SELECTED ? vec4(0.0, 1.0, 0.0, 1.0) : vec4(1.0, 1.0, 0.0, 1.0);
+
+    // Ambient
+    float ambientTerm = light.ambient * ambient;
+
+    // Diffuse
+    float diffuseTerm = max(dot(normal, -light.direction), 0.0) * light.diffuse * diffuse;
+
+    // Combine
+    out_Color = (ambientTerm + diffuseTerm) * color * light.color;
+}
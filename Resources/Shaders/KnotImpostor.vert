@@ -0,0 +1,64 @@
+#version 450 core
+
+// Per instance: world position and scale of the knot, and its highlight state
+layout(location = 2) in vec4 knot;
+layout(location = 3) in int state;
+
+// KnotRenderer::HIGHLIGHT_SCALE, highlighted knots are drawn larger
+const float HIGHLIGHT_SCALE = 1.25;
+
+// Triangle strip of a quad
+const vec2 CORNERS[4] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1), vec2(1, 1));
+
+flat out vec3 fs_Center;
+flat out float fs_Radius;
+flat out int fs_State;
+
+// Homogeneous points on the near and the far plane, divided per fragment
+out vec4 fs_Near;
+out vec4 fs_Far;
+
+void main()
+{
+    float radius = state != 0 ? HIGHLIGHT_SCALE * knot.w : knot.w;
+
+    // Screen space bounds of the cube around the sphere, the whole screen if it reaches behind the camera
+    vec2 minimum = vec2(1.0);
+    vec2 maximum = vec2(-1.0);
+    float depth = 1.0;
+    bool behind = false;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = knot.xyz + radius * vec3((i & 1) != 0 ? 1 : -1, (i & 2) != 0 ? 1 : -1, (i & 4) != 0 ? 1 : -1);
+        vec4 clip = viewProjectionMatrix * vec4(corner, 1.0);
+
+        if (clip.w <= 0.0)
+        {
+            behind = true;
+            break;
+        }
+
+        vec3 ndc = clip.xyz / clip.w;
+        minimum = min(minimum, ndc.xy);
+        maximum = max(maximum, ndc.xy);
+        depth = min(depth, ndc.z);
+    }
+
+    if (behind)
+    {
+        minimum = vec2(-1.0);
+        maximum = vec2(1.0);
+        depth = -1.0;
+    }
+
+    // At the nearest depth of the cube, so the fragment shader only ever pushes the depth back
+    vec2 position = mix(max(minimum, vec2(-1.0)), min(maximum, vec2(1.0)), CORNERS[gl_VertexID]);
+    gl_Position = vec4(position, max(depth, -1.0), 1.0);
+
+    fs_Center = knot.xyz;
+    fs_Radius = radius;
+    fs_State = state;
+    fs_Near = inverseViewProjectionMatrix * vec4(position, -1.0, 1.0);
+    fs_Far = inverseViewProjectionMatrix * vec4(position, 1.0, 1.0);
+}
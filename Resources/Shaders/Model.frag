@@ -7,16 +7,7 @@ struct Model
     float diffuse;
 };
 
-struct Light
-{
-    vec4 color;
-    vec3 direction;
-    float ambient;
-    float diffuse;
-};
-
 uniform Model model;
-uniform Light light;
 
 in vec4 fs_Position;
 in vec3 fs_Normal;
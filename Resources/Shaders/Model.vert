@@ -8,7 +8,6 @@ out vec3 fs_Normal;
 
 uniform mat4 modelMatrix;
 uniform mat3 normalMatrix;
-uniform mat4 viewProjectionMatrix;
 
 void main()
 {
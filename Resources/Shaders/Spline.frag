@@ -1,30 +1,15 @@
 #version 450 core
 
-struct Curve
-{
-    vec4 color;
-    float ambient;
-    float diffuse;
-};
-
-struct Light
-{
-    vec4 color;
-    vec3 direction;
-    float ambient;
-    float diffuse;
-};
-
-uniform Curve curve;
-uniform Light light;
-
 in vec3 fs_Position;
 in vec3 fs_Normal;
+flat in int fs_CurveIndex;
 
 layout(location = 0) out vec4 out_Color;
 
 void main()
 {
+    CurveData curve = curves[fs_CurveIndex];
+
     // Ambient
     float ambient = light.ambient * curve.ambient;
 
@@ -33,4 +18,10 @@ void main()
 
     // Combine
     out_Color = (ambient + diffuse) * curve.color * light.color;
+
+    // The curve under the mouse is lightened
+    if (fs_CurveIndex == hoveredCurve)
+    {
+        out_Color = mix(out_Color, vec4(1.0), 0.3);
+    }
 }
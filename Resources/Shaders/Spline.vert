@@ -1,8 +1,17 @@
 #version 450 core
 
 layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+// Per instance, selected by the base instance of the draw command
+layout(location = 2) in uint curveIndex;
+
+out vec3 tcs_Normal;
+out int tcs_CurveIndex;
 
 void main()
 {
     gl_Position = vec4(position, 1.0);
-}
\ No newline at end of file
+    tcs_Normal = normal;
+    tcs_CurveIndex = int(curveIndex);
+}
@@ -0,0 +1,21 @@
+#version 450 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+uniform int curveIndex;
+
+out vec3 fs_Normal;
+out vec3 fs_Position;
+flat out int fs_CurveIndex;
+
+void main()
+{
+    // The mesh is built in model space, the model matrix moves the centerline only
+    CurveData curve = curves[curveIndex];
+    vec3 center = position - curve.radius * normal;
+    fs_Normal = normalize(mat3(curve.normalMatrix) * normal);
+    fs_Position = (curve.modelMatrix * vec4(center, 1.0)).xyz + curve.radius * fs_Normal;
+    fs_CurveIndex = curveIndex;
+    gl_Position = viewProjectionMatrix * vec4(fs_Position, 1.0);
+}
\ No newline at end of file
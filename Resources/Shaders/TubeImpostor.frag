@@ -0,0 +1,50 @@
+#version 450 core
+
+flat in vec3 fs_A;
+flat in vec3 fs_B;
+flat in float fs_Radius;
+flat in int fs_CurveIndex;
+in vec4 fs_Near;
+in vec4 fs_Far;
+
+layout(location = 0) out vec4 out_Color;
+
+#include "Impostor.glsl"
+
+void main()
+{
+    vec3 origin;
+    vec3 direction;
+    GetViewRay(fs_Near, fs_Far, origin, direction);
+
+    float t = IntersectCapsule(origin, direction, fs_A, fs_B, fs_Radius);
+
+    if (t < 0.0)
+    {
+        discard;
+    }
+
+    vec3 position = origin + t * direction;
+    vec3 ba = fs_B - fs_A;
+    float h = clamp(dot(position - fs_A, ba) / max(dot(ba, ba), 1e-12), 0.0, 1.0);
+    vec3 normal = (position - fs_A - h * ba) / fs_Radius;
+
+    WriteDepth(position);
+
+    CurveData curve = curves[fs_CurveIndex];
+
+    // Ambient
+    float ambient = light.ambient * curve.ambient;
+
+    // Diffuse
+    float diffuse = max(dot(normal, -light.direction), 0.0) * light.diffuse * curve.diffuse;
+
+    // Combine
+    out_Color = (ambient + diffuse) * curve.color * light.color;
+
+    // The curve under the mouse is lightened
+    if (fs_CurveIndex == hoveredCurve)
+    {
+        out_Color = mix(out_Color, vec4(1.0), 0.3);
+    }
+}
@@ -0,0 +1,107 @@
+#version 450 core
+
+// Per instance, selected by the base instance of the draw command
+layout(location = 2) in uint curveIndex;
+
+// SplineBufferCache::PatchVertex, a position and a frame normal of three floats each
+layout(std430, binding = 1) readonly buffer PatchBuffer
+{
+    float patchVertices[];
+};
+
+// SplineBufferCache::CAPSULES_PER_PATCH
+const int CAPSULES_PER_PATCH = 4;
+
+// The two triangles of a quad
+const vec2 CORNERS[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(0, 0), vec2(1, 1), vec2(0, 1));
+
+flat out vec3 fs_A;
+flat out vec3 fs_B;
+flat out float fs_Radius;
+flat out int fs_CurveIndex;
+
+// Homogeneous points on the near and the far plane, divided per fragment
+out vec4 fs_Near;
+out vec4 fs_Far;
+
+vec3 GetControlPoint(int point)
+{
+    return vec3(patchVertices[6 * point], patchVertices[6 * point + 1], patchVertices[6 * point + 2]);
+}
+
+vec3 Evaluate(int patchIndex, float t)
+{
+    vec3 p0 = GetControlPoint(4 * patchIndex);
+    vec3 p1 = GetControlPoint(4 * patchIndex + 1);
+    vec3 p2 = GetControlPoint(4 * patchIndex + 2);
+    vec3 p3 = GetControlPoint(4 * patchIndex + 3);
+
+    float u = 1.0 - t;
+    return u * u * u * p0 + 3.0 * u * u * t * p1 + 3.0 * u * t * t * p2 + t * t * t * p3;
+}
+
+void main()
+{
+    int capsule = gl_VertexID / 6;
+    int patchIndex = capsule / CAPSULES_PER_PATCH;
+    float t0 = float(capsule % CAPSULES_PER_PATCH) / CAPSULES_PER_PATCH;
+    float t1 = t0 + 1.0 / CAPSULES_PER_PATCH;
+
+    // The model matrix moves the centerline only, the tube keeps its radius
+    CurveData curve = curves[curveIndex];
+    vec3 a = (curve.modelMatrix * vec4(Evaluate(patchIndex, t0), 1.0)).xyz;
+    vec3 b = (curve.modelMatrix * vec4(Evaluate(patchIndex, t1), 1.0)).xyz;
+    float radius = curve.radius;
+
+    // Box around the capsule, aligned with its axis
+    vec3 axis = b - a;
+    float axisLength = length(axis);
+    vec3 u = axisLength > 1e-6 ? axis / axisLength : vec3(1, 0, 0);
+    vec3 v = normalize(cross(u, abs(u.x) < 0.9 ? vec3(1, 0, 0) : vec3(0, 1, 0)));
+    vec3 w = cross(u, v);
+    vec3 center = 0.5 * (a + b);
+    u *= 0.5 * axisLength + radius;
+    v *= radius;
+    w *= radius;
+
+    // Screen space bounds of the box, the whole screen if it reaches behind the camera
+    vec2 minimum = vec2(1.0);
+    vec2 maximum = vec2(-1.0);
+    float depth = 1.0;
+    bool behind = false;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = center + ((i & 1) != 0 ? u : -u) + ((i & 2) != 0 ? v : -v) + ((i & 4) != 0 ? w : -w);
+        vec4 clip = viewProjectionMatrix * vec4(corner, 1.0);
+
+        if (clip.w <= 0.0)
+        {
+            behind = true;
+            break;
+        }
+
+        vec3 ndc = clip.xyz / clip.w;
+        minimum = min(minimum, ndc.xy);
+        maximum = max(maximum, ndc.xy);
+        depth = min(depth, ndc.z);
+    }
+
+    if (behind)
+    {
+        minimum = vec2(-1.0);
+        maximum = vec2(1.0);
+        depth = -1.0;
+    }
+
+    // At the nearest depth of the box, so the fragment shader only ever pushes the depth back
+    vec2 position = mix(max(minimum, vec2(-1.0)), min(maximum, vec2(1.0)), CORNERS[gl_VertexID % 6]);
+    gl_Position = vec4(position, max(depth, -1.0), 1.0);
+
+    fs_A = a;
+    fs_B = b;
+    fs_Radius = radius;
+    fs_CurveIndex = int(curveIndex);
+    fs_Near = inverseViewProjectionMatrix * vec4(position, -1.0, 1.0);
+    fs_Far = inverseViewProjectionMatrix * vec4(position, 1.0, 1.0);
+}
@@ -0,0 +1,387 @@
+#include "AnimationCache.h"
+
+#include "Curve/SplineGeometry.h"
+
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+// The file is written and mapped in the byte order of the host, all supported targets are little endian
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN);
+static_assert(sizeof(QVector3D) == 3 * sizeof(float));
+
+namespace
+{
+    using namespace BSplineRenderer;
+
+    constexpr quint64 RECORD_ALIGNMENT = 16;
+    constexpr float NORMAL_SCALE = 32767.0f;
+
+    // Normals decoded by Apply(), one buffer per thread reused by every frame
+    thread_local QVector<QVector3D> tDecodedNormals;
+
+    quint64 Align(quint64 offset)
+    {
+        return (offset + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+    }
+
+    // Same patch count as SplineGeometry: one patch for a single knot, one per pair of knots otherwise
+    quint64 GetPatchCount(quint64 knotCount)
+    {
+        return knotCount == 0 ? 0 : std::max<quint64>(1, knotCount - 1);
+    }
+
+    quint64 GetControlPointCount(quint64 knotCount)
+    {
+        return knotCount >= 4 ? knotCount : 0;
+    }
+
+    quint64 GetNormalCount(quint64 knotCount)
+    {
+        return SplineGeometry::NUM_OF_PATCH_POINTS * GetPatchCount(knotCount);
+    }
+
+    quint64 GetRecordSize(quint64 knotCount)
+    {
+        const quint64 points = (knotCount + GetControlPointCount(knotCount)) * sizeof(QVector3D);
+        return Align(points + 3 * GetNormalCount(knotCount) * sizeof(qint16));
+    }
+
+    // FNV-1a
+    class Hash
+    {
+      public:
+        void Add(const void* data, size_t size)
+        {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                mValue = (mValue ^ bytes[i]) * 0x100000001b3ull;
+            }
+        }
+
+        template <typename T>
+        void Add(const T& value)
+        {
+            Add(&value, sizeof(T));
+        }
+
+        void Add(const KeyframeTrack& track)
+        {
+            Add(int(track.GetKeys().size()));
+            Add(track.GetKeys().constData(), track.GetKeys().size() * sizeof(Keyframe));
+        }
+
+        quint64 GetValue() const { return mValue; }
+
+      private:
+        quint64 mValue{ 0xcbf29ce484222325ull };
+    };
+
+    // Writes the curve as laid out in a frame record
+    void WriteRecord(const SplineGeometry& spline, uchar* record)
+    {
+        const int n = spline.GetKnotCount();
+        auto* points = reinterpret_cast<QVector3D*>(record);
+
+        for (int i = 0; i < n; ++i)
+        {
+            points[i] = spline.GetKnots()[i]->GetPosition();
+        }
+
+        const int controlPointCount = GetControlPointCount(n);
+        std::memcpy(points + n, spline.GetSplineControlPoints().constData(), controlPointCount * sizeof(QVector3D));
+
+        auto* normals = reinterpret_cast<qint16*>(points + n + controlPointCount);
+        const QVector<QVector3D>& frameNormals = spline.GetFrameNormals();
+
+        for (int i = 0; i < frameNormals.size(); ++i)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                normals[3 * i + k] = qint16(std::lround(std::clamp(frameNormals[i][k], -1.0f, 1.0f) * NORMAL_SCALE));
+            }
+        }
+    }
+}
+
+BSplineRenderer::AnimationCache::~AnimationCache()
+{
+    Close();
+}
+
+bool BSplineRenderer::AnimationCache::Bake(const QString& filePath, const BakeInput& input, const ProgressCallback& progress)
+{
+    AnimationCacheHeader header;
+    std::memset(&header, 0, sizeof(AnimationCacheHeader));
+    header.version = VERSION;
+    header.curveCount = input.curves.size();
+    header.frameCount = input.frameCount;
+    header.frameRate = input.frameRate;
+    header.fingerprint = GetFingerprint(input);
+    header.tocOffset = sizeof(AnimationCacheHeader);
+
+    QVector<AnimationCacheCurve> toc(input.curves.size());
+    quint64 offset = 0;
+
+    for (int i = 0; i < input.curves.size(); ++i)
+    {
+        toc[i].curve = input.curves[i].curve;
+        toc[i].knotCount = input.curves[i].count;
+        toc[i].offset = offset;
+        offset += GetRecordSize(toc[i].knotCount);
+    }
+
+    header.frameSize = offset;
+    header.frameOffset = Align(header.tocOffset + toc.size() * sizeof(AnimationCacheCurve));
+    header.fileSize = header.frameOffset + quint64(input.frameCount) * header.frameSize;
+
+    QFile file(filePath);
+
+    if (file.open(QIODevice::ReadWrite | QIODevice::Truncate) == false || file.resize(header.fileSize) == false)
+    {
+        return false;
+    }
+
+    // The frames are written straight into the mapping, or seek and write under a lock if it is not supported
+    uchar* mapping = header.fileSize > 0 ? file.map(0, header.fileSize) : nullptr;
+    std::mutex fileMutex;
+    std::atomic_bool failed{ false };
+    std::atomic_int framesDone{ 0 };
+
+    // Each job owns copies of the curves and bakes a run of consecutive frames
+    const int jobCount = std::clamp(2 * QThread::idealThreadCount(), 1, std::max(1, input.frameCount));
+    std::vector<int> jobs(jobCount);
+
+    for (int i = 0; i < jobCount; ++i)
+    {
+        jobs[i] = i;
+    }
+
+    QtConcurrent::blockingMap(jobs, [&](int job) {
+        const int firstFrame = qint64(input.frameCount) * job / jobCount;
+        const int lastFrame = qint64(input.frameCount) * (job + 1) / jobCount;
+
+        std::vector<std::unique_ptr<SplineGeometry>> splines;
+        QVector<QVector3D> positions;
+
+        for (const auto& curve : input.curves)
+        {
+            positions.resize(curve.count);
+            curve.Evaluate(0.0f, input.rest, positions.data());
+            splines.push_back(std::make_unique<SplineGeometry>());
+            splines.back()->AddKnots(positions.constData(), curve.count);
+        }
+
+        QByteArray buffer(mapping ? 0 : header.frameSize, '\0');
+
+        for (int frame = firstFrame; frame < lastFrame && failed == false; ++frame)
+        {
+            const float time = frame / input.frameRate;
+            uchar* data = mapping ? mapping + header.frameOffset + frame * header.frameSize : reinterpret_cast<uchar*>(buffer.data());
+
+            for (int i = 0; i < input.curves.size(); ++i)
+            {
+                const TimelineCurve& curve = input.curves[i];
+                SplineGeometry& spline = *splines[i];
+
+                positions.resize(curve.count);
+                curve.Evaluate(time, input.rest, positions.data());
+
+                for (int k = 0; k < curve.count; ++k)
+                {
+                    spline.GetKnots()[k]->SetPosition(positions[k]);
+                }
+
+                spline.MakeDirty();
+                spline.Update();
+                WriteRecord(spline, data + toc[i].offset);
+            }
+
+            if (mapping == nullptr)
+            {
+                std::lock_guard<std::mutex> lock(fileMutex);
+
+                if (file.seek(header.frameOffset + frame * header.frameSize) == false || file.write(buffer) != buffer.size())
+                {
+                    failed = true;
+                }
+            }
+
+            if (progress && progress(++framesDone, input.frameCount) == false)
+            {
+                failed = true;
+            }
+        }
+    });
+
+    // The magic is written last, an interrupted bake leaves a file that does not open
+    if (failed == false)
+    {
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        QByteArray block(reinterpret_cast<const char*>(&header), sizeof(AnimationCacheHeader));
+        block.append(reinterpret_cast<const char*>(toc.constData()), toc.size() * sizeof(AnimationCacheCurve));
+
+        if (mapping)
+        {
+            std::memcpy(mapping, block.constData(), block.size());
+        }
+        else if (file.seek(0) == false || file.write(block) != block.size())
+        {
+            failed = true;
+        }
+    }
+
+    if (mapping)
+    {
+        file.unmap(mapping);
+    }
+
+    file.close();
+
+    if (failed)
+    {
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+quint64 BSplineRenderer::AnimationCache::GetFingerprint(const BakeInput& input)
+{
+    Hash hash;
+    hash.Add(VERSION);
+    hash.Add(input.frameCount);
+    hash.Add(input.frameRate);
+
+    for (const auto& curve : input.curves)
+    {
+        hash.Add(curve.curve);
+        hash.Add(curve.count);
+        hash.Add(curve.interpolation);
+        hash.Add(input.rest.x.data() + curve.first, curve.count * sizeof(float));
+        hash.Add(input.rest.y.data() + curve.first, curve.count * sizeof(float));
+        hash.Add(input.rest.z.data() + curve.first, curve.count * sizeof(float));
+        hash.Add(curve.translation);
+
+        for (const auto& [index, track] : curve.knots)
+        {
+            hash.Add(index);
+            hash.Add(track);
+        }
+    }
+
+    return hash.GetValue();
+}
+
+bool BSplineRenderer::AnimationCache::Open(const QString& filePath)
+{
+    Close();
+
+    mFile.setFileName(filePath);
+
+    if (mFile.open(QIODevice::ReadOnly) == false)
+    {
+        return false;
+    }
+
+    const quint64 size = mFile.size();
+
+    if (size < sizeof(AnimationCacheHeader))
+    {
+        Close();
+        return false;
+    }
+
+    // Reading the whole file is the fallback for file systems that do not support mapping
+    const uchar* data = mFile.map(0, size);
+
+    if (data == nullptr)
+    {
+        mContents = mFile.readAll();
+        data = reinterpret_cast<const uchar*>(mContents.constData());
+
+        if (quint64(mContents.size()) != size)
+        {
+            Close();
+            return false;
+        }
+    }
+
+    AnimationCacheHeader header;
+    std::memcpy(&header, data, sizeof(AnimationCacheHeader));
+
+    const bool valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION && header.fileSize == size && //
+                       header.tocOffset <= size && header.curveCount <= (size - header.tocOffset) / sizeof(AnimationCacheCurve) &&     //
+                       header.frameOffset <= size && header.frameOffset % RECORD_ALIGNMENT == 0 && header.frameSize % RECORD_ALIGNMENT == 0 &&
+                       (header.frameSize == 0 || header.frameCount <= (size - header.frameOffset) / header.frameSize) && header.frameRate > 0.0f;
+
+    if (valid == false)
+    {
+        Close();
+        return false;
+    }
+
+    QVector<AnimationCacheCurve> curves(header.curveCount);
+    std::memcpy(curves.data(), data + header.tocOffset, curves.size() * sizeof(AnimationCacheCurve));
+
+    for (const auto& curve : curves)
+    {
+        if (curve.offset % RECORD_ALIGNMENT != 0 || curve.offset > header.frameSize || GetRecordSize(curve.knotCount) > header.frameSize - curve.offset)
+        {
+            Close();
+            return false;
+        }
+    }
+
+    mData = data;
+    mHeader = header;
+    mCurves = curves;
+
+    return true;
+}
+
+void BSplineRenderer::AnimationCache::Close()
+{
+    if (mFile.isOpen())
+    {
+        mFile.close();
+    }
+
+    mContents.clear();
+    mData = nullptr;
+    mHeader = AnimationCacheHeader{};
+    mCurves.clear();
+}
+
+void BSplineRenderer::AnimationCache::Apply(int frame, int curve, SplineGeometry* spline) const
+{
+    const AnimationCacheCurve& entry = mCurves[curve];
+    const uchar* record = mData + mHeader.frameOffset + quint64(frame) * mHeader.frameSize + entry.offset;
+
+    const auto* points = reinterpret_cast<const QVector3D*>(record);
+    const auto* normals = reinterpret_cast<const qint16*>(points + entry.knotCount + GetControlPointCount(entry.knotCount));
+
+    const int normalCount = GetNormalCount(entry.knotCount);
+
+    if (tDecodedNormals.size() < normalCount)
+    {
+        tDecodedNormals.resize(normalCount);
+    }
+
+    QVector3D* decoded = tDecodedNormals.data();
+
+    for (int i = 0; i < normalCount; ++i)
+    {
+        decoded[i] = QVector3D(normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]).normalized();
+    }
+
+    spline->SetBakedState(points, points + entry.knotCount, decoded);
+}
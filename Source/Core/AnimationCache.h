@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Core/CurveData.h"
+#include "Core/Timeline.h"
+#include "Util/Macros.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+namespace BSplineRenderer
+{
+    // Baked timeline (.banim), little endian, in the same spirit as SceneFile:
+    //
+    //   AnimationCacheHeader
+    //   AnimationCacheCurve[curveCount]    Table of contents, at tocOffset
+    //   Frame[frameCount]                  frameSize bytes each, the first at frameOffset
+    //
+    // A frame holds one record per curve at the offset given by its table entry:
+    //
+    //   float[3 * knotCount]               Knot positions
+    //   float[3 * knotCount]               Solved control points, only if there are at least 4 knots
+    //   qint16[3 * 4 * patchCount]         Frame normals as signed normalized integers
+    //
+    // Records are 16-byte aligned. Playback maps the file and copies a frame straight into the curves.
+    struct AnimationCacheHeader
+    {
+        char magic[8];
+        quint32 version;
+        quint32 curveCount;
+        quint32 frameCount;
+        float frameRate;
+        quint64 fingerprint;
+        quint64 tocOffset;
+        quint64 frameOffset;
+        quint64 frameSize;
+        quint64 fileSize;
+    };
+
+    struct AnimationCacheCurve
+    {
+        quint32 curve;
+        quint32 knotCount;
+        quint64 offset;
+    };
+
+    static_assert(sizeof(AnimationCacheHeader) == 64);
+    static_assert(sizeof(AnimationCacheCurve) == 16);
+
+    // What a bake evaluates, copied on the GUI thread so that the scene can keep changing meanwhile
+    struct BakeInput
+    {
+        SampleArray rest;
+        QVector<TimelineCurve> curves;
+        int frameCount{ 0 };
+        float frameRate{ 0.0f };
+    };
+
+    class AnimationCache
+    {
+        DISABLE_COPY(AnimationCache);
+
+      public:
+        AnimationCache() = default;
+        ~AnimationCache();
+
+        // Evaluates, solves and writes every frame of the input. Frames are spread over the thread pool,
+        // the progress is counted in frames and reported from the worker threads. Thread safe.
+        static bool Bake(const QString& filePath, const BakeInput& input, const ProgressCallback& progress = nullptr);
+
+        // Identifies the rest pose, the tracks and the frames of a bake. A cache is only played back
+        // if its fingerprint is that of the current timeline.
+        static quint64 GetFingerprint(const BakeInput& input);
+
+        bool Open(const QString& filePath);
+        void Close();
+
+        bool IsOpen() const { return mData != nullptr; }
+        int GetFrameCount() const { return mHeader.frameCount; }
+        float GetFrameRate() const { return mHeader.frameRate; }
+        quint64 GetFingerprint() const { return mHeader.fingerprint; }
+        const QVector<AnimationCacheCurve>& GetCurves() const { return mCurves; }
+
+        // Sets the spline to the state of entry curve of the table of contents in frame.
+        // The spline must have the knot count of the entry. Thread safe for different splines.
+        void Apply(int frame, int curve, SplineGeometry* spline) const;
+
+        static constexpr quint32 VERSION = 1;
+        static constexpr char MAGIC[8] = { 'B', 'S', 'P', 'L', 'A', 'N', 'M', '\0' };
+        static constexpr const char* EXTENSION = "banim";
+
+      private:
+        QFile mFile;
+        QByteArray mContents;
+        const uchar* mData{ nullptr };
+        AnimationCacheHeader mHeader{};
+        QVector<AnimationCacheCurve> mCurves;
+    };
+}
@@ -0,0 +1,539 @@
+#include "AnimationManager.h"
+
+#include "Util/JobSystem.h"
+#include "Util/Logger.h"
+
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+void BSplineRenderer::AnimationManager::Update(float deltaTime, CurveContainer* container)
+{
+    UpdateBake();
+
+    if (!mEnabled || mAnimationType == AnimationType::None)
+        return;
+
+    if (mAnimationType == AnimationType::Keyframes)
+    {
+        ApplyKeyframes(deltaTime, container);
+        return;
+    }
+
+    if (mAnimationType == AnimationType::Rope)
+    {
+        ApplyRope(deltaTime, container);
+        return;
+    }
+
+    mTime += deltaTime * mSpeed;
+
+    switch (mAnimationType)
+    {
+    case AnimationType::Wave:
+        ApplyDeformation(KnotDeformer::Deformation::Wave, container);
+        break;
+    case AnimationType::Spiral:
+        ApplyDeformation(KnotDeformer::Deformation::Spiral, container);
+        break;
+    default:
+        for (const auto& spline : container->GetCurves())
+        {
+            ApplyAnimation(spline);
+        }
+        break;
+    }
+}
+
+void BSplineRenderer::AnimationManager::ApplyAnimation(SplinePtr spline)
+{
+    AnimatedCurve* curve = GetAnimatedCurve(spline);
+
+    if (curve == nullptr)
+        return;
+
+    switch (mAnimationType)
+    {
+    case AnimationType::Rotate:
+        ApplyRotation(*curve);
+        break;
+    case AnimationType::Pulse:
+        ApplyPulse(*curve);
+        break;
+    case AnimationType::Bounce:
+        ApplyBounce(*curve);
+        break;
+    default:
+        break;
+    }
+}
+
+void BSplineRenderer::AnimationManager::Reset()
+{
+    mTime = 0.0f;
+    mAppliedTime = -1.0f;
+    mRopeBuilt = false;
+    // Restore original positions
+    for (auto& curve : mAnimatedCurves)
+    {
+        RestoreKnots(curve);
+        curve.spline->SetModelMatrix(QMatrix4x4());
+    }
+}
+
+void BSplineRenderer::AnimationManager::SaveOriginalPositions(CurveContainer* container)
+{
+    for (auto& curve : mAnimatedCurves)
+    {
+        RestoreKnots(curve);
+    }
+
+    mAnimatedCurves.clear();
+    mCurveIndices.clear();
+    mKnots.clear();
+    mKnotIndices.clear();
+
+    int knotCount = 0;
+
+    for (const auto& spline : container->GetCurves())
+    {
+        knotCount += spline->GetKnotCount();
+    }
+
+    mRestPositions.Resize(knotCount);
+    mPosePositions.Resize(knotCount);
+    mKnots.reserve(knotCount);
+    mKnotIndices.reserve(knotCount);
+
+    for (const auto& spline : container->GetCurves())
+    {
+        const int first = mKnots.size();
+
+        for (const auto& knot : spline->GetKnots())
+        {
+            const QVector3D& position = knot->GetPosition();
+            const int index = mKnots.size();
+            mRestPositions.x[index] = position.x();
+            mRestPositions.y[index] = position.y();
+            mRestPositions.z[index] = position.z();
+            mKnotIndices.push_back(index - first);
+            mKnots.push_back(knot);
+        }
+
+        mCurveIndices[spline.get()] = mAnimatedCurves.size();
+        mAnimatedCurves.push_back({ spline, first, spline->GetKnotCount(), false });
+    }
+
+    mTimeline.RemoveStaleTracks(container->GetCurves());
+    mKeyframesResolved = false;
+    mRopeBuilt = false;
+}
+
+void BSplineRenderer::AnimationManager::SetKnotPinned(const KnotPtr& knot, bool pinned)
+{
+    if (pinned)
+        mPinnedKnots.insert(knot);
+    else
+        mPinnedKnots.erase(knot);
+
+    UpdatePins();
+}
+
+void BSplineRenderer::AnimationManager::SetPinEnds(bool pinEnds)
+{
+    mPinEnds = pinEnds;
+    UpdatePins();
+}
+
+void BSplineRenderer::AnimationManager::SetKnotKey(const SplinePtr& spline, const KnotPtr& knot)
+{
+    mTimeline.SetKnotKey(spline, knot, mTime, knot->GetPosition() - mTimeline.GetTranslation(spline, mTime));
+}
+
+void BSplineRenderer::AnimationManager::SetCurveKey(const SplinePtr& spline, const QVector3D& translation)
+{
+    mTimeline.SetCurveKey(spline, mTime, translation);
+}
+
+void BSplineRenderer::AnimationManager::RemoveKeys(const SplinePtr& spline)
+{
+    mTimeline.RemoveKeys(spline, mTime);
+}
+
+bool BSplineRenderer::AnimationManager::StartBake(const QString& filePath)
+{
+    if (IsBaking())
+        return false;
+
+    ResolveKeyframes();
+
+    // The file is about to be replaced
+    mCache.Close();
+
+    mBakePath = filePath;
+    mBakeDone = 0;
+    mBakeTotal = mKeyframes.frameCount;
+    mBakeCancelled = false;
+    mBaking = true;
+
+    mBakeFuture = QtConcurrent::run([this, filePath, input = mKeyframes]() {
+        return AnimationCache::Bake(filePath, input, [this](qint64 done, qint64 total) {
+            mBakeDone = done;
+            mBakeTotal = total;
+            return mBakeCancelled == false;
+        });
+    });
+
+    return true;
+}
+
+float BSplineRenderer::AnimationManager::GetBakeProgress() const
+{
+    const qint64 total = mBakeTotal;
+    return total > 0 ? float(mBakeDone) / total : 0.0f;
+}
+
+bool BSplineRenderer::AnimationManager::IsCacheValid()
+{
+    ResolveKeyframes();
+    return mCache.IsOpen() && mCache.GetFingerprint() == mFingerprint;
+}
+
+const char* BSplineRenderer::AnimationManager::GetAnimationTypeName(AnimationType type) const
+{
+    switch (type)
+    {
+    case AnimationType::None:
+        return "None";
+    case AnimationType::Rotate:
+        return "Rotate";
+    case AnimationType::Pulse:
+        return "Pulse";
+    case AnimationType::Wave:
+        return "Wave";
+    case AnimationType::Bounce:
+        return "Bounce";
+    case AnimationType::Spiral:
+        return "Spiral";
+    case AnimationType::Keyframes:
+        return "Keyframes";
+    case AnimationType::Rope:
+        return "Rope";
+    default:
+        return "Unknown";
+    }
+}
+
+void BSplineRenderer::AnimationManager::ApplyRotation(AnimatedCurve& curve)
+{
+    QMatrix4x4 rotation;
+    rotation.rotate(mTime * 30.0f, 0, 1, 0); // Rotate around Y axis
+    ApplyRigid(curve, rotation);
+}
+
+void BSplineRenderer::AnimationManager::ApplyPulse(AnimatedCurve& curve)
+{
+    float scale = 1.0f + mAmplitude * 0.2f * std::sin(mTime * 2.0f);
+
+    QMatrix4x4 scaling;
+    scaling.scale(scale);
+    ApplyRigid(curve, scaling);
+}
+
+void BSplineRenderer::AnimationManager::ApplyBounce(AnimatedCurve& curve)
+{
+    float bounce = mAmplitude * std::abs(std::sin(mTime * 3.0f));
+
+    QMatrix4x4 translation;
+    translation.translate(0, bounce, 0);
+    ApplyRigid(curve, translation);
+}
+
+void BSplineRenderer::AnimationManager::ApplyDeformation(KnotDeformer::Deformation deformation, CurveContainer* container)
+{
+    std::vector<DeformationJob> jobs;
+    QVector<AnimatedCurve*> curves;
+    CreateJobs(container, jobs, curves);
+
+    JobSystem::Instance().Map(jobs, [this, deformation](const DeformationJob& job) {
+        KnotDeformer::Deform(deformation, mTime, mAmplitude, mRestPositions, mKnotIndices, mPosePositions, job.first, job.count);
+        WriteKnots(mPosePositions, job);
+    });
+
+    for (const auto& curve : curves)
+    {
+        MarkDeformed(*curve);
+        curve->spline->MakeDirty();
+    }
+}
+
+void BSplineRenderer::AnimationManager::ApplyRope(float deltaTime, CurveContainer* container)
+{
+    if (!mRopeBuilt)
+        BuildRope();
+
+    for (const int particle : mPinnedParticles)
+    {
+        mRope.SetPosition(particle, mKnots[particle]->GetPosition());
+    }
+
+    if (mRope.Advance(deltaTime * mSpeed) == 0)
+        return;
+
+    std::vector<DeformationJob> jobs;
+    QVector<AnimatedCurve*> curves;
+    CreateJobs(container, jobs, curves);
+
+    JobSystem::Instance().Map(jobs, [this](const DeformationJob& job) { WriteKnots(mRope.GetPositions(), job); });
+
+    for (const auto& curve : curves)
+    {
+        MarkDeformed(*curve);
+        curve->spline->MakeDirty();
+    }
+}
+
+void BSplineRenderer::AnimationManager::BuildRope()
+{
+    mRope.Clear();
+
+    QVector<QVector3D> positions;
+
+    for (const auto& curve : mAnimatedCurves)
+    {
+        positions.resize(curve.count);
+
+        for (int i = 0; i < curve.count; ++i)
+        {
+            positions[i] = mRestPositions.At(curve.first + i);
+        }
+
+        mRope.AddRope(positions.constData(), curve.count);
+    }
+
+    mRopeBuilt = true;
+    UpdatePins();
+}
+
+void BSplineRenderer::AnimationManager::UpdatePins()
+{
+    mPinnedParticles.clear();
+
+    if (!mRopeBuilt)
+        return;
+
+    for (const auto& curve : mAnimatedCurves)
+    {
+        for (int i = curve.first; i < curve.first + curve.count; ++i)
+        {
+            const bool end = i == curve.first || i == curve.first + curve.count - 1;
+            const bool pinned = (mPinEnds && end) || mPinnedKnots.contains(mKnots[i]);
+            mRope.SetPinned(i, pinned);
+
+            if (pinned)
+                mPinnedParticles.push_back(i);
+        }
+    }
+}
+
+void BSplineRenderer::AnimationManager::CreateJobs(CurveContainer* container, std::vector<DeformationJob>& jobs, QVector<AnimatedCurve*>& curves)
+{
+    for (const auto& spline : container->GetCurves())
+    {
+        AnimatedCurve* curve = GetAnimatedCurve(spline);
+
+        if (curve == nullptr || curve->count != spline->GetKnotCount())
+            continue;
+
+        curves << curve;
+
+        for (int first = curve->first; first < curve->first + curve->count;)
+        {
+            if (jobs.empty() || jobs.back().first + jobs.back().count != first || jobs.back().count == KNOTS_PER_JOB)
+            {
+                jobs.push_back({ first, 0 });
+            }
+
+            const int count = std::min(KNOTS_PER_JOB - jobs.back().count, curve->first + curve->count - first);
+            jobs.back().count += count;
+            first += count;
+        }
+    }
+}
+
+void BSplineRenderer::AnimationManager::WriteKnots(const SampleArray& positions, const DeformationJob& job)
+{
+    for (int i = job.first; i < job.first + job.count; ++i)
+    {
+        mKnots[i]->SetPosition(positions.x[i], positions.y[i], positions.z[i]);
+    }
+}
+
+void BSplineRenderer::AnimationManager::ApplyRigid(AnimatedCurve& curve, const QMatrix4x4& transformation)
+{
+    RestoreKnots(curve);
+    curve.spline->SetModelMatrix(transformation);
+}
+
+void BSplineRenderer::AnimationManager::RestoreKnots(AnimatedCurve& curve)
+{
+    if (!curve.deformed)
+        return;
+
+    for (int i = curve.first; i < curve.first + curve.count; ++i)
+    {
+        mKnots[i]->SetPosition(mRestPositions.x[i], mRestPositions.y[i], mRestPositions.z[i]);
+    }
+    curve.spline->MakeDirty();
+    curve.deformed = false;
+}
+
+void BSplineRenderer::AnimationManager::ApplyKeyframes(float deltaTime, CurveContainer* container)
+{
+    const float duration = mTimeline.GetDuration();
+
+    if (!mPaused)
+    {
+        mTime += deltaTime * mSpeed;
+        mTime = duration > 0.0f ? std::fmod(mTime, duration) : 0.0f;
+    }
+
+    const bool cached = IsCacheValid();
+
+    if (mTime == mAppliedTime && mTimeline.GetRevision() == mAppliedRevision && cached == mAppliedCached)
+        return;
+
+    mAppliedTime = mTime;
+    mAppliedRevision = mTimeline.GetRevision();
+    mAppliedCached = cached;
+
+    std::unordered_set<const Spline*> liveCurves;
+    liveCurves.reserve(container->GetCurves().size());
+
+    for (const auto& spline : container->GetCurves())
+    {
+        liveCurves.insert(spline.get());
+    }
+
+    std::vector<int> curves;
+
+    if (cached)
+    {
+        const int frame = mTimeline.GetFrameAt(mTime);
+        const auto& entries = mCache.GetCurves();
+
+        for (int i = 0; i < entries.size(); ++i)
+        {
+            if (IsAnimatable(liveCurves, entries[i].curve))
+                curves.push_back(i);
+        }
+
+        JobSystem::Instance().Map(curves, [this, frame](int entry) {
+            mCache.Apply(frame, entry, mAnimatedCurves[mCache.GetCurves()[entry].curve].spline.get());
+        });
+
+        for (const int entry : curves)
+        {
+            MarkDeformed(mAnimatedCurves[mCache.GetCurves()[entry].curve]);
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < mKeyframes.curves.size(); ++i)
+    {
+        if (IsAnimatable(liveCurves, mKeyframes.curves[i].curve))
+            curves.push_back(i);
+    }
+
+    // Only the knots are moved, the next UpdateBatch solves the curves in parallel
+    JobSystem::Instance().Map(curves, [this](int index) {
+        const TimelineCurve& curve = mKeyframes.curves[index];
+        QVector<QVector3D> positions(curve.count);
+        curve.Evaluate(mTime, mKeyframes.rest, positions.data());
+
+        for (int i = 0; i < curve.count; ++i)
+        {
+            mKnots[curve.first + i]->SetPosition(positions[i]);
+        }
+    });
+
+    for (const int index : curves)
+    {
+        AnimatedCurve& curve = mAnimatedCurves[mKeyframes.curves[index].curve];
+        MarkDeformed(curve);
+        curve.spline->MakeDirty();
+    }
+}
+
+void BSplineRenderer::AnimationManager::ResolveKeyframes()
+{
+    if (mKeyframesResolved && mResolvedRevision == mTimeline.GetRevision())
+        return;
+
+    mKeyframes.curves.clear();
+
+    for (int i = 0; i < int(mAnimatedCurves.size()); ++i)
+    {
+        const AnimatedCurve& curve = mAnimatedCurves[i];
+
+        if (mTimeline.HasTracks(curve.spline) && curve.count == curve.spline->GetKnotCount())
+            mKeyframes.curves << mTimeline.Resolve(curve.spline, i, curve.first);
+    }
+
+    mKeyframes.rest = mRestPositions;
+    mKeyframes.frameCount = mTimeline.GetFrameCount();
+    mKeyframes.frameRate = mTimeline.GetFrameRate();
+    mFingerprint = AnimationCache::GetFingerprint(mKeyframes);
+
+    mKeyframesResolved = true;
+    mResolvedRevision = mTimeline.GetRevision();
+
+    // Forces the next ApplyKeyframes
+    mAppliedRevision = ~0ull;
+}
+
+void BSplineRenderer::AnimationManager::UpdateBake()
+{
+    if (!mBaking || !mBakeFuture.isFinished())
+        return;
+
+    mBaking = false;
+    const std::string filePath = mBakePath.toStdString();
+
+    if (mBakeFuture.result() && mCache.Open(mBakePath))
+    {
+        LOG_INFO("AnimationManager::UpdateBake: {} frames baked to {}", mCache.GetFrameCount(), filePath);
+    }
+    else if (mBakeCancelled)
+    {
+        LOG_INFO("AnimationManager::UpdateBake: Baking to {} cancelled", filePath);
+    }
+    else
+    {
+        LOG_WARN("AnimationManager::UpdateBake: Timeline could not be baked to {}", filePath);
+    }
+
+    mAppliedRevision = ~0ull;
+}
+
+bool BSplineRenderer::AnimationManager::IsAnimatable(const std::unordered_set<const Spline*>& liveCurves, int curve) const
+{
+    if (curve < 0 || curve >= int(mAnimatedCurves.size()))
+        return false;
+
+    const AnimatedCurve& animated = mAnimatedCurves[curve];
+    return animated.count == animated.spline->GetKnotCount() && liveCurves.contains(animated.spline.get());
+}
+
+void BSplineRenderer::AnimationManager::MarkDeformed(AnimatedCurve& curve)
+{
+    curve.spline->SetModelMatrix(QMatrix4x4());
+    curve.deformed = true;
+}
+
+BSplineRenderer::AnimationManager::AnimatedCurve* BSplineRenderer::AnimationManager::GetAnimatedCurve(const SplinePtr& spline)
+{
+    const auto it = mCurveIndices.find(spline.get());
+    return it != mCurveIndices.end() ? &mAnimatedCurves[it->second] : nullptr;
+}
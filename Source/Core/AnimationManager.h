@@ -1,12 +1,20 @@
 #pragma once
 
+#include "Core/AnimationCache.h"
 #include "Core/CurveContainer.h"
+#include "Core/Timeline.h"
+#include "Curve/KnotDeformer.h"
+#include "Curve/RopeSimulation.h"
 #include "Curve/Spline.h"
 
+#include <QFuture>
 #include <QMatrix4x4>
 #include <QVector3D>
-#include <cmath>
+#include <atomic>
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace BSplineRenderer
 {
@@ -17,7 +25,9 @@ namespace BSplineRenderer
         Pulse,
         Wave,
         Bounce,
-        Spiral
+        Spiral,
+        Keyframes,
+        Rope
     };
 
     class AnimationManager
@@ -29,42 +39,10 @@ namespace BSplineRenderer
             return instance;
         }
 
-        void Update(float deltaTime, CurveContainer* container)
-        {
-            if (!mEnabled || mAnimationType == AnimationType::None)
-                return;
-
-            mTime += deltaTime * mSpeed;
+        void Update(float deltaTime, CurveContainer* container);
 
-            for (const auto& spline : container->GetCurves())
-            {
-                ApplyAnimation(spline);
-            }
-        }
-
-        void ApplyAnimation(SplinePtr spline)
-        {
-            switch (mAnimationType)
-            {
-            case AnimationType::Rotate:
-                ApplyRotation(spline);
-                break;
-            case AnimationType::Pulse:
-                ApplyPulse(spline);
-                break;
-            case AnimationType::Wave:
-                ApplyWave(spline);
-                break;
-            case AnimationType::Bounce:
-                ApplyBounce(spline);
-                break;
-            case AnimationType::Spiral:
-                ApplySpiral(spline);
-                break;
-            default:
-                break;
-            }
-        }
+        // Rigid animations only, Wave and Spiral deform all curves at once in Update()
+        void ApplyAnimation(SplinePtr spline);
 
         void SetEnabled(bool enabled) { mEnabled = enabled; }
         bool IsEnabled() const { return mEnabled; }
@@ -78,159 +56,165 @@ namespace BSplineRenderer
         void SetAmplitude(float amplitude) { mAmplitude = amplitude; }
         float GetAmplitude() const { return mAmplitude; }
 
-        void Reset()
-        {
-            mTime = 0.0f;
-            // Restore original positions
-            for (auto& [spline, positions] : mOriginalPositions)
-            {
-                const auto& knots = spline->GetKnots();
-                for (int i = 0; i < knots.size() && i < positions.size(); ++i)
-                {
-                    knots[i]->SetPosition(positions[i]);
-                }
-                spline->MakeDirty();
-            }
-        }
+        void SetTime(float time) { mTime = time; }
+        float GetTime() const { return mTime; }
 
-        void SaveOriginalPositions(CurveContainer* container)
-        {
-            mOriginalPositions.clear();
-            for (const auto& spline : container->GetCurves())
-            {
-                QVector<QVector3D> positions;
-                for (const auto& knot : spline->GetKnots())
-                {
-                    positions.append(knot->GetPosition());
-                }
-                mOriginalPositions[spline] = positions;
-            }
-        }
+        // Stops the keyframe playback, the time only changes by SetTime()
+        void SetPaused(bool paused) { mPaused = paused; }
+        bool IsPaused() const { return mPaused; }
 
-        const char* GetAnimationTypeName(AnimationType type) const
-        {
-            switch (type)
-            {
-            case AnimationType::None:
-                return "None";
-            case AnimationType::Rotate:
-                return "Rotate";
-            case AnimationType::Pulse:
-                return "Pulse";
-            case AnimationType::Wave:
-                return "Wave";
-            case AnimationType::Bounce:
-                return "Bounce";
-            case AnimationType::Spiral:
-                return "Spiral";
-            default:
-                return "Unknown";
-            }
-        }
+        void Reset();
+
+        // Copies the knots of all curves into the rest pose, one contiguous range per curve.
+        // Deformed curves are put back first so that they do not become the new rest pose.
+        void SaveOriginalPositions(CurveContainer* container);
+
+        // Read by every step, so changes apply to the running simulation
+        RopeParameters& GetRopeParameters() { return mRope.GetParameters_NonConst(); }
+
+        // Pinned knots hold the rope. They are not simulated but follow their knot, so dragging them moves the rope.
+        void SetKnotPinned(const KnotPtr& knot, bool pinned);
+        bool IsKnotPinned(const KnotPtr& knot) const { return mPinnedKnots.contains(knot); }
+
+        // Pins the first and the last knot of every curve in addition to the pinned knots
+        void SetPinEnds(bool pinEnds);
+        bool GetPinEnds() const { return mPinEnds; }
+
+        Timeline& GetTimeline() { return mTimeline; }
+
+        // Keys the knot at its current position and the current time, without the translation of its curve
+        void SetKnotKey(const SplinePtr& spline, const KnotPtr& knot);
+
+        void SetCurveKey(const SplinePtr& spline, const QVector3D& translation);
+        void RemoveKeys(const SplinePtr& spline);
+
+        // Bakes the timeline into an AnimationCache file in the background. The cache is played back
+        // instead of solving the curves as long as neither the timeline nor the rest pose changes.
+        bool StartBake(const QString& filePath);
+
+        void CancelBake() { mBakeCancelled = true; }
+        void WaitForBake() { mBakeFuture.waitForFinished(); }
+        bool IsBaking() const { return mBaking; }
+
+        // In [0, 1], by the number of frames baked
+        float GetBakeProgress() const;
+
+        // True if the keyframes are played back from the cache
+        bool IsCacheValid();
+
+        const char* GetAnimationTypeName(AnimationType type) const;
 
       private:
         AnimationManager() = default;
 
-        void ApplyRotation(SplinePtr spline)
+        struct AnimatedCurve
         {
-            if (!mOriginalPositions.contains(spline))
-                return;
+            SplinePtr spline;
 
-            const auto& originalPositions = mOriginalPositions[spline];
-            const auto& knots = spline->GetKnots();
+            // Range of the curve in the rest pose
+            int first;
+            int count;
 
-            QMatrix4x4 rotation;
-            rotation.rotate(mTime * 30.0f, 0, 1, 0); // Rotate around Y axis
+            // Knots moved by Wave or Spiral
+            bool deformed;
+        };
 
-            for (int i = 0; i < knots.size() && i < originalPositions.size(); ++i)
-            {
-                QVector3D newPos = rotation.map(originalPositions[i]);
-                knots[i]->SetPosition(newPos);
-            }
-            spline->MakeDirty();
-        }
-
-        void ApplyPulse(SplinePtr spline)
+        // Range of the rest pose deformed by one task
+        struct DeformationJob
         {
-            if (!mOriginalPositions.contains(spline))
-                return;
+            int first;
+            int count;
+        };
 
-            const auto& originalPositions = mOriginalPositions[spline];
-            const auto& knots = spline->GetKnots();
+        // Rotate, Pulse and Bounce move every knot by the same similarity transform, the spline through the
+        // moved knots is the moved spline. They only set the model matrix, nothing is re-solved or uploaded.
+        void ApplyRotation(AnimatedCurve& curve);
+        void ApplyPulse(AnimatedCurve& curve);
+        void ApplyBounce(AnimatedCurve& curve);
 
-            float scale = 1.0f + mAmplitude * 0.2f * std::sin(mTime * 2.0f);
+        // Wave and Spiral move each knot differently. The rest pose is cut into jobs of about
+        // KNOTS_PER_JOB knots, each deformed by a vectorized kernel and written back to its knots
+        // on the JobSystem. The curves are re-solved in parallel by the next UpdateBatch.
+        void ApplyDeformation(KnotDeformer::Deformation deformation, CurveContainer* container);
 
-            for (int i = 0; i < knots.size() && i < originalPositions.size(); ++i)
-            {
-                QVector3D newPos = originalPositions[i] * scale;
-                knots[i]->SetPosition(newPos);
-            }
-            spline->MakeDirty();
-        }
+        // Simulates every curve as a rope in fixed steps, the knots are written back after each frame with a step
+        void ApplyRope(float deltaTime, CurveContainer* container);
 
-        void ApplyWave(SplinePtr spline)
-        {
-            if (!mOriginalPositions.contains(spline))
-                return;
-
-            const auto& originalPositions = mOriginalPositions[spline];
-            const auto& knots = spline->GetKnots();
-
-            for (int i = 0; i < knots.size() && i < originalPositions.size(); ++i)
-            {
-                float offset = mAmplitude * std::sin(mTime * 2.0f + i * 0.5f);
-                QVector3D newPos = originalPositions[i] + QVector3D(0, offset, 0);
-                knots[i]->SetPosition(newPos);
-            }
-            spline->MakeDirty();
-        }
+        // One particle per knot of the rest pose, so that particles and knots share their indices
+        void BuildRope();
+        void UpdatePins();
 
-        void ApplyBounce(SplinePtr spline)
-        {
-            if (!mOriginalPositions.contains(spline))
-                return;
+        // Cuts the ranges of the curves still in the scene with the knot count of the rest pose into jobs.
+        // Adjacent curves are merged into one job, long curves are split.
+        void CreateJobs(CurveContainer* container, std::vector<DeformationJob>& jobs, QVector<AnimatedCurve*>& curves);
 
-            const auto& originalPositions = mOriginalPositions[spline];
-            const auto& knots = spline->GetKnots();
+        void WriteKnots(const SampleArray& positions, const DeformationJob& job);
+        void ApplyRigid(AnimatedCurve& curve, const QMatrix4x4& transformation);
 
-            float bounce = mAmplitude * std::abs(std::sin(mTime * 3.0f));
+        // Puts back the knots moved by Wave or Spiral
+        void RestoreKnots(AnimatedCurve& curve);
 
-            for (int i = 0; i < knots.size() && i < originalPositions.size(); ++i)
-            {
-                QVector3D newPos = originalPositions[i] + QVector3D(0, bounce, 0);
-                knots[i]->SetPosition(newPos);
-            }
-            spline->MakeDirty();
-        }
+        // Moves the curves of the timeline to the current time, from the cache if it is up to date
+        // and by evaluating the tracks otherwise. Nothing is done while the time stands still.
+        void ApplyKeyframes(float deltaTime, CurveContainer* container);
 
-        void ApplySpiral(SplinePtr spline)
-        {
-            if (!mOriginalPositions.contains(spline))
-                return;
-
-            const auto& originalPositions = mOriginalPositions[spline];
-            const auto& knots = spline->GetKnots();
-
-            for (int i = 0; i < knots.size() && i < originalPositions.size(); ++i)
-            {
-                float angle = mTime + i * 0.3f;
-                float spiralOffset = mAmplitude * 0.5f * std::sin(angle);
-                QMatrix4x4 rotation;
-                rotation.rotate(mTime * 20.0f + i * 10.0f, 0, 1, 0);
-
-                QVector3D rotatedPos = rotation.map(originalPositions[i]);
-                rotatedPos += QVector3D(0, spiralOffset, 0);
-                knots[i]->SetPosition(rotatedPos);
-            }
-            spline->MakeDirty();
-        }
+        // Rebuilds the bake input if the timeline or the rest pose changed since the last call
+        void ResolveKeyframes();
+
+        // Ends a bake once its worker is done and opens the new cache
+        void UpdateBake();
+
+        // The curve is still in the scene with the knot count of the rest pose
+        bool IsAnimatable(const std::unordered_set<const Spline*>& liveCurves, int curve) const;
+
+        // The knots replace the model matrix
+        void MarkDeformed(AnimatedCurve& curve);
+
+        AnimatedCurve* GetAnimatedCurve(const SplinePtr& spline);
+
+        static constexpr int KNOTS_PER_JOB = 1 << 14;
 
         bool mEnabled{ false };
+        bool mPaused{ false };
         AnimationType mAnimationType{ AnimationType::None };
         float mSpeed{ 1.0f };
         float mAmplitude{ 1.0f };
         float mTime{ 0.0f };
 
-        std::map<SplinePtr, QVector<QVector3D>> mOriginalPositions;
+        // Rest pose as structure of arrays, the knots of each curve are contiguous
+        SampleArray mRestPositions;
+        SampleArray mPosePositions;
+        std::vector<float> mKnotIndices;
+        std::vector<KnotPtr> mKnots;
+
+        std::vector<AnimatedCurve> mAnimatedCurves;
+        std::unordered_map<const Spline*, int> mCurveIndices;
+
+        // Keyframe animation, resolved against the rest pose
+        Timeline mTimeline;
+        BakeInput mKeyframes;
+        quint64 mFingerprint{ 0 };
+        bool mKeyframesResolved{ false };
+        unsigned long long mResolvedRevision{ 0 };
+
+        // State last applied by ApplyKeyframes
+        float mAppliedTime{ -1.0f };
+        unsigned long long mAppliedRevision{ ~0ull };
+        bool mAppliedCached{ false };
+
+        // Rope simulation, particles have the indices of the knots in the rest pose
+        RopeSimulation mRope;
+        bool mRopeBuilt{ false };
+        bool mPinEnds{ true };
+        std::set<KnotPtr> mPinnedKnots;
+        std::vector<int> mPinnedParticles;
+
+        AnimationCache mCache;
+        QFuture<bool> mBakeFuture;
+        QString mBakePath;
+        bool mBaking{ false };
+        std::atomic<qint64> mBakeDone{ 0 };
+        std::atomic<qint64> mBakeTotal{ 0 };
+        std::atomic_bool mBakeCancelled{ false };
     };
 }
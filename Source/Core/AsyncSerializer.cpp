@@ -0,0 +1,147 @@
+#include "AsyncSerializer.h"
+
+#include "Core/CurveSerializer.h"
+#include "Util/Logger.h"
+
+#include <QtConcurrent>
+
+BSplineRenderer::AsyncSerializer::~AsyncSerializer()
+{
+    Cancel();
+    mFuture.waitForFinished();
+}
+
+bool BSplineRenderer::AsyncSerializer::Save(const QString& filePath, const CurveContainer* container)
+{
+    if (IsBusy())
+    {
+        return false;
+    }
+
+    Start(Operation::Save, filePath);
+
+    mFuture = QtConcurrent::run([this, filePath, snapshot = CurveSerializer::CreateSnapshot(container)]() {
+        return CurveSerializer::Save(filePath, snapshot, [this](qint64 done, qint64 total) { return ReportProgress(done, total); });
+    });
+
+    return true;
+}
+
+bool BSplineRenderer::AsyncSerializer::Load(const QString& filePath)
+{
+    if (IsBusy())
+    {
+        return false;
+    }
+
+    Start(Operation::Load, filePath);
+
+    mFuture = QtConcurrent::run([this, filePath]() {
+        QVector<SplinePtr> batch;
+        qint64 batchKnots = 0;
+
+        const auto onCurve = [&](CurveData&& curve) {
+            SplinePtr spline = curve.ToSpline();
+            spline->Update();
+            batch << spline;
+            batchKnots += spline->GetKnotCount();
+
+            if (batchKnots >= KNOTS_PER_BATCH)
+            {
+                AddPending(batch);
+                batchKnots = 0;
+            }
+        };
+
+        const bool success = CurveSerializer::Load(filePath, onCurve, [this](qint64 done, qint64 total) { return ReportProgress(done, total); });
+        AddPending(batch);
+        return success;
+    });
+
+    return true;
+}
+
+void BSplineRenderer::AsyncSerializer::Cancel()
+{
+    mCancelled = true;
+}
+
+void BSplineRenderer::AsyncSerializer::Update(CurveContainer* container)
+{
+    if (IsBusy() == false)
+    {
+        return;
+    }
+
+    // Checked before taking the pending curves, so that the last batch is not missed
+    const bool finished = mFuture.isFinished();
+
+    QVector<SplinePtr> curves;
+
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        curves.swap(mPending);
+    }
+
+    for (const auto& curve : curves)
+    {
+        container->AddCurve(curve);
+    }
+
+    if (finished == false)
+    {
+        return;
+    }
+
+    const bool saving = mOperation == Operation::Save;
+    const std::string filePath = mFilePath.toStdString();
+
+    if (mFuture.result())
+    {
+        LOG_INFO("AsyncSerializer::Update: Curves {} {}", saving ? "saved to" : "loaded from", filePath);
+    }
+    else if (mCancelled)
+    {
+        LOG_INFO("AsyncSerializer::Update: {} of {} cancelled", saving ? "Saving" : "Loading", filePath);
+    }
+    else
+    {
+        LOG_WARN("AsyncSerializer::Update: Curves could not be {} {}", saving ? "saved to" : "loaded from", filePath);
+    }
+
+    mOperation = Operation::None;
+}
+
+float BSplineRenderer::AsyncSerializer::GetProgress() const
+{
+    const qint64 total = mTotal;
+    return total > 0 ? float(mDone) / total : 0.0f;
+}
+
+void BSplineRenderer::AsyncSerializer::Start(Operation operation, const QString& filePath)
+{
+    mOperation = operation;
+    mFilePath = filePath;
+    mDone = 0;
+    mTotal = 0;
+    mCancelled = false;
+}
+
+bool BSplineRenderer::AsyncSerializer::ReportProgress(qint64 done, qint64 total)
+{
+    mDone = done;
+    mTotal = total;
+    return mCancelled == false;
+}
+
+void BSplineRenderer::AsyncSerializer::AddPending(QVector<SplinePtr>& curves)
+{
+    if (curves.isEmpty())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    mPending << curves;
+    curves.clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Core/CurveContainer.h"
+#include "Util/Macros.h"
+
+#include <QFuture>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <mutex>
+
+namespace BSplineRenderer
+{
+    // Runs CurveSerializer on a worker thread so that the window keeps rendering, one operation at a time.
+    // Saving writes a snapshot taken when it starts. Loading builds and solves the splines on the worker
+    // and hands them to the render thread in batches, the curves show up while the file is being read.
+    class AsyncSerializer
+    {
+        DISABLE_COPY(AsyncSerializer);
+
+      public:
+        enum class Operation
+        {
+            None,
+            Save,
+            Load
+        };
+
+        AsyncSerializer() = default;
+        ~AsyncSerializer();
+
+        // Both return false if an operation is already running
+        bool Save(const QString& filePath, const CurveContainer* container);
+        bool Load(const QString& filePath);
+
+        // Curves already handed over by a cancelled load are kept, a cancelled save leaves the file untouched
+        void Cancel();
+
+        // Must be called once per frame on the render thread. Adds the curves loaded since the
+        // last call to the container and ends the operation once the worker is done.
+        void Update(CurveContainer* container);
+
+        Operation GetOperation() const { return mOperation; }
+        bool IsBusy() const { return mOperation != Operation::None; }
+        bool IsCancelled() const { return mCancelled; }
+        const QString& GetFilePath() const { return mFilePath; }
+
+        // In [0, 1], by the number of knots processed
+        float GetProgress() const;
+
+      private:
+        void Start(Operation operation, const QString& filePath);
+        bool ReportProgress(qint64 done, qint64 total);
+        void AddPending(QVector<SplinePtr>& curves);
+
+        static constexpr int KNOTS_PER_BATCH = 1 << 16;
+
+        QFuture<bool> mFuture;
+        Operation mOperation{ Operation::None };
+        QString mFilePath;
+
+        std::atomic<qint64> mDone{ 0 };
+        std::atomic<qint64> mTotal{ 0 };
+        std::atomic_bool mCancelled{ false };
+
+        // Loaded curves waiting for the render thread
+        std::mutex mPendingMutex;
+        QVector<SplinePtr> mPending;
+    };
+}
@@ -7,4 +7,5 @@ namespace BSplineRenderer
     constexpr int DEFAULT_NUMBER_OF_SEGMENTS = 32;
     constexpr int DEFAULT_NUMBER_OF_SECTORS = 32;
     constexpr float DEFAULT_RADIUS = 0.25f;
+    constexpr float DEFAULT_LOCAL_UPDATE_TOLERANCE = 1e-4f;
 }
@@ -1,8 +1,10 @@
 #include "Controller.h"
 
 #include "Core/AnimationManager.h"
+#include "Core/AsyncSerializer.h"
 #include "Core/Constants.h"
 #include "Core/CurveContainer.h"
+#include "Core/FrameScheduler.h"
 #include "Core/UndoRedoManager.h"
 #include "Core/Window.h"
 #include "Gui/ImGuiWindow.h"
@@ -21,15 +23,23 @@ BSplineRenderer::Controller::Controller(QObject* parent)
     mImGuiWindow = new ImGuiWindow(this);
     mRendererManager = new RendererManager;
     mCurveContainer = new CurveContainer;
+    mAsyncSerializer = new AsyncSerializer;
+    mFrameScheduler = new FrameScheduler;
 
     mCamera = mRendererManager->GetCamera();
     mEventHandler->SetCamera(mCamera);
     mEventHandler->SetCurveContainer(mCurveContainer);
     mEventHandler->SetRendererManager(mRendererManager);
+    mEventHandler->SetCurveBvh(&mFrameScheduler->GetCurveBvh());
+    mEventHandler->SetKnotOctree(&mFrameScheduler->GetKnotOctree());
 
     mRendererManager->SetCurveContainer(mCurveContainer);
+    mFrameScheduler->SetCurveContainer(mCurveContainer);
+    mFrameScheduler->SetRendererManager(mRendererManager);
     mImGuiWindow->SetRendererManager(mRendererManager);
     mImGuiWindow->SetCurveContainer(mCurveContainer);
+    mImGuiWindow->SetAsyncSerializer(mAsyncSerializer);
+    mImGuiWindow->SetFrameScheduler(mFrameScheduler);
 
     connect(mWindow, &Window::Initialize, this, &Controller::Initialize);
     connect(mWindow, &Window::Render, this, &Controller::Render);
@@ -53,8 +63,11 @@ BSplineRenderer::Controller::Controller(QObject* parent)
                 mImGuiWindow->SetSelectedKnot(knot); //
             });
 
-    connect(mEventHandler, &EventHandler::KnotAroundChanged, this, [this](KnotPtr knot)
-            { mRendererManager->SetKnotAround(knot); });
+    connect(mEventHandler, &EventHandler::KnotAroundChanged, this, [this](KnotPtr knot, SplinePtr curve)
+            { mRendererManager->SetKnotAround(knot, curve); });
+
+    connect(mEventHandler, &EventHandler::HoveredCurveChanged, this, [this](SplinePtr curve)
+            { mRendererManager->SetHoveredCurve(curve); });
 
     // Connect ImGuiWindow signals
     connect(mImGuiWindow, &ImGuiWindow::RequestCameraReset, this, [this]()
@@ -74,6 +87,12 @@ BSplineRenderer::Controller::~Controller()
 {
     qDebug() << "Controller::~Controller: Application closing...";
     qDebug() << "Controller::~Controller: Current Thread:" << QThread::currentThread();
+
+    // Waits for a running save, load or bake
+    delete mAsyncSerializer;
+
+    AnimationManager::Instance().CancelBake();
+    AnimationManager::Instance().WaitForBake();
 }
 
 void BSplineRenderer::Controller::Run()
@@ -101,8 +120,15 @@ void BSplineRenderer::Controller::Render(float ifps)
     mCamera->Update(ifps);
     mEventHandler->SetDevicePixelRatio(mDevicePixelRatio);
 
-    // Update animations
-    AnimationManager::Instance().Update(ifps, mCurveContainer);
+    // Add the curves loaded in the background since the last frame
+    mAsyncSerializer->Update(mCurveContainer);
+
+    // Hover queries of earlier frames the GPU has finished, never waits
+    mRendererManager->ResolveQueries();
+    mEventHandler->Update();
+
+    // Animation, solves, culling, tube meshes and statistics on all cores, then OpenGL on this thread
+    mFrameScheduler->Run(ifps, mCamera->GetViewProjectionMatrix());
 
     mRendererManager->Render();
 
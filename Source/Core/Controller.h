@@ -14,6 +14,8 @@ namespace BSplineRenderer
     class ImGuiWindow;
     class RendererManager;
     class CurveContainer;
+    class AsyncSerializer;
+    class FrameScheduler;
 
     class Controller : public QObject, protected QOpenGLExtraFunctions
     {
@@ -53,6 +55,8 @@ namespace BSplineRenderer
         EventHandler* mEventHandler;
         RendererManager* mRendererManager;
         CurveContainer* mCurveContainer;
+        AsyncSerializer* mAsyncSerializer;
+        FrameScheduler* mFrameScheduler;
         FreeCameraPtr mCamera;
     };
 }
@@ -14,3 +14,21 @@ BSplineRenderer::SplinePtr BSplineRenderer::CurveContainer::GetCurve(int index)
 {
     return mCurves[index];
 }
+
+void BSplineRenderer::CurveContainer::UpdateDirtyCurves()
+{
+    SplineGeometry::UpdateBatch(GetGeometries());
+}
+
+QVector<BSplineRenderer::SplineGeometry*> BSplineRenderer::CurveContainer::GetGeometries() const
+{
+    QVector<SplineGeometry*> geometries;
+    geometries.reserve(mCurves.size());
+
+    for (const auto& curve : mCurves)
+    {
+        geometries << curve.get();
+    }
+
+    return geometries;
+}
@@ -15,8 +15,13 @@ namespace BSplineRenderer
         void RemoveCurve(SplinePtr spline);
         SplinePtr GetCurve(int index);
 
+        void UpdateDirtyCurves();
+
         const QVector<SplinePtr>& GetCurves() const { return mCurves; }
 
+        // The curves as plain geometry, for the GL independent code
+        QVector<SplineGeometry*> GetGeometries() const;
+
       private:
         QVector<SplinePtr> mCurves;
     };
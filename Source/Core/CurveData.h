@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Curve/Spline.h"
+
+#include <QVector3D>
+#include <QVector4D>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+
+namespace BSplineRenderer
+{
+    // What the scene files store of a curve. Plain data detached from the Spline,
+    // so it can be copied on the GUI thread and written or filled on a worker.
+    struct CurveData
+    {
+        QVector<QVector3D> knots;
+        QVector4D color{ 1.0f, 1.0f, 1.0f, 1.0f };
+        float radius{ DEFAULT_RADIUS };
+        float ambient{ 0.25f };
+        float diffuse{ 0.50f };
+        float specular{ 0.25f };
+        float shininess{ 4.0f };
+
+        static CurveData FromSpline(const Spline& spline)
+        {
+            CurveData data;
+            data.knots.reserve(spline.GetKnotCount());
+
+            for (const auto& knot : spline.GetKnots())
+            {
+                data.knots << knot->GetPosition();
+            }
+
+            data.color = spline.GetColor();
+            data.radius = spline.GetRadius();
+            data.ambient = spline.GetAmbient();
+            data.diffuse = spline.GetDiffuse();
+            data.specular = spline.GetSpecular();
+            data.shininess = spline.GetShininess();
+            return data;
+        }
+
+        SplinePtr ToSpline() const
+        {
+            auto spline = std::make_shared<Spline>();
+            spline->SetColor(color);
+            spline->SetRadius(radius);
+            spline->SetAmbient(ambient);
+            spline->SetDiffuse(diffuse);
+            spline->SetSpecular(specular);
+            spline->SetShininess(shininess);
+            spline->AddKnots(knots.constData(), knots.size());
+            return spline;
+        }
+    };
+
+    // Receives the curves of a file one by one while it is read
+    using CurveDataCallback = std::function<void(CurveData&& curve)>;
+
+    // Reports the knots processed so far out of the total, returning false cancels the operation
+    using ProgressCallback = std::function<bool(qint64 done, qint64 total)>;
+}
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "Core/CurveContainer.h"
+#include "Core/CurveData.h"
+#include "Core/SceneFile.h"
 #include "Curve/Spline.h"
 
 #include <QFile>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 #include <QString>
 
 namespace BSplineRenderer
@@ -14,47 +17,67 @@ namespace BSplineRenderer
     class CurveSerializer
     {
       public:
-        // Save all curves to JSON file
+        // Copy of the curves that can be saved on another thread while the originals keep changing
+        static QVector<CurveData> CreateSnapshot(const CurveContainer* container)
+        {
+            QVector<CurveData> curves;
+            curves.reserve(container->GetCurves().size());
+
+            for (const auto& spline : container->GetCurves())
+            {
+                curves << CurveData::FromSpline(*spline);
+            }
+
+            return curves;
+        }
+
+        // Save all curves to file, binary if the extension is that of SceneFile, JSON otherwise
         static bool SaveToFile(const QString& filePath, CurveContainer* container)
         {
-            QJsonObject root;
+            return Save(filePath, CreateSnapshot(container));
+        }
+
+        // Load curves from file, binary if the extension is that of SceneFile, JSON otherwise
+        static bool LoadFromFile(const QString& filePath, CurveContainer* container)
+        {
+            return Load(filePath, [container](CurveData&& curve) { container->AddCurve(curve.ToSpline()); });
+        }
+
+        // Thread safe, the file is replaced only if the whole save succeeds
+        static bool Save(const QString& filePath, const QVector<CurveData>& curves, const ProgressCallback& progress = nullptr)
+        {
+            if (SceneFile::IsSceneFile(filePath))
+            {
+                return SceneFile::Save(filePath, curves, progress);
+            }
+
+            qint64 knotCount = 0;
+
+            for (const auto& curve : curves)
+            {
+                knotCount += curve.knots.size();
+            }
+
             QJsonArray curvesArray;
+            qint64 knotsWritten = 0;
 
-            for (const auto& spline : container->GetCurves())
+            for (const auto& curve : curves)
             {
-                QJsonObject curveObj;
-                curveObj["radius"] = spline->GetRadius();
-                curveObj["ambient"] = spline->GetAmbient();
-                curveObj["diffuse"] = spline->GetDiffuse();
-                curveObj["specular"] = spline->GetSpecular();
-                curveObj["shininess"] = spline->GetShininess();
-
-                QJsonArray colorArray;
-                colorArray.append(spline->GetColor().x());
-                colorArray.append(spline->GetColor().y());
-                colorArray.append(spline->GetColor().z());
-                colorArray.append(spline->GetColor().w());
-                curveObj["color"] = colorArray;
-
-                QJsonArray knotsArray;
-                for (const auto& knot : spline->GetKnots())
+                if (progress && progress(knotsWritten, knotCount) == false)
                 {
-                    QJsonObject knotObj;
-                    knotObj["x"] = knot->GetPosition().x();
-                    knotObj["y"] = knot->GetPosition().y();
-                    knotObj["z"] = knot->GetPosition().z();
-                    knotsArray.append(knotObj);
+                    return false;
                 }
-                curveObj["knots"] = knotsArray;
 
-                curvesArray.append(curveObj);
+                curvesArray.append(ToJson(curve));
+                knotsWritten += curve.knots.size();
             }
 
+            QJsonObject root;
             root["version"] = "1.0";
             root["curves"] = curvesArray;
 
             QJsonDocument doc(root);
-            QFile file(filePath);
+            QSaveFile file(filePath);
 
             if (!file.open(QIODevice::WriteOnly))
             {
@@ -62,13 +85,23 @@ namespace BSplineRenderer
             }
 
             file.write(doc.toJson(QJsonDocument::Indented));
-            file.close();
-            return true;
+
+            if (progress)
+            {
+                progress(knotCount, knotCount);
+            }
+
+            return file.commit();
         }
 
-        // Load curves from JSON file
-        static bool LoadFromFile(const QString& filePath, CurveContainer* container)
+        // Thread safe, passes the curves to onCurve in file order
+        static bool Load(const QString& filePath, const CurveDataCallback& onCurve, const ProgressCallback& progress = nullptr)
         {
+            if (SceneFile::IsSceneFile(filePath))
+            {
+                return SceneFile::Load(filePath, onCurve, progress);
+            }
+
             QFile file(filePath);
 
             if (!file.open(QIODevice::ReadOnly))
@@ -88,36 +121,30 @@ namespace BSplineRenderer
             QJsonObject root = doc.object();
             QJsonArray curvesArray = root["curves"].toArray();
 
+            qint64 knotCount = 0;
+
             for (const auto& curveVal : curvesArray)
             {
-                QJsonObject curveObj = curveVal.toObject();
-
-                auto spline = std::make_shared<Spline>();
+                knotCount += curveVal.toObject()["knots"].toArray().size();
+            }
 
-                spline->SetRadius(curveObj["radius"].toDouble(0.25f));
-                spline->SetAmbient(curveObj["ambient"].toDouble(0.25f));
-                spline->SetDiffuse(curveObj["diffuse"].toDouble(0.5f));
-                spline->SetSpecular(curveObj["specular"].toDouble(0.25f));
-                spline->SetShininess(curveObj["shininess"].toDouble(4.0f));
+            qint64 knotsRead = 0;
 
-                QJsonArray colorArray = curveObj["color"].toArray();
-                if (colorArray.size() >= 4)
+            for (const auto& curveVal : curvesArray)
+            {
+                if (progress && progress(knotsRead, knotCount) == false)
                 {
-                    spline->SetColor(QVector4D(colorArray[0].toDouble(), colorArray[1].toDouble(), colorArray[2].toDouble(),
-                                               colorArray[3].toDouble()));
+                    return false;
                 }
 
-                QJsonArray knotsArray = curveObj["knots"].toArray();
-                for (const auto& knotVal : knotsArray)
-                {
-                    QJsonObject knotObj = knotVal.toObject();
-                    float x = knotObj["x"].toDouble();
-                    float y = knotObj["y"].toDouble();
-                    float z = knotObj["z"].toDouble();
-                    spline->AddKnot(x, y, z);
-                }
+                CurveData curve = FromJson(curveVal.toObject());
+                knotsRead += curve.knots.size();
+                onCurve(std::move(curve));
+            }
 
-                container->AddCurve(spline);
+            if (progress)
+            {
+                progress(knotCount, knotCount);
             }
 
             return true;
@@ -125,32 +152,69 @@ namespace BSplineRenderer
 
         // Convert a single curve to JSON string
         static QString SplineToJson(SplinePtr spline)
+        {
+            QJsonDocument doc(ToJson(CurveData::FromSpline(*spline)));
+            return QString(doc.toJson(QJsonDocument::Compact));
+        }
+
+      private:
+        static QJsonObject ToJson(const CurveData& curve)
         {
             QJsonObject curveObj;
-            curveObj["radius"] = spline->GetRadius();
-            curveObj["ambient"] = spline->GetAmbient();
-            curveObj["diffuse"] = spline->GetDiffuse();
+            curveObj["radius"] = curve.radius;
+            curveObj["ambient"] = curve.ambient;
+            curveObj["diffuse"] = curve.diffuse;
+            curveObj["specular"] = curve.specular;
+            curveObj["shininess"] = curve.shininess;
 
             QJsonArray colorArray;
-            colorArray.append(spline->GetColor().x());
-            colorArray.append(spline->GetColor().y());
-            colorArray.append(spline->GetColor().z());
-            colorArray.append(spline->GetColor().w());
+            colorArray.append(curve.color.x());
+            colorArray.append(curve.color.y());
+            colorArray.append(curve.color.z());
+            colorArray.append(curve.color.w());
             curveObj["color"] = colorArray;
 
             QJsonArray knotsArray;
-            for (const auto& knot : spline->GetKnots())
+            for (const auto& position : curve.knots)
             {
                 QJsonObject knotObj;
-                knotObj["x"] = knot->GetPosition().x();
-                knotObj["y"] = knot->GetPosition().y();
-                knotObj["z"] = knot->GetPosition().z();
+                knotObj["x"] = position.x();
+                knotObj["y"] = position.y();
+                knotObj["z"] = position.z();
                 knotsArray.append(knotObj);
             }
             curveObj["knots"] = knotsArray;
 
-            QJsonDocument doc(curveObj);
-            return QString(doc.toJson(QJsonDocument::Compact));
+            return curveObj;
+        }
+
+        static CurveData FromJson(const QJsonObject& curveObj)
+        {
+            CurveData curve;
+            curve.radius = curveObj["radius"].toDouble(0.25f);
+            curve.ambient = curveObj["ambient"].toDouble(0.25f);
+            curve.diffuse = curveObj["diffuse"].toDouble(0.5f);
+            curve.specular = curveObj["specular"].toDouble(0.25f);
+            curve.shininess = curveObj["shininess"].toDouble(4.0f);
+
+            QJsonArray colorArray = curveObj["color"].toArray();
+            if (colorArray.size() >= 4)
+            {
+                curve.color = QVector4D(colorArray[0].toDouble(), colorArray[1].toDouble(), colorArray[2].toDouble(), colorArray[3].toDouble());
+            }
+
+            QJsonArray knotsArray = curveObj["knots"].toArray();
+            curve.knots.reserve(knotsArray.size());
+            for (const auto& knotVal : knotsArray)
+            {
+                QJsonObject knotObj = knotVal.toObject();
+                float x = knotObj["x"].toDouble();
+                float y = knotObj["y"].toDouble();
+                float z = knotObj["z"].toDouble();
+                curve.knots << QVector3D(x, y, z);
+            }
+
+            return curve;
         }
     };
 }
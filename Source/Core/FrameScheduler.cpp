@@ -0,0 +1,69 @@
+#include "FrameScheduler.h"
+
+#include "Core/AnimationManager.h"
+#include "Core/CurveContainer.h"
+#include "Renderer/RendererManager.h"
+#include "Util/JobSystem.h"
+
+#include <vector>
+
+BSplineRenderer::FrameScheduler::FrameScheduler()
+{
+    const int animation = mTaskGraph.AddTask("Animation", [this]() { AnimationManager::Instance().Update(mDeltaTime, mCurveContainer); });
+    const int solve = mTaskGraph.AddTask("Solve", [this]() { mCurveContainer->UpdateDirtyCurves(); });
+    const int culling = mTaskGraph.AddTask("Culling", [this]() { mRendererManager->Cull(mViewProjection); });
+    const int frames = mTaskGraph.AddTask("Frames", [this]() { mRendererManager->UpdateFrames(); });
+    const int tubeMeshes = mTaskGraph.AddTask("Tube Meshes", [this]() { mRendererManager->BuildTubeMeshes(); });
+    const int picking = mTaskGraph.AddTask("Picking", [this]() { mCurveBvh.Update(mCurveContainer->GetCurves()); });
+    const int knots = mTaskGraph.AddTask("Knot Octree", [this]() { mKnotOctree.Update(mCurveContainer->GetCurves()); });
+    const int statistics = mTaskGraph.AddTask("Statistics", [this]() { UpdateStatistics(); });
+
+    // The animation moves knots, everything else needs the solved curves. The frames of the curves
+    // drawn as tubes are transported after culling and change the versions the others read.
+    mTaskGraph.AddDependency(solve, animation);
+    mTaskGraph.AddDependency(culling, solve);
+    mTaskGraph.AddDependency(frames, culling);
+    mTaskGraph.AddDependency(tubeMeshes, frames);
+    mTaskGraph.AddDependency(picking, frames);
+    mTaskGraph.AddDependency(knots, frames);
+    mTaskGraph.AddDependency(statistics, solve);
+}
+
+void BSplineRenderer::FrameScheduler::Run(float ifps, const QMatrix4x4& viewProjection)
+{
+    mDeltaTime = ifps;
+    mViewProjection = viewProjection;
+
+    mTaskGraph.Run();
+}
+
+void BSplineRenderer::FrameScheduler::UpdateStatistics()
+{
+    const auto& curves = mCurveContainer->GetCurves();
+
+    // One partial sum per job, added up in order so that the total does not depend on the scheduling
+    std::vector<FrameStatistics> partials((curves.size() + CURVES_PER_JOB - 1) / CURVES_PER_JOB);
+
+    JobSystem::Instance().ParallelFor(curves.size(), CURVES_PER_JOB, [&curves, &partials](int first, int count) {
+        FrameStatistics& partial = partials[first / CURVES_PER_JOB];
+
+        for (int i = first; i < first + count; ++i)
+        {
+            partial.knotCount += curves[i]->GetKnotCount();
+            partial.patchCount += curves[i]->GetPatchCount();
+            partial.totalLength += curves[i]->GetTotalLength();
+        }
+    });
+
+    FrameStatistics statistics;
+    statistics.curveCount = curves.size();
+
+    for (const auto& partial : partials)
+    {
+        statistics.knotCount += partial.knotCount;
+        statistics.patchCount += partial.patchCount;
+        statistics.totalLength += partial.totalLength;
+    }
+
+    mStatistics = statistics;
+}
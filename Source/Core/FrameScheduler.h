@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Curve/CurveBvh.h"
+#include "Curve/KnotOctree.h"
+#include "Util/Macros.h"
+#include "Util/TaskGraph.h"
+
+#include <QMatrix4x4>
+
+namespace BSplineRenderer
+{
+    class CurveContainer;
+    class RendererManager;
+
+    // Totals of the scene, gathered every frame
+    struct FrameStatistics
+    {
+        int curveCount{ 0 };
+        int knotCount{ 0 };
+        int patchCount{ 0 };
+        float totalLength{ 0.0f };
+    };
+
+    // The CPU work of a frame as a task graph on the JobSystem: the animation, then the solve of the
+    // dirty curves, then culling and the frames of the visible tubes, then tube mesh generation, the picking BVH and the knot octree
+    // in parallel. Statistics only need the solve. OpenGL stays on the context thread, which calls Run() before rendering and runs
+    // tasks itself until the graph is done.
+    class FrameScheduler
+    {
+        DISABLE_COPY(FrameScheduler);
+
+      public:
+        FrameScheduler();
+
+        // The camera matrices are computed by the caller, the tasks do not touch the camera
+        void Run(float ifps, const QMatrix4x4& viewProjection);
+
+        void SetCurveContainer(CurveContainer* curveContainer) { mCurveContainer = curveContainer; }
+        void SetRendererManager(RendererManager* rendererManager) { mRendererManager = rendererManager; }
+
+        // Timings of the last frame
+        const TaskGraph& GetTaskGraph() const { return mTaskGraph; }
+
+        const FrameStatistics& GetStatistics() const { return mStatistics; }
+
+        // The curves as of the last Run(), for picking between frames
+        const CurveBvh& GetCurveBvh() const { return mCurveBvh; }
+        const KnotOctree& GetKnotOctree() const { return mKnotOctree; }
+
+      private:
+        void UpdateStatistics();
+
+        static constexpr int CURVES_PER_JOB = 256;
+
+        CurveContainer* mCurveContainer{ nullptr };
+        RendererManager* mRendererManager{ nullptr };
+
+        TaskGraph mTaskGraph;
+        FrameStatistics mStatistics;
+        CurveBvh mCurveBvh;
+        KnotOctree mKnotOctree;
+
+        // Input of the running frame
+        float mDeltaTime{ 0.0f };
+        QMatrix4x4 mViewProjection;
+    };
+}
@@ -0,0 +1,205 @@
+#include "SceneFile.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+#include <limits>
+
+// The file is written and mapped in the byte order of the host, all supported targets are little endian
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN);
+static_assert(sizeof(QVector3D) == 3 * sizeof(float));
+
+namespace
+{
+    constexpr quint64 KNOT_ALIGNMENT = 16;
+
+    quint64 Align(quint64 offset)
+    {
+        return (offset + KNOT_ALIGNMENT - 1) / KNOT_ALIGNMENT * KNOT_ALIGNMENT;
+    }
+}
+
+bool BSplineRenderer::SceneFile::IsSceneFile(const QString& filePath)
+{
+    return QFileInfo(filePath).suffix().compare(EXTENSION, Qt::CaseInsensitive) == 0;
+}
+
+bool BSplineRenderer::SceneFile::Save(const QString& filePath, const QVector<CurveData>& curves, const ProgressCallback& progress)
+{
+    SceneFileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.curveCount = curves.size();
+    header.tocOffset = sizeof(SceneFileHeader);
+
+    QVector<SceneFileCurve> toc(curves.size());
+    quint64 offset = Align(header.tocOffset + curves.size() * sizeof(SceneFileCurve));
+    qint64 knotCount = 0;
+
+    for (int i = 0; i < curves.size(); ++i)
+    {
+        const CurveData& curve = curves[i];
+        SceneFileCurve& entry = toc[i];
+        std::memset(&entry, 0, sizeof(SceneFileCurve));
+
+        entry.knotOffset = offset;
+        entry.knotCount = curve.knots.size();
+        entry.color[0] = curve.color.x();
+        entry.color[1] = curve.color.y();
+        entry.color[2] = curve.color.z();
+        entry.color[3] = curve.color.w();
+        entry.radius = curve.radius;
+        entry.ambient = curve.ambient;
+        entry.diffuse = curve.diffuse;
+        entry.specular = curve.specular;
+        entry.shininess = curve.shininess;
+
+        offset = Align(offset + entry.knotCount * sizeof(QVector3D));
+        knotCount += entry.knotCount;
+    }
+
+    header.fileSize = offset;
+
+    QSaveFile file(filePath);
+
+    if (file.open(QIODevice::WriteOnly) == false)
+    {
+        return false;
+    }
+
+    QByteArray block(reinterpret_cast<const char*>(&header), sizeof(SceneFileHeader));
+    block.append(reinterpret_cast<const char*>(toc.constData()), toc.size() * sizeof(SceneFileCurve));
+
+    quint64 position = 0;
+    qint64 knotsWritten = 0;
+
+    // One write per curve, the padding before its knots included
+    for (int i = 0; i < curves.size(); ++i)
+    {
+        if (progress && progress(knotsWritten, knotCount) == false)
+        {
+            file.cancelWriting();
+            return false;
+        }
+
+        const QVector<QVector3D>& knots = curves[i].knots;
+        block.append(QByteArray(toc[i].knotOffset - position - block.size(), '\0'));
+        block.append(reinterpret_cast<const char*>(knots.constData()), knots.size() * sizeof(QVector3D));
+
+        if (file.write(block) != block.size())
+        {
+            file.cancelWriting();
+            return false;
+        }
+
+        position += block.size();
+        knotsWritten += knots.size();
+        block.clear();
+    }
+
+    block.append(QByteArray(header.fileSize - position - block.size(), '\0'));
+    file.write(block);
+
+    if (progress)
+    {
+        progress(knotCount, knotCount);
+    }
+
+    return file.commit();
+}
+
+bool BSplineRenderer::SceneFile::Load(const QString& filePath, const CurveDataCallback& onCurve, const ProgressCallback& progress)
+{
+    QFile file(filePath);
+
+    if (file.open(QIODevice::ReadOnly) == false)
+    {
+        return false;
+    }
+
+    const quint64 size = file.size();
+
+    if (size < sizeof(SceneFileHeader))
+    {
+        return false;
+    }
+
+    // Reading the whole file is the fallback for file systems that do not support mapping
+    QByteArray contents;
+    const uchar* data = file.map(0, size);
+
+    if (data == nullptr)
+    {
+        contents = file.readAll();
+        data = reinterpret_cast<const uchar*>(contents.constData());
+
+        if (quint64(contents.size()) != size)
+        {
+            return false;
+        }
+    }
+
+    SceneFileHeader header;
+    std::memcpy(&header, data, sizeof(SceneFileHeader));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.fileSize != size)
+    {
+        return false;
+    }
+
+    if (header.tocOffset > size || header.curveCount > (size - header.tocOffset) / sizeof(SceneFileCurve))
+    {
+        return false;
+    }
+
+    QVector<SceneFileCurve> toc(header.curveCount);
+    std::memcpy(toc.data(), data + header.tocOffset, toc.size() * sizeof(SceneFileCurve));
+
+    qint64 knotCount = 0;
+
+    for (const auto& entry : toc)
+    {
+        const bool valid = entry.knotOffset % alignof(float) == 0 &&
+                           entry.knotOffset <= size &&
+                           entry.knotCount <= (size - entry.knotOffset) / sizeof(QVector3D) &&
+                           entry.knotCount <= quint64(std::numeric_limits<int>::max());
+
+        if (valid == false)
+        {
+            return false;
+        }
+
+        knotCount += entry.knotCount;
+    }
+
+    qint64 knotsRead = 0;
+
+    for (const auto& entry : toc)
+    {
+        if (progress && progress(knotsRead, knotCount) == false)
+        {
+            return false;
+        }
+
+        CurveData curve;
+        curve.knots.resize(entry.knotCount);
+        std::memcpy(curve.knots.data(), data + entry.knotOffset, entry.knotCount * sizeof(QVector3D));
+        curve.color = QVector4D(entry.color[0], entry.color[1], entry.color[2], entry.color[3]);
+        curve.radius = entry.radius;
+        curve.ambient = entry.ambient;
+        curve.diffuse = entry.diffuse;
+        curve.specular = entry.specular;
+        curve.shininess = entry.shininess;
+
+        knotsRead += entry.knotCount;
+        onCurve(std::move(curve));
+    }
+
+    if (progress)
+    {
+        progress(knotCount, knotCount);
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core/CurveData.h"
+
+#include <QString>
+#include <QtGlobal>
+
+namespace BSplineRenderer
+{
+    // Binary scene file (.bscene), little endian:
+    //
+    //   SceneFileHeader
+    //   SceneFileCurve[curveCount]     Table of contents, at tocOffset
+    //   float[3 * knotCount]           Knot positions of each curve as x0 y0 z0 x1 y1 z1 ..., at knotOffset
+    //
+    // All offsets are absolute and the knot arrays are 16-byte aligned, so the file is mapped into
+    // memory and the knots are taken straight from the mapping without any parsing.
+    struct SceneFileHeader
+    {
+        char magic[8];
+        quint32 version;
+        quint32 curveCount;
+        quint64 tocOffset;
+        quint64 fileSize;
+    };
+
+    struct SceneFileCurve
+    {
+        quint64 knotOffset;
+        quint64 knotCount;
+        float color[4];
+        float radius;
+        float ambient;
+        float diffuse;
+        float specular;
+        float shininess;
+        quint32 reserved[3];
+    };
+
+    static_assert(sizeof(SceneFileHeader) == 32);
+    static_assert(sizeof(SceneFileCurve) == 64);
+
+    class SceneFile
+    {
+      public:
+        SceneFile() = delete;
+
+        // True if the file has the extension of the binary format
+        static bool IsSceneFile(const QString& filePath);
+
+        static bool Save(const QString& filePath, const QVector<CurveData>& curves, const ProgressCallback& progress = nullptr);
+
+        // Passes the curves to onCurve in file order. The whole table of contents is validated first,
+        // nothing is passed if the file is not valid.
+        static bool Load(const QString& filePath, const CurveDataCallback& onCurve, const ProgressCallback& progress = nullptr);
+
+        static constexpr quint32 VERSION = 1;
+        static constexpr char MAGIC[8] = { 'B', 'S', 'P', 'L', 'S', 'C', 'N', '\0' };
+        static constexpr const char* EXTENSION = "bscene";
+    };
+}
@@ -0,0 +1,254 @@
+#include "Timeline.h"
+
+#include <algorithm>
+#include <cmath>
+
+void BSplineRenderer::KeyframeTrack::SetKey(float time, const QVector3D& value)
+{
+    const auto it = std::lower_bound(mKeys.begin(), mKeys.end(), time - TIME_EPSILON, [](const Keyframe& key, float t) { return key.time < t; });
+
+    if (it != mKeys.end() && it->time <= time + TIME_EPSILON)
+    {
+        it->value = value;
+    }
+    else
+    {
+        mKeys.insert(it, Keyframe{ time, value });
+    }
+}
+
+bool BSplineRenderer::KeyframeTrack::RemoveKey(float time)
+{
+    const auto it = std::lower_bound(mKeys.begin(), mKeys.end(), time - TIME_EPSILON, [](const Keyframe& key, float t) { return key.time < t; });
+
+    if (it == mKeys.end() || it->time > time + TIME_EPSILON)
+    {
+        return false;
+    }
+
+    mKeys.erase(it);
+    return true;
+}
+
+QVector3D BSplineRenderer::KeyframeTrack::Evaluate(float time, Interpolation interpolation) const
+{
+    if (mKeys.isEmpty())
+    {
+        return QVector3D();
+    }
+
+    if (time <= mKeys.first().time)
+    {
+        return mKeys.first().value;
+    }
+
+    if (time >= mKeys.last().time)
+    {
+        return mKeys.last().value;
+    }
+
+    // First key after time, the segment is [i - 1, i]
+    const int i = std::upper_bound(mKeys.begin(), mKeys.end(), time, [](float t, const Keyframe& key) { return t < key.time; }) - mKeys.begin();
+
+    const Keyframe& k0 = mKeys[i - 1];
+    const Keyframe& k1 = mKeys[i];
+    const float h = k1.time - k0.time;
+    const float s = (time - k0.time) / h;
+
+    if (interpolation == Interpolation::Linear)
+    {
+        return (1.0f - s) * k0.value + s * k1.value;
+    }
+
+    // Catmull-Rom tangents for uneven key spacing, one sided at the ends
+    const auto tangent = [this](int k) {
+        const int previous = std::max(0, k - 1);
+        const int next = std::min<int>(mKeys.size() - 1, k + 1);
+        return (mKeys[next].value - mKeys[previous].value) / (mKeys[next].time - mKeys[previous].time);
+    };
+
+    const float s2 = s * s;
+    const float s3 = s2 * s;
+
+    return (2.0f * s3 - 3.0f * s2 + 1.0f) * k0.value + (s3 - 2.0f * s2 + s) * h * tangent(i - 1) + (3.0f * s2 - 2.0f * s3) * k1.value + (s3 - s2) * h * tangent(i);
+}
+
+void BSplineRenderer::TimelineCurve::Evaluate(float time, const SampleArray& rest, QVector3D* positions) const
+{
+    const QVector3D offset = translation.Evaluate(time, interpolation);
+
+    for (int i = 0; i < count; ++i)
+    {
+        positions[i] = rest.At(first + i) + offset;
+    }
+
+    for (const auto& [index, track] : knots)
+    {
+        positions[index] = track.Evaluate(time, interpolation) + offset;
+    }
+}
+
+void BSplineRenderer::Timeline::SetKnotKey(const SplinePtr& spline, const KnotPtr& knot, float time, const QVector3D& position)
+{
+    mTracks[spline].knots[knot].SetKey(time, position);
+    ++mRevision;
+}
+
+void BSplineRenderer::Timeline::SetCurveKey(const SplinePtr& spline, float time, const QVector3D& translation)
+{
+    mTracks[spline].translation.SetKey(time, translation);
+    ++mRevision;
+}
+
+void BSplineRenderer::Timeline::RemoveKeys(const SplinePtr& spline, float time)
+{
+    const auto it = mTracks.find(spline);
+
+    if (it == mTracks.end())
+    {
+        return;
+    }
+
+    CurveTracks& tracks = it->second;
+    tracks.translation.RemoveKey(time);
+
+    for (auto knot = tracks.knots.begin(); knot != tracks.knots.end();)
+    {
+        knot->second.RemoveKey(time);
+        knot = knot->second.IsEmpty() ? tracks.knots.erase(knot) : std::next(knot);
+    }
+
+    if (tracks.translation.IsEmpty() && tracks.knots.empty())
+    {
+        mTracks.erase(it);
+    }
+
+    ++mRevision;
+}
+
+void BSplineRenderer::Timeline::RemoveStaleTracks(const QVector<SplinePtr>& splines)
+{
+    for (auto it = mTracks.begin(); it != mTracks.end();)
+    {
+        if (splines.contains(it->first) == false)
+        {
+            it = mTracks.erase(it);
+            ++mRevision;
+            continue;
+        }
+
+        auto& knots = it->second.knots;
+
+        for (auto knot = knots.begin(); knot != knots.end();)
+        {
+            if (it->first->GetKnots().contains(knot->first))
+            {
+                ++knot;
+                continue;
+            }
+
+            knot = knots.erase(knot);
+            ++mRevision;
+        }
+
+        ++it;
+    }
+}
+
+void BSplineRenderer::Timeline::Clear()
+{
+    mTracks.clear();
+    ++mRevision;
+}
+
+QVector3D BSplineRenderer::Timeline::GetTranslation(const SplinePtr& spline, float time) const
+{
+    const auto it = mTracks.find(spline);
+    return it != mTracks.end() ? it->second.translation.Evaluate(time, mInterpolation) : QVector3D();
+}
+
+QVector<float> BSplineRenderer::Timeline::GetKeyTimes(const SplinePtr& spline) const
+{
+    QVector<float> times;
+    const auto it = mTracks.find(spline);
+
+    if (it == mTracks.end())
+    {
+        return times;
+    }
+
+    const auto add = [&times](const KeyframeTrack& track) {
+        for (const auto& key : track.GetKeys())
+        {
+            times << key.time;
+        }
+    };
+
+    add(it->second.translation);
+
+    for (const auto& [knot, track] : it->second.knots)
+    {
+        add(track);
+    }
+
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end(), [](float a, float b) { return b - a <= KeyframeTrack::TIME_EPSILON; }), times.end());
+
+    return times;
+}
+
+BSplineRenderer::TimelineCurve BSplineRenderer::Timeline::Resolve(const SplinePtr& spline, int curve, int first) const
+{
+    TimelineCurve resolved{ curve, first, spline->GetKnotCount(), mInterpolation, {}, {} };
+    const auto it = mTracks.find(spline);
+
+    if (it == mTracks.end())
+    {
+        return resolved;
+    }
+
+    resolved.translation = it->second.translation;
+
+    for (const auto& [knot, track] : it->second.knots)
+    {
+        const int index = spline->GetKnots().indexOf(knot);
+
+        if (index >= 0)
+        {
+            resolved.knots.emplace_back(index, track);
+        }
+    }
+
+    // Knot order, so that evaluating a curve walks its knots forward
+    std::sort(resolved.knots.begin(), resolved.knots.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    return resolved;
+}
+
+void BSplineRenderer::Timeline::SetInterpolation(Interpolation interpolation)
+{
+    mInterpolation = interpolation;
+    ++mRevision;
+}
+
+void BSplineRenderer::Timeline::SetDuration(float duration)
+{
+    mDuration = std::max(duration, 0.0f);
+    ++mRevision;
+}
+
+void BSplineRenderer::Timeline::SetFrameRate(float frameRate)
+{
+    mFrameRate = std::max(frameRate, 1.0f);
+    ++mRevision;
+}
+
+int BSplineRenderer::Timeline::GetFrameCount() const
+{
+    return int(std::floor(mDuration * mFrameRate + KeyframeTrack::TIME_EPSILON)) + 1;
+}
+
+int BSplineRenderer::Timeline::GetFrameAt(float time) const
+{
+    return std::clamp(int(std::lround(time * mFrameRate)), 0, GetFrameCount() - 1);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Curve/Spline.h"
+
+#include <QVector3D>
+#include <QVector>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    enum class Interpolation
+    {
+        Linear,
+
+        // Cubic Hermite with Catmull-Rom tangents, passes through every key with a continuous velocity
+        Smooth
+    };
+
+    struct Keyframe
+    {
+        float time;
+        QVector3D value;
+    };
+
+    // Keys sorted by time. Before the first and after the last key the track holds its end value.
+    class KeyframeTrack
+    {
+      public:
+        // Replaces the key at the same time if there is one
+        void SetKey(float time, const QVector3D& value);
+        bool RemoveKey(float time);
+
+        // Zero if the track has no key
+        QVector3D Evaluate(float time, Interpolation interpolation) const;
+
+        bool IsEmpty() const { return mKeys.isEmpty(); }
+        const QVector<Keyframe>& GetKeys() const { return mKeys; }
+
+        // Keys closer than this are the same key
+        static constexpr float TIME_EPSILON = 1e-4f;
+
+      private:
+        QVector<Keyframe> mKeys;
+    };
+
+    // The tracks of one curve resolved to knot indices. Plain data that is evaluated on any thread.
+    struct TimelineCurve
+    {
+        // Index of the curve and range of its knots in the rest pose
+        int curve;
+        int first;
+        int count;
+
+        Interpolation interpolation;
+        KeyframeTrack translation;
+        std::vector<std::pair<int, KeyframeTrack>> knots;
+
+        // Writes the count knot positions at time. Knots without a track keep their rest position,
+        // all of them are moved by the translation of the curve.
+        void Evaluate(float time, const SampleArray& rest, QVector3D* positions) const;
+    };
+
+    // Keyframe animation of the scene. A curve has a translation track moving all its knots, and single
+    // knots have position tracks that replace their rest position. Knot keys are given without the translation.
+    class Timeline
+    {
+      public:
+        void SetKnotKey(const SplinePtr& spline, const KnotPtr& knot, float time, const QVector3D& position);
+        void SetCurveKey(const SplinePtr& spline, float time, const QVector3D& translation);
+
+        // Removes the keys of the curve and of its knots at time
+        void RemoveKeys(const SplinePtr& spline, float time);
+
+        // Removes the tracks of curves that are no longer in the list and of knots no longer in their curve
+        void RemoveStaleTracks(const QVector<SplinePtr>& splines);
+
+        void Clear();
+
+        bool HasTracks(const SplinePtr& spline) const { return mTracks.contains(spline); }
+        QVector3D GetTranslation(const SplinePtr& spline, float time) const;
+
+        // Sorted times at which the curve or one of its knots has a key
+        QVector<float> GetKeyTimes(const SplinePtr& spline) const;
+
+        // Resolves the tracks of the spline against its current knots, see TimelineCurve
+        TimelineCurve Resolve(const SplinePtr& spline, int curve, int first) const;
+
+        void SetInterpolation(Interpolation interpolation);
+        Interpolation GetInterpolation() const { return mInterpolation; }
+
+        void SetDuration(float duration);
+        float GetDuration() const { return mDuration; }
+
+        void SetFrameRate(float frameRate);
+        float GetFrameRate() const { return mFrameRate; }
+
+        // Frames at 0, 1 / frameRate, ... up to and including the duration
+        int GetFrameCount() const;
+        int GetFrameAt(float time) const;
+
+        // Incremented on every change
+        unsigned long long GetRevision() const { return mRevision; }
+
+      private:
+        struct CurveTracks
+        {
+            KeyframeTrack translation;
+            std::map<KnotPtr, KeyframeTrack> knots;
+        };
+
+        std::map<SplinePtr, CurveTracks> mTracks;
+        Interpolation mInterpolation{ Interpolation::Smooth };
+        float mDuration{ 5.0f };
+        float mFrameRate{ 30.0f };
+        unsigned long long mRevision{ 0 };
+    };
+}
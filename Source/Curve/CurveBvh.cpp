@@ -0,0 +1,294 @@
+#include "CurveBvh.h"
+
+#include "Util/Frustum.h"
+#include "Util/JobSystem.h"
+
+#include <cmath>
+#include <unordered_set>
+
+namespace
+{
+    using namespace BSplineRenderer;
+
+    // A sub-patch is treated as a straight capsule once its control points are this close to its chord, relative to the radius
+    constexpr float FLATNESS = 0.02f;
+    constexpr int MAX_SUBDIVISION_DEPTH = 10;
+
+    constexpr int CURVES_PER_JOB = 256;
+
+    bool IntersectSphere(const QVector3D& center, float radius, const QVector3D& origin, const QVector3D& direction, float& t)
+    {
+        const QVector3D oc = origin - center;
+        const float a = QVector3D::dotProduct(direction, direction);
+        const float b = QVector3D::dotProduct(direction, oc);
+        const float c = QVector3D::dotProduct(oc, oc) - radius * radius;
+        const float h = b * b - a * c;
+
+        if (h < 0.0f)
+        {
+            return false;
+        }
+
+        // Rays starting inside the tube do not hit it
+        t = (-b - std::sqrt(h)) / a;
+
+        return t >= 0.0f;
+    }
+
+    // Ray against the capsule of the segment [a, b], s is the position of the hit along the segment in [0, 1]
+    bool IntersectCapsule(const QVector3D& a, const QVector3D& b, float radius, const QVector3D& origin, const QVector3D& direction, float& t, float& s)
+    {
+        const QVector3D ba = b - a;
+        const QVector3D oa = origin - a;
+
+        const float baba = QVector3D::dotProduct(ba, ba);
+        const float bard = QVector3D::dotProduct(ba, direction);
+        const float baoa = QVector3D::dotProduct(ba, oa);
+        const float rdoa = QVector3D::dotProduct(direction, oa);
+        const float oaoa = QVector3D::dotProduct(oa, oa);
+        const float rdrd = QVector3D::dotProduct(direction, direction);
+
+        // Side of the capsule, a hit there is always the first one
+        const float qa = baba * rdrd - bard * bard;
+
+        if (qa > 1e-12f * baba * rdrd)
+        {
+            const float qb = baba * rdoa - baoa * bard;
+            const float qc = baba * oaoa - baoa * baoa - radius * radius * baba;
+            const float h = qb * qb - qa * qc;
+
+            // The capsule is inside the infinite cylinder
+            if (h < 0.0f)
+            {
+                return false;
+            }
+
+            const float tc = (-qb - std::sqrt(h)) / qa;
+            const float y = baoa + tc * bard;
+
+            if (0.0f < y && y < baba)
+            {
+                t = tc;
+                s = y / baba;
+                return tc >= 0.0f;
+            }
+        }
+
+        // Caps
+        float ta = 0.0f;
+        float tb = 0.0f;
+        const bool hitA = IntersectSphere(a, radius, origin, direction, ta);
+        const bool hitB = IntersectSphere(b, radius, origin, direction, tb);
+
+        if (hitA && (hitB == false || ta <= tb))
+        {
+            t = ta;
+            s = 0.0f;
+            return true;
+        }
+
+        if (hitB)
+        {
+            t = tb;
+            s = 1.0f;
+            return true;
+        }
+
+        return false;
+    }
+
+    float DistanceToSegment(const QVector3D& point, const QVector3D& a, const QVector3D& b)
+    {
+        const QVector3D ba = b - a;
+        const float length = QVector3D::dotProduct(ba, ba);
+        const float s = length > 0.0f ? std::clamp(QVector3D::dotProduct(point - a, ba) / length, 0.0f, 1.0f) : 0.0f;
+
+        return (point - (a + s * ba)).length();
+    }
+
+    // Subdivides the patch [u0, u1] until it is flat, the nearer half is tested first
+    bool IntersectSubpatch(const QVector3D* p, const QVector3D& origin, const QVector3D& direction, const QVector3D& inverseDirection,
+                           float radius, float maxT, float u0, float u1, int depth, float& t, float& u)
+    {
+        Bvh::Box box;
+
+        for (int i = 0; i < Spline::NUM_OF_PATCH_POINTS; ++i)
+        {
+            box = Bvh::Merge(box, Bvh::Box{ p[i], p[i] });
+        }
+
+        float entry = 0.0f;
+
+        if (Bvh::Intersect(box, origin, inverseDirection, radius, maxT, entry) == false)
+        {
+            return false;
+        }
+
+        const float deviation = std::max(DistanceToSegment(p[1], p[0], p[3]), DistanceToSegment(p[2], p[0], p[3]));
+
+        if (deviation <= FLATNESS * radius || depth == MAX_SUBDIVISION_DEPTH)
+        {
+            float s = 0.0f;
+
+            if (IntersectCapsule(p[0], p[3], radius, origin, direction, t, s) && t <= maxT)
+            {
+                u = u0 + s * (u1 - u0);
+                return true;
+            }
+
+            return false;
+        }
+
+        // De Casteljau at the middle
+        const QVector3D p01 = 0.5f * (p[0] + p[1]);
+        const QVector3D p12 = 0.5f * (p[1] + p[2]);
+        const QVector3D p23 = 0.5f * (p[2] + p[3]);
+        const QVector3D p012 = 0.5f * (p01 + p12);
+        const QVector3D p123 = 0.5f * (p12 + p23);
+        const QVector3D middle = 0.5f * (p012 + p123);
+
+        const QVector3D left[] = { p[0], p01, p012, middle };
+        const QVector3D right[] = { middle, p123, p23, p[3] };
+        const float um = 0.5f * (u0 + u1);
+
+        bool hit = false;
+
+        if (IntersectSubpatch(left, origin, direction, inverseDirection, radius, maxT, u0, um, depth + 1, t, u))
+        {
+            hit = true;
+            maxT = t;
+        }
+
+        float rightT = 0.0f;
+        float rightU = 0.0f;
+
+        if (IntersectSubpatch(right, origin, direction, inverseDirection, radius, maxT, um, u1, depth + 1, rightT, rightU))
+        {
+            hit = true;
+            t = rightT;
+            u = rightU;
+        }
+
+        return hit;
+    }
+}
+
+void BSplineRenderer::CurveBvh::Update(const QVector<SplinePtr>& curves)
+{
+    std::unordered_set<unsigned long long> alive;
+
+    for (const auto& curve : curves)
+    {
+        alive.insert(curve->GetId());
+    }
+
+    for (auto it = mVersions.begin(); it != mVersions.end();)
+    {
+        if (alive.contains(it->first) == false)
+        {
+            it = mVersions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    std::vector<unsigned long long> ids;
+    ids.reserve(curves.size());
+    mRefitCount = 0;
+
+    // The curves refit their patch bounds themselves whenever their version changes
+    for (const auto& curve : curves)
+    {
+        const auto [it, inserted] = mVersions.try_emplace(curve->GetId(), curve->GetVersion());
+
+        if (inserted || it->second != curve->GetVersion())
+        {
+            it->second = curve->GetVersion();
+            ++mRefitCount;
+        }
+
+        ids.push_back(curve->GetId());
+    }
+
+    // The model matrices may change every frame without a new version, the world bounds are always recomputed
+    const int count = curves.size();
+    mItems.resize(count);
+    mCurveBoxes.resize(count);
+
+    JobSystem::Instance().ParallelFor(count, CURVES_PER_JOB, [this, &curves](int first, int size) {
+        for (int index = first; index < first + size; ++index)
+        {
+            const SplinePtr& curve = curves[index];
+            const Bvh& bvh = curve->GetPatchBvh();
+            const QMatrix4x4& modelMatrix = curve->GetModelMatrix();
+            const float scale = modelMatrix.column(0).toVector3D().length();
+
+            Item& item = mItems[index];
+            item.curve = curve;
+            item.inverseModelMatrix = modelMatrix.inverted();
+            item.modelRadius = scale > 0.0f ? curve->GetRadius() / scale : curve->GetRadius();
+
+            Bvh::Box& box = mCurveBoxes[index];
+            box = Bvh::Box();
+
+            if (bvh.IsEmpty() == false)
+            {
+                Frustum::Transform(modelMatrix, bvh.GetBounds().min, bvh.GetBounds().max, curve->GetRadius(), box.min, box.max);
+            }
+        }
+    });
+
+    if (ids == mCurveIds)
+    {
+        mCurveBvh.Refit(mCurveBoxes, 0, count - 1);
+    }
+    else
+    {
+        mCurveBvh.Build(mCurveBoxes);
+        mCurveIds = std::move(ids);
+    }
+}
+
+bool BSplineRenderer::CurveBvh::Intersect(const QVector3D& origin, const QVector3D& direction, CurveHit& hit) const
+{
+    bool found = false;
+    float maxT = INFINITY;
+
+    mCurveBvh.Traverse(origin, direction, 0.0f, maxT, [&](int index, float& curveMaxT) {
+        const Item& item = mItems[index];
+        const QVector<QVector3D>& controlPoints = item.curve->GetBezierControlPoints();
+
+        // Model space rays keep the parameter of the world space ray
+        const QVector3D modelOrigin = item.inverseModelMatrix.map(origin);
+        const QVector3D modelDirection = item.inverseModelMatrix.mapVector(direction);
+
+        item.curve->GetPatchBvh().Traverse(modelOrigin, modelDirection, item.modelRadius, curveMaxT, [&](int patch, float& patchMaxT) {
+            // The curve has changed its patch count since the last Update()
+            if (Spline::NUM_OF_PATCH_POINTS * (patch + 1) > controlPoints.size())
+            {
+                return;
+            }
+
+            float t = 0.0f;
+            float u = 0.0f;
+
+            if (IntersectPatch(controlPoints.constData() + Spline::NUM_OF_PATCH_POINTS * patch, modelOrigin, modelDirection, item.modelRadius, patchMaxT, t, u))
+            {
+                patchMaxT = t;
+                hit = CurveHit{ item.curve, patch, t, u };
+                found = true;
+            }
+        });
+    });
+
+    return found;
+}
+
+bool BSplineRenderer::CurveBvh::IntersectPatch(const QVector3D* controlPoints, const QVector3D& origin, const QVector3D& direction, float radius, float maxT, float& t, float& u)
+{
+    const QVector3D inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+
+    return IntersectSubpatch(controlPoints, origin, direction, inverseDirection, radius, maxT, 0.0f, 1.0f, 0, t, u);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Curve/Spline.h"
+#include "Util/Bvh.h"
+#include "Util/Macros.h"
+
+#include <QMatrix4x4>
+#include <QVector>
+#include <unordered_map>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    struct CurveHit
+    {
+        SplinePtr curve{ nullptr };
+        int patch{ -1 };
+
+        // Ray parameter and parameter along the patch in [0, 1]
+        float t{ 0.0f };
+        float u{ 0.0f };
+    };
+
+    // Ray picking of the tubes on the CPU. Every curve keeps a Bvh over the bounds of its Bezier patches
+    // in model space, see SplineGeometry::GetPatchBvh(), and a Bvh over the world space bounds of the
+    // curves is rebuilt when the curves are added or removed. Rays are intersected with the tube of the
+    // curve's radius around the patches, down to a small fraction of the radius.
+    class CurveBvh
+    {
+        DISABLE_COPY(CurveBvh);
+
+      public:
+        CurveBvh() = default;
+
+        // Refits the world space bounds of the curves in parallel on the JobSystem, the curves must be up to date
+        void Update(const QVector<SplinePtr>& curves);
+
+        // Nearest tube hit by origin + t * direction with t >= 0, the curves as of the last Update()
+        bool Intersect(const QVector3D& origin, const QVector3D& direction, CurveHit& hit) const;
+
+        // Ray against the tube of the given radius around a single cubic Bezier patch
+        static bool IntersectPatch(const QVector3D* controlPoints, const QVector3D& origin, const QVector3D& direction, float radius, float maxT, float& t, float& u);
+
+        // Number of curves whose patches changed since the previous Update()
+        int GetRefitCount() const { return mRefitCount; }
+
+      private:
+        struct Item
+        {
+            SplinePtr curve;
+            QMatrix4x4 inverseModelMatrix;
+
+            // The tube keeps its radius under the model matrix, so it is scaled into model space
+            float modelRadius;
+        };
+
+        // Version of every curve at the last Update(), keyed by the curve ID
+        std::unordered_map<unsigned long long, unsigned long long> mVersions;
+
+        std::vector<Item> mItems;
+        std::vector<Bvh::Box> mCurveBoxes;
+        Bvh mCurveBvh;
+
+        // Curves of the last rebuild of mCurveBvh
+        std::vector<unsigned long long> mCurveIds;
+
+        int mRefitCount{ 0 };
+    };
+}
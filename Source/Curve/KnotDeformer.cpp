@@ -0,0 +1,85 @@
+#include "KnotDeformer.h"
+
+#include "Curve/KnotDeformerKernel.h"
+#include "Curve/SplineEvaluatorKernel.h"
+
+#include <cmath>
+
+namespace
+{
+    using namespace BSplineRenderer;
+
+    DeformationKernel GetScalarKernel(KnotDeformer::Deformation deformation)
+    {
+        return deformation == KnotDeformer::Deformation::Wave ? WaveScalar : SpiralScalar;
+    }
+
+    DeformationKernel GetSimdKernel(KnotDeformer::Deformation deformation)
+    {
+#if defined(BR_AVX2_KERNEL)
+        static const bool supported = IsAVX2Supported();
+
+        if (supported)
+        {
+            return deformation == KnotDeformer::Deformation::Wave ? WaveAVX2 : SpiralAVX2;
+        }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        return deformation == KnotDeformer::Deformation::Wave ? WaveNEON : SpiralNEON;
+#endif
+        return nullptr;
+    }
+}
+
+void BSplineRenderer::WaveScalar(const DeformationArrays& arrays, int count, float time, float amplitude)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        arrays.pose[0][i] = arrays.rest[0][i];
+        arrays.pose[1][i] = arrays.rest[1][i] + amplitude * std::sin(WAVE_FREQUENCY * time + WAVE_INDEX_PHASE * arrays.index[i]);
+        arrays.pose[2][i] = arrays.rest[2][i];
+    }
+}
+
+void BSplineRenderer::SpiralScalar(const DeformationArrays& arrays, int count, float time, float amplitude)
+{
+    const float offset = SPIRAL_AMPLITUDE * amplitude;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const float angle = SPIRAL_ANGULAR_SPEED * time + SPIRAL_INDEX_ANGLE * arrays.index[i];
+        const float sin = std::sin(angle);
+        const float cos = std::cos(angle);
+        const float x = arrays.rest[0][i];
+        const float z = arrays.rest[2][i];
+
+        arrays.pose[0][i] = cos * x + sin * z;
+        arrays.pose[1][i] = arrays.rest[1][i] + offset * std::sin(time + SPIRAL_INDEX_PHASE * arrays.index[i]);
+        arrays.pose[2][i] = cos * z - sin * x;
+    }
+}
+
+void BSplineRenderer::KnotDeformer::Deform(Deformation deformation, float time, float amplitude, const SampleArray& rest, const std::vector<float>& indices, SampleArray& pose, int first, int count)
+{
+    const DeformationArrays arrays{
+        { rest.x.data() + first, rest.y.data() + first, rest.z.data() + first },
+        indices.data() + first,
+        { pose.x.data() + first, pose.y.data() + first, pose.z.data() + first },
+    };
+
+    const DeformationKernel simd = mSimdEnabled ? GetSimdKernel(deformation) : nullptr;
+    const DeformationKernel kernel = simd ? simd : GetScalarKernel(deformation);
+
+    kernel(arrays, count, time, amplitude);
+}
+
+void BSplineRenderer::KnotDeformer::SetSimdEnabled(bool enabled)
+{
+    mSimdEnabled = enabled;
+}
+
+bool BSplineRenderer::KnotDeformer::GetSimdEnabled()
+{
+    return mSimdEnabled;
+}
+
+bool BSplineRenderer::KnotDeformer::mSimdEnabled = true;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Curve/SplineEvaluator.h"
+
+namespace BSplineRenderer
+{
+    // Deforms knot positions stored as structure of arrays, the rest pose is never modified.
+    // Each knot moves as a function of the time and of its index along its curve.
+    class KnotDeformer
+    {
+      public:
+        KnotDeformer() = delete;
+
+        enum class Deformation
+        {
+            // y += amplitude * sin(2 time + 0.5 index)
+            Wave,
+
+            // Rotation about the y-axis by (20 time + 10 index) degrees, then y += 0.5 amplitude * sin(time + 0.3 index)
+            Spiral
+        };
+
+        // Writes the deformed rest[first, first + count) to the same entries of pose.
+        // Thread safe as long as the ranges written by the callers do not overlap.
+        static void Deform(Deformation deformation, float time, float amplitude, const SampleArray& rest, const std::vector<float>& indices, SampleArray& pose, int first, int count);
+
+        // The vectorized kernels are used by default if the CPU supports them
+        static void SetSimdEnabled(bool enabled);
+        static bool GetSimdEnabled();
+
+      private:
+        static bool mSimdEnabled;
+    };
+}
@@ -0,0 +1,113 @@
+#include "Curve/KnotDeformerKernel.h"
+
+// Built with AVX2 and FMA code generation enabled, only called after a CPU check
+
+#if defined(BR_AVX2_KERNEL)
+
+#include <immintrin.h>
+
+namespace
+{
+    using namespace BSplineRenderer;
+
+    constexpr int LANES = 8;
+
+    // Sine and cosine of x, accurate to a few ulp while |x| is below a few thousand radians
+    inline void SinCos(__m256 x, __m256& sin, __m256& cos)
+    {
+        const __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(SINCOS_TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+        __m256 r = _mm256_fnmadd_ps(quadrant, _mm256_set1_ps(SINCOS_PI_OVER_TWO_HI), x);
+        r = _mm256_fnmadd_ps(quadrant, _mm256_set1_ps(SINCOS_PI_OVER_TWO_MID), r);
+        r = _mm256_fnmadd_ps(quadrant, _mm256_set1_ps(SINCOS_PI_OVER_TWO_LO), r);
+
+        const __m256 r2 = _mm256_mul_ps(r, r);
+
+        __m256 s = _mm256_fmadd_ps(r2, _mm256_set1_ps(SIN_C2), _mm256_set1_ps(SIN_C1));
+        s = _mm256_fmadd_ps(r2, s, _mm256_set1_ps(SIN_C0));
+        s = _mm256_fmadd_ps(_mm256_mul_ps(r2, r), s, r);
+
+        __m256 c = _mm256_fmadd_ps(r2, _mm256_set1_ps(COS_C2), _mm256_set1_ps(COS_C1));
+        c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(COS_C0));
+        c = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), c, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1.0f)));
+
+        // Odd quadrants swap sine and cosine, the sign bits follow from bit 1 of q and q + 1
+        const __m256i q = _mm256_cvtps_epi32(quadrant);
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+        const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+        const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+        sin = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+        cos = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+    }
+
+    inline __m256 Sin(__m256 x)
+    {
+        __m256 sin, cos;
+        SinCos(x, sin, cos);
+        return sin;
+    }
+}
+
+void BSplineRenderer::WaveAVX2(const DeformationArrays& arrays, int count, float time, float amplitude)
+{
+    const __m256 phase = _mm256_set1_ps(WAVE_FREQUENCY * time);
+    const __m256 indexPhase = _mm256_set1_ps(WAVE_INDEX_PHASE);
+    const __m256 scale = _mm256_set1_ps(amplitude);
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        const __m256 offset = _mm256_mul_ps(scale, Sin(_mm256_fmadd_ps(indexPhase, _mm256_loadu_ps(arrays.index + i), phase)));
+
+        _mm256_storeu_ps(arrays.pose[0] + i, _mm256_loadu_ps(arrays.rest[0] + i));
+        _mm256_storeu_ps(arrays.pose[1] + i, _mm256_add_ps(_mm256_loadu_ps(arrays.rest[1] + i), offset));
+        _mm256_storeu_ps(arrays.pose[2] + i, _mm256_loadu_ps(arrays.rest[2] + i));
+    }
+
+    const DeformationArrays tail{
+        { arrays.rest[0] + vectorCount, arrays.rest[1] + vectorCount, arrays.rest[2] + vectorCount },
+        arrays.index + vectorCount,
+        { arrays.pose[0] + vectorCount, arrays.pose[1] + vectorCount, arrays.pose[2] + vectorCount },
+    };
+
+    WaveScalar(tail, count - vectorCount, time, amplitude);
+}
+
+void BSplineRenderer::SpiralAVX2(const DeformationArrays& arrays, int count, float time, float amplitude)
+{
+    const __m256 angle = _mm256_set1_ps(SPIRAL_ANGULAR_SPEED * time);
+    const __m256 indexAngle = _mm256_set1_ps(SPIRAL_INDEX_ANGLE);
+    const __m256 phase = _mm256_set1_ps(time);
+    const __m256 indexPhase = _mm256_set1_ps(SPIRAL_INDEX_PHASE);
+    const __m256 scale = _mm256_set1_ps(SPIRAL_AMPLITUDE * amplitude);
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        const __m256 index = _mm256_loadu_ps(arrays.index + i);
+        const __m256 x = _mm256_loadu_ps(arrays.rest[0] + i);
+        const __m256 z = _mm256_loadu_ps(arrays.rest[2] + i);
+
+        __m256 sin, cos;
+        SinCos(_mm256_fmadd_ps(indexAngle, index, angle), sin, cos);
+
+        const __m256 offset = _mm256_mul_ps(scale, Sin(_mm256_fmadd_ps(indexPhase, index, phase)));
+
+        _mm256_storeu_ps(arrays.pose[0] + i, _mm256_fmadd_ps(cos, x, _mm256_mul_ps(sin, z)));
+        _mm256_storeu_ps(arrays.pose[1] + i, _mm256_add_ps(_mm256_loadu_ps(arrays.rest[1] + i), offset));
+        _mm256_storeu_ps(arrays.pose[2] + i, _mm256_fmsub_ps(cos, z, _mm256_mul_ps(sin, x)));
+    }
+
+    const DeformationArrays tail{
+        { arrays.rest[0] + vectorCount, arrays.rest[1] + vectorCount, arrays.rest[2] + vectorCount },
+        arrays.index + vectorCount,
+        { arrays.pose[0] + vectorCount, arrays.pose[1] + vectorCount, arrays.pose[2] + vectorCount },
+    };
+
+    SpiralScalar(tail, count - vectorCount, time, amplitude);
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+// Internal to KnotDeformer, shared by the scalar and the vectorized kernels
+
+namespace BSplineRenderer
+{
+    struct DeformationArrays
+    {
+        const float* rest[3];
+        const float* index;
+        float* pose[3];
+    };
+
+    // Deforms entries [0, count) of the arrays
+    using DeformationKernel = void (*)(const DeformationArrays& arrays, int count, float time, float amplitude);
+
+    void WaveScalar(const DeformationArrays& arrays, int count, float time, float amplitude);
+    void SpiralScalar(const DeformationArrays& arrays, int count, float time, float amplitude);
+
+#if defined(BR_AVX2_KERNEL)
+    void WaveAVX2(const DeformationArrays& arrays, int count, float time, float amplitude);
+    void SpiralAVX2(const DeformationArrays& arrays, int count, float time, float amplitude);
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    void WaveNEON(const DeformationArrays& arrays, int count, float time, float amplitude);
+    void SpiralNEON(const DeformationArrays& arrays, int count, float time, float amplitude);
+#endif
+
+    // Cody-Waite split of pi / 2 and minimax coefficients of sin and cos on [-pi / 4, pi / 4], as in Cephes sinf
+    constexpr float SINCOS_TWO_OVER_PI = 0.636619772f;
+    constexpr float SINCOS_PI_OVER_TWO_HI = 1.5703125f;
+    constexpr float SINCOS_PI_OVER_TWO_MID = 4.837512969970703125e-4f;
+    constexpr float SINCOS_PI_OVER_TWO_LO = 7.54978995489188216e-8f;
+    constexpr float SIN_C0 = -1.6666654611e-1f;
+    constexpr float SIN_C1 = 8.3321608736e-3f;
+    constexpr float SIN_C2 = -1.9515295891e-4f;
+    constexpr float COS_C0 = 4.166664568298827e-2f;
+    constexpr float COS_C1 = -1.388731625493765e-3f;
+    constexpr float COS_C2 = 2.443315711809948e-5f;
+
+    // Parameters of the deformations, degrees are converted to radians once
+    constexpr float WAVE_FREQUENCY = 2.0f;
+    constexpr float WAVE_INDEX_PHASE = 0.5f;
+    constexpr float SPIRAL_ANGULAR_SPEED = 20.0f * 0.0174532925f;
+    constexpr float SPIRAL_INDEX_ANGLE = 10.0f * 0.0174532925f;
+    constexpr float SPIRAL_INDEX_PHASE = 0.3f;
+    constexpr float SPIRAL_AMPLITUDE = 0.5f;
+}
@@ -0,0 +1,109 @@
+#include "Curve/KnotDeformerKernel.h"
+
+// NEON is part of the AArch64 baseline, no CPU check is needed
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace
+{
+    using namespace BSplineRenderer;
+
+    constexpr int LANES = 4;
+
+    // Sine and cosine of x, same reduction and polynomials as the AVX2 kernel
+    inline void SinCos(float32x4_t x, float32x4_t& sin, float32x4_t& cos)
+    {
+        const int32x4_t q = vcvtnq_s32_f32(vmulq_n_f32(x, SINCOS_TWO_OVER_PI));
+        const float32x4_t quadrant = vcvtq_f32_s32(q);
+
+        float32x4_t r = vfmsq_f32(x, quadrant, vdupq_n_f32(SINCOS_PI_OVER_TWO_HI));
+        r = vfmsq_f32(r, quadrant, vdupq_n_f32(SINCOS_PI_OVER_TWO_MID));
+        r = vfmsq_f32(r, quadrant, vdupq_n_f32(SINCOS_PI_OVER_TWO_LO));
+
+        const float32x4_t r2 = vmulq_f32(r, r);
+
+        float32x4_t s = vfmaq_f32(vdupq_n_f32(SIN_C1), r2, vdupq_n_f32(SIN_C2));
+        s = vfmaq_f32(vdupq_n_f32(SIN_C0), r2, s);
+        s = vfmaq_f32(r, vmulq_f32(r2, r), s);
+
+        float32x4_t c = vfmaq_f32(vdupq_n_f32(COS_C1), r2, vdupq_n_f32(COS_C2));
+        c = vfmaq_f32(vdupq_n_f32(COS_C0), r2, c);
+        c = vfmaq_f32(vfmsq_f32(vdupq_n_f32(1.0f), vdupq_n_f32(0.5f), r2), vmulq_f32(r2, r2), c);
+
+        // Odd quadrants swap sine and cosine, the sign bits follow from bit 1 of q and q + 1
+        const uint32x4_t swap = vtstq_s32(q, vdupq_n_s32(1));
+        const uint32x4_t sinSign = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(q), vdupq_n_u32(2)), 30);
+        const uint32x4_t cosSign = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(vaddq_s32(q, vdupq_n_s32(1))), vdupq_n_u32(2)), 30);
+
+        sin = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vbslq_f32(swap, c, s)), sinSign));
+        cos = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vbslq_f32(swap, s, c)), cosSign));
+    }
+
+    inline float32x4_t Sin(float32x4_t x)
+    {
+        float32x4_t sin, cos;
+        SinCos(x, sin, cos);
+        return sin;
+    }
+}
+
+void BSplineRenderer::WaveNEON(const DeformationArrays& arrays, int count, float time, float amplitude)
+{
+    const float32x4_t phase = vdupq_n_f32(WAVE_FREQUENCY * time);
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        const float32x4_t offset = vmulq_n_f32(Sin(vfmaq_n_f32(phase, vld1q_f32(arrays.index + i), WAVE_INDEX_PHASE)), amplitude);
+
+        vst1q_f32(arrays.pose[0] + i, vld1q_f32(arrays.rest[0] + i));
+        vst1q_f32(arrays.pose[1] + i, vaddq_f32(vld1q_f32(arrays.rest[1] + i), offset));
+        vst1q_f32(arrays.pose[2] + i, vld1q_f32(arrays.rest[2] + i));
+    }
+
+    const DeformationArrays tail{
+        { arrays.rest[0] + vectorCount, arrays.rest[1] + vectorCount, arrays.rest[2] + vectorCount },
+        arrays.index + vectorCount,
+        { arrays.pose[0] + vectorCount, arrays.pose[1] + vectorCount, arrays.pose[2] + vectorCount },
+    };
+
+    WaveScalar(tail, count - vectorCount, time, amplitude);
+}
+
+void BSplineRenderer::SpiralNEON(const DeformationArrays& arrays, int count, float time, float amplitude)
+{
+    const float32x4_t angle = vdupq_n_f32(SPIRAL_ANGULAR_SPEED * time);
+    const float32x4_t phase = vdupq_n_f32(time);
+    const float scale = SPIRAL_AMPLITUDE * amplitude;
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        const float32x4_t index = vld1q_f32(arrays.index + i);
+        const float32x4_t x = vld1q_f32(arrays.rest[0] + i);
+        const float32x4_t z = vld1q_f32(arrays.rest[2] + i);
+
+        float32x4_t sin, cos;
+        SinCos(vfmaq_n_f32(angle, index, SPIRAL_INDEX_ANGLE), sin, cos);
+
+        const float32x4_t offset = vmulq_n_f32(Sin(vfmaq_n_f32(phase, index, SPIRAL_INDEX_PHASE)), scale);
+
+        vst1q_f32(arrays.pose[0] + i, vfmaq_f32(vmulq_f32(sin, z), cos, x));
+        vst1q_f32(arrays.pose[1] + i, vaddq_f32(vld1q_f32(arrays.rest[1] + i), offset));
+        vst1q_f32(arrays.pose[2] + i, vfmsq_f32(vmulq_f32(cos, z), sin, x));
+    }
+
+    const DeformationArrays tail{
+        { arrays.rest[0] + vectorCount, arrays.rest[1] + vectorCount, arrays.rest[2] + vectorCount },
+        arrays.index + vectorCount,
+        { arrays.pose[0] + vectorCount, arrays.pose[1] + vectorCount, arrays.pose[2] + vectorCount },
+    };
+
+    SpiralScalar(tail, count - vectorCount, time, amplitude);
+}
+
+#endif
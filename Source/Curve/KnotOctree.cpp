@@ -0,0 +1,821 @@
+#include "KnotOctree.h"
+
+#include "Util/Frustum.h"
+#include "Util/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace
+{
+    // Half diagonal of a cube over its half size
+    constexpr float SQRT_3 = 1.7320508f;
+
+    constexpr int CURVES_PER_JOB = 256;
+
+    bool IsFinite(const QVector3D& position)
+    {
+        return std::isfinite(position.x()) && std::isfinite(position.y()) && std::isfinite(position.z());
+    }
+
+    // Distance from the point to the ray with t >= 0
+    float DistanceToRay(const QVector3D& point, const QVector3D& origin, const QVector3D& direction)
+    {
+        const QVector3D difference = point - origin;
+        const float t = std::max(0.0f, QVector3D::dotProduct(difference, direction));
+
+        return (difference - t * direction).length();
+    }
+
+    bool IsInside(const QVector3D& min, const QVector3D& max, const QVector3D& position)
+    {
+        return min.x() <= position.x() && position.x() <= max.x() &&
+               min.y() <= position.y() && position.y() <= max.y() &&
+               min.z() <= position.z() && position.z() <= max.z();
+    }
+}
+
+template <typename Function>
+void BSplineRenderer::KnotOctree::Tree::QueryBox(const QVector3D& min, const QVector3D& max, const Function& function) const
+{
+    if (mRoot < 0)
+    {
+        return;
+    }
+
+    std::vector<int> stack{ mRoot };
+
+    while (stack.empty() == false)
+    {
+        const Node& node = mNodes[stack.back()];
+        stack.pop_back();
+
+        bool overlaps = node.count > 0;
+
+        for (int i = 0; i < 3 && overlaps; ++i)
+        {
+            overlaps = node.center[i] - node.halfSize <= max[i] && min[i] <= node.center[i] + node.halfSize;
+        }
+
+        if (overlaps == false)
+        {
+            continue;
+        }
+
+        if (node.leaf)
+        {
+            for (const int item : node.items)
+            {
+                function(item, mItems[item].position);
+            }
+
+            continue;
+        }
+
+        for (const int child : node.children)
+        {
+            if (child >= 0)
+            {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+void BSplineRenderer::KnotOctree::Update(const QVector<SplinePtr>& curves)
+{
+    for (auto& [id, entry] : mEntries)
+    {
+        entry.alive = false;
+    }
+
+    struct Job
+    {
+        Entry* entry;
+
+        // Last version refreshed
+        unsigned long long version;
+        int moves;
+    };
+
+    QVector<Job> jobs;
+    std::vector<unsigned long long> ids;
+    ids.reserve(curves.size());
+    mMaxRadius = 0.0f;
+
+    for (const auto& curve : curves)
+    {
+        Entry& entry = mEntries[curve->GetId()];
+        entry.curve = curve;
+        entry.alive = true;
+        mMaxRadius = std::max(mMaxRadius, curve->GetRadius());
+
+        // The knots are kept in model space, the model matrix only moves the world bounds
+        if (entry.version != curve->GetVersion() || entry.tree.GetItemCount() != curve->GetKnotCount())
+        {
+            jobs << Job{ &entry, entry.version, 0 };
+            entry.version = curve->GetVersion();
+        }
+
+        ids.push_back(curve->GetId());
+    }
+
+    for (auto it = mEntries.begin(); it != mEntries.end();)
+    {
+        if (it->second.alive == false)
+        {
+            it = mEntries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // Every curve has its own tree, they are refreshed on all cores
+    JobSystem::Instance().Map(jobs, [](Job& job) {
+        const Spline& curve = *job.entry->curve;
+        const auto& knots = curve.GetKnots();
+
+        if (job.entry->tree.GetItemCount() != knots.size())
+        {
+            job.entry->tree.Rebuild(knots);
+            job.moves = knots.size();
+            return;
+        }
+
+        // Patch i spans from knot i to knot i + 1, the knots in between did not move
+        int firstPatch = 0;
+        int lastPatch = -1;
+        curve.GetChangedPatches(job.version, firstPatch, lastPatch);
+
+        if (firstPatch <= lastPatch)
+        {
+            job.moves = job.entry->tree.Refresh(knots, firstPatch, std::min<int>(lastPatch + 1, knots.size() - 1));
+        }
+    });
+
+    mMoveCount = 0;
+
+    for (const Job& job : jobs)
+    {
+        mMoveCount += job.moves;
+    }
+
+    // The model matrices may change every frame without a new version, the world bounds are always recomputed
+    const int count = curves.size();
+    mInstances.resize(count);
+    mCurveBoxes.resize(count);
+
+    JobSystem::Instance().ParallelFor(count, CURVES_PER_JOB, [this, &curves](int first, int size) {
+        for (int index = first; index < first + size; ++index)
+        {
+            const SplinePtr& curve = curves[index];
+            const QMatrix4x4& modelMatrix = curve->GetModelMatrix();
+            bool invertible = false;
+
+            Instance& instance = mInstances[index];
+            instance.entry = &mEntries.at(curve->GetId());
+            instance.modelMatrix = modelMatrix;
+            instance.inverseModelMatrix = modelMatrix.inverted(&invertible);
+            instance.scale = invertible ? modelMatrix.column(0).toVector3D().length() : 0.0f;
+
+            Bvh::Box& box = mCurveBoxes[index];
+            box = Bvh::Box();
+
+            // The knots are the ends of the patches
+            if (instance.entry->tree.GetKnotCount() > 0)
+            {
+                const auto [min, max] = curve->GetPatchBounds();
+                Frustum::Transform(modelMatrix, min, max, 0.0f, box.min, box.max);
+            }
+        }
+    });
+
+    if (ids == mCurveIds)
+    {
+        mCurveBvh.Refit(mCurveBoxes, 0, count - 1);
+    }
+    else
+    {
+        mCurveBvh.Build(mCurveBoxes);
+        mCurveIds = std::move(ids);
+    }
+
+    mKnotCount = 0;
+
+    for (const auto& [id, entry] : mEntries)
+    {
+        mKnotCount += entry.tree.GetKnotCount();
+    }
+}
+
+bool BSplineRenderer::KnotOctree::IntersectRay(const QVector3D& origin, const QVector3D& direction, float radiusScale, KnotHit& hit) const
+{
+    float best = radiusScale * mMaxRadius;
+    float maxT = INFINITY;
+    int bestInstance = -1;
+    int bestKnot = -1;
+
+    // Only the distance to the ray is minimized, the curves are never pruned along it
+    mCurveBvh.Traverse(origin, direction, best, maxT, [&](int index, float&) {
+        const Instance& instance = mInstances[index];
+
+        if (instance.scale <= 0.0f)
+        {
+            return;
+        }
+
+        // Model space distances are the world space distances over the scale
+        const QVector3D modelOrigin = instance.inverseModelMatrix.map(origin);
+        const QVector3D modelDirection = instance.inverseModelMatrix.mapVector(direction).normalized();
+        float modelBest = std::min(best, radiusScale * instance.entry->curve->GetRadius()) / instance.scale;
+
+        if (const int knot = instance.entry->tree.IntersectRay(modelOrigin, modelDirection, modelBest); knot >= 0)
+        {
+            best = modelBest * instance.scale;
+            bestInstance = index;
+            bestKnot = knot;
+        }
+    });
+
+    if (bestInstance < 0)
+    {
+        return false;
+    }
+
+    hit = MakeHit(mInstances[bestInstance], bestKnot, best);
+
+    return hit.knot != nullptr;
+}
+
+QVector<BSplineRenderer::KnotHit> BSplineRenderer::KnotOctree::QueryRadius(const QVector3D& center, float radius) const
+{
+    QVector<KnotHit> hits;
+    const QVector3D extent(radius, radius, radius);
+
+    mCurveBvh.Query(Bvh::Box{ center - extent, center + extent }, [&](int index) {
+        const Instance& instance = mInstances[index];
+
+        if (instance.scale <= 0.0f)
+        {
+            return;
+        }
+
+        const QVector3D modelCenter = instance.inverseModelMatrix.map(center);
+        const QVector3D modelExtent = extent / instance.scale;
+
+        // The knots are compared in world space, like the query
+        instance.entry->tree.QueryBox(modelCenter - modelExtent, modelCenter + modelExtent, [&](int knot, const QVector3D& position) {
+            const float distance = (instance.modelMatrix.map(position) - center).length();
+
+            if (distance <= radius)
+            {
+                if (KnotHit hit = MakeHit(instance, knot, distance); hit.knot)
+                {
+                    hits << hit;
+                }
+            }
+        });
+    });
+
+    return hits;
+}
+
+QVector<BSplineRenderer::KnotHit> BSplineRenderer::KnotOctree::QueryBox(const QVector3D& min, const QVector3D& max) const
+{
+    QVector<KnotHit> hits;
+    const QVector3D center = 0.5f * (min + max);
+
+    mCurveBvh.Query(Bvh::Box{ min, max }, [&](int index) {
+        const Instance& instance = mInstances[index];
+
+        if (instance.scale <= 0.0f)
+        {
+            return;
+        }
+
+        // Bounds of the box in model space, the knots are compared in world space
+        QVector3D modelMin;
+        QVector3D modelMax;
+        Frustum::Transform(instance.inverseModelMatrix, min, max, 0.0f, modelMin, modelMax);
+
+        instance.entry->tree.QueryBox(modelMin, modelMax, [&](int knot, const QVector3D& position) {
+            const QVector3D worldPosition = instance.modelMatrix.map(position);
+
+            if (IsInside(min, max, worldPosition))
+            {
+                if (KnotHit hit = MakeHit(instance, knot, (worldPosition - center).length()); hit.knot)
+                {
+                    hits << hit;
+                }
+            }
+        });
+    });
+
+    return hits;
+}
+
+int BSplineRenderer::KnotOctree::Tree::Refresh(const QVector<KnotPtr>& knots, int firstKnot, int lastKnot)
+{
+    int moves = 0;
+
+    for (int knot = firstKnot; knot <= lastKnot; ++knot)
+    {
+        Item& item = mItems[knot];
+        item.position = knots[knot]->GetPosition();
+
+        if (item.node < 0 || Contains(mNodes[item.node], item.position) == false)
+        {
+            Remove(knot);
+            Insert(knot);
+            ++moves;
+        }
+    }
+
+    Compact();
+
+    return moves;
+}
+
+void BSplineRenderer::KnotOctree::Tree::Rebuild(const QVector<KnotPtr>& knots)
+{
+    mItems.assign(knots.size(), Item{});
+    mNodes.clear();
+    mFreeNodes.clear();
+    mCompactions.clear();
+    mRoot = -1;
+
+    for (int knot = 0; knot < knots.size(); ++knot)
+    {
+        mItems[knot].position = knots[knot]->GetPosition();
+        Insert(knot);
+    }
+
+    Compact();
+}
+
+int BSplineRenderer::KnotOctree::Tree::IntersectRay(const QVector3D& origin, const QVector3D& direction, float& best) const
+{
+    if (mRoot < 0)
+    {
+        return -1;
+    }
+
+    struct Candidate
+    {
+        float bound;
+        int node;
+
+        bool operator>(const Candidate& other) const { return bound > other.bound; }
+    };
+
+    // Best first by the lower bound of the distance of a node's knots to the ray
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+    candidates.push(Candidate{ 0.0f, mRoot });
+
+    int bestItem = -1;
+
+    while (candidates.empty() == false)
+    {
+        const Candidate candidate = candidates.top();
+        candidates.pop();
+
+        if (candidate.bound >= best)
+        {
+            break;
+        }
+
+        const Node& node = mNodes[candidate.node];
+
+        if (node.leaf)
+        {
+            for (const int index : node.items)
+            {
+                const QVector3D difference = mItems[index].position - origin;
+                const float t = QVector3D::dotProduct(difference, direction);
+
+                if (t < 0.0f)
+                {
+                    continue;
+                }
+
+                const float distance = (difference - t * direction).length();
+
+                if (distance < best)
+                {
+                    best = distance;
+                    bestItem = index;
+                }
+            }
+
+            continue;
+        }
+
+        for (const int child : node.children)
+        {
+            if (child >= 0 && mNodes[child].count > 0)
+            {
+                const float bound = DistanceToRay(mNodes[child].center, origin, direction) - SQRT_3 * mNodes[child].halfSize;
+
+                if (bound < best)
+                {
+                    candidates.push(Candidate{ bound, child });
+                }
+            }
+        }
+    }
+
+    return bestItem;
+}
+
+void BSplineRenderer::KnotOctree::Tree::Insert(int item)
+{
+    const QVector3D position = mItems[item].position;
+
+    // A knot at infinity would grow the root forever
+    if (IsFinite(position) == false)
+    {
+        mItems[item].node = -1;
+        return;
+    }
+
+    if (mRoot < 0)
+    {
+        mRoot = CreateNode(position, 1.0f, -1);
+    }
+
+    while (Contains(mNodes[mRoot], position) == false)
+    {
+        GrowRoot(position);
+    }
+
+    int node = mRoot;
+
+    while (mNodes[node].leaf == false)
+    {
+        ++mNodes[node].count;
+        node = GetChild(node, GetOctant(mNodes[node], position));
+    }
+
+    Node& leaf = mNodes[node];
+    ++leaf.count;
+    mItems[item].node = node;
+    mItems[item].slot = leaf.items.size();
+    leaf.items.push_back(item);
+
+    if (leaf.items.size() > LEAF_CAPACITY && leaf.halfSize > MIN_HALF_SIZE)
+    {
+        Split(node);
+    }
+}
+
+void BSplineRenderer::KnotOctree::Tree::Remove(int item)
+{
+    const int node = mItems[item].node;
+
+    if (node < 0)
+    {
+        return;
+    }
+
+    // Swap with the last item of the leaf
+    std::vector<int>& items = mNodes[node].items;
+    const int last = items.back();
+    items[mItems[item].slot] = last;
+    mItems[last].slot = mItems[item].slot;
+    items.pop_back();
+
+    // The topmost subtree that now fits into a leaf, or else the topmost one left empty
+    int compaction = -1;
+    bool collapse = false;
+
+    for (int parent = node; parent >= 0; parent = mNodes[parent].parent)
+    {
+        Node& ancestor = mNodes[parent];
+        --ancestor.count;
+
+        if (ancestor.leaf == false && ancestor.count <= LEAF_CAPACITY)
+        {
+            compaction = parent;
+            collapse = true;
+        }
+        else if (collapse == false && ancestor.count == 0 && ancestor.parent >= 0)
+        {
+            compaction = parent;
+        }
+    }
+
+    if (compaction >= 0)
+    {
+        mCompactions.push_back(compaction);
+    }
+
+    mItems[item].node = -1;
+    mItems[item].slot = -1;
+}
+
+void BSplineRenderer::KnotOctree::Tree::GrowRoot(const QVector3D& position)
+{
+    // The old root becomes the octant of the new root facing away from the position
+    const QVector3D center = mNodes[mRoot].center;
+    const float halfSize = mNodes[mRoot].halfSize;
+
+    QVector3D newCenter;
+    int octant = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (position[i] >= center[i])
+        {
+            newCenter[i] = center[i] + halfSize;
+        }
+        else
+        {
+            newCenter[i] = center[i] - halfSize;
+            octant |= 1 << i;
+        }
+    }
+
+    // A leaf root only holds a few knots, it grows in place instead
+    if (mNodes[mRoot].leaf)
+    {
+        mNodes[mRoot].center = newCenter;
+        mNodes[mRoot].halfSize = 2.0f * halfSize;
+        return;
+    }
+
+    const int root = CreateNode(newCenter, 2.0f * halfSize, -1);
+    mNodes[root].leaf = false;
+    mNodes[root].children[octant] = mRoot;
+    mNodes[root].count = mNodes[mRoot].count;
+    mNodes[mRoot].parent = root;
+    mRoot = root;
+
+    // The knots removed before may have left the old root small enough for a leaf
+    if (mNodes[root].count <= LEAF_CAPACITY)
+    {
+        mCompactions.push_back(root);
+    }
+}
+
+void BSplineRenderer::KnotOctree::Tree::Split(int node)
+{
+    const std::vector<int> items = std::move(mNodes[node].items);
+    mNodes[node].items.clear();
+    mNodes[node].leaf = false;
+
+    for (const int item : items)
+    {
+        const int child = GetChild(node, GetOctant(mNodes[node], mItems[item].position));
+        Node& leaf = mNodes[child];
+        ++leaf.count;
+        mItems[item].node = child;
+        mItems[item].slot = leaf.items.size();
+        leaf.items.push_back(item);
+    }
+
+    for (int octant = 0; octant < 8; ++octant)
+    {
+        const int child = mNodes[node].children[octant];
+
+        if (child >= 0 && mNodes[child].items.size() > LEAF_CAPACITY && mNodes[child].halfSize > MIN_HALF_SIZE)
+        {
+            Split(child);
+        }
+    }
+}
+
+void BSplineRenderer::KnotOctree::Tree::Compact()
+{
+    // Larger subtrees first, they may contain the smaller ones
+    std::sort(mCompactions.begin(), mCompactions.end(), [this](int a, int b) { return mNodes[a].halfSize > mNodes[b].halfSize; });
+
+    std::vector<int> stack;
+
+    for (const int compaction : mCompactions)
+    {
+        // Dropped by an earlier compaction
+        if (IsLinked(compaction) == false)
+        {
+            continue;
+        }
+
+        // The insertions since Remove() may have filled the subtree again, its parts are checked instead
+        stack.push_back(compaction);
+
+        while (stack.empty() == false)
+        {
+            const int node = stack.back();
+            stack.pop_back();
+
+            if (mNodes[node].count == 0 && mNodes[node].parent >= 0)
+            {
+                Node& parent = mNodes[mNodes[node].parent];
+                parent.children[GetOctant(parent, mNodes[node].center)] = -1;
+                FreeSubtree(node);
+            }
+            else if (mNodes[node].leaf == false && mNodes[node].count <= LEAF_CAPACITY)
+            {
+                Collapse(node);
+            }
+            else if (mNodes[node].leaf == false)
+            {
+                for (const int child : mNodes[node].children)
+                {
+                    if (child >= 0)
+                    {
+                        stack.push_back(child);
+                    }
+                }
+            }
+        }
+    }
+
+    mCompactions.clear();
+
+    ShrinkRoot();
+}
+
+void BSplineRenderer::KnotOctree::Tree::Collapse(int node)
+{
+    std::vector<int> items;
+    std::vector<int> stack(std::begin(mNodes[node].children), std::end(mNodes[node].children));
+
+    while (stack.empty() == false)
+    {
+        const int descendant = stack.back();
+        stack.pop_back();
+
+        if (descendant < 0)
+        {
+            continue;
+        }
+
+        const Node& subtree = mNodes[descendant];
+        items.insert(items.end(), subtree.items.begin(), subtree.items.end());
+        stack.insert(stack.end(), std::begin(subtree.children), std::end(subtree.children));
+    }
+
+    for (int& child : mNodes[node].children)
+    {
+        if (child >= 0)
+        {
+            FreeSubtree(child);
+            child = -1;
+        }
+    }
+
+    Node& leaf = mNodes[node];
+    leaf.leaf = true;
+    leaf.items = std::move(items);
+
+    for (int slot = 0; slot < int(leaf.items.size()); ++slot)
+    {
+        mItems[leaf.items[slot]].node = node;
+        mItems[leaf.items[slot]].slot = slot;
+    }
+}
+
+void BSplineRenderer::KnotOctree::Tree::ShrinkRoot()
+{
+    if (mRoot >= 0 && mNodes[mRoot].count == 0)
+    {
+        mNodes.clear();
+        mFreeNodes.clear();
+        mRoot = -1;
+        return;
+    }
+
+    while (mRoot >= 0 && mNodes[mRoot].leaf == false)
+    {
+        int only = -1;
+
+        for (const int child : mNodes[mRoot].children)
+        {
+            if (child >= 0 && mNodes[child].count == mNodes[mRoot].count)
+            {
+                only = child;
+            }
+        }
+
+        if (only < 0)
+        {
+            return;
+        }
+
+        // The other children are empty
+        for (int& child : mNodes[mRoot].children)
+        {
+            if (child >= 0 && child != only)
+            {
+                FreeSubtree(child);
+            }
+
+            child = -1;
+        }
+
+        const int root = mRoot;
+        mRoot = only;
+        mNodes[mRoot].parent = -1;
+        FreeSubtree(root);
+    }
+}
+
+bool BSplineRenderer::KnotOctree::Tree::IsLinked(int node) const
+{
+    const int parent = mNodes[node].parent;
+
+    if (parent < 0)
+    {
+        return node == mRoot;
+    }
+
+    return mNodes[parent].children[GetOctant(mNodes[parent], mNodes[node].center)] == node;
+}
+
+int BSplineRenderer::KnotOctree::Tree::CreateNode(const QVector3D& center, float halfSize, int parent)
+{
+    Node node;
+    node.center = center;
+    node.halfSize = halfSize;
+    node.parent = parent;
+
+    if (mFreeNodes.empty() == false)
+    {
+        const int index = mFreeNodes.back();
+        mFreeNodes.pop_back();
+        mNodes[index] = std::move(node);
+
+        return index;
+    }
+
+    mNodes.push_back(std::move(node));
+
+    return mNodes.size() - 1;
+}
+
+void BSplineRenderer::KnotOctree::Tree::FreeSubtree(int node)
+{
+    std::vector<int> stack{ node };
+
+    while (stack.empty() == false)
+    {
+        const int index = stack.back();
+        stack.pop_back();
+
+        for (const int child : mNodes[index].children)
+        {
+            if (child >= 0)
+            {
+                stack.push_back(child);
+            }
+        }
+
+        mNodes[index] = Node{};
+        mNodes[index].parent = -1;
+        mFreeNodes.push_back(index);
+    }
+}
+
+int BSplineRenderer::KnotOctree::Tree::GetChild(int node, int octant)
+{
+    if (mNodes[node].children[octant] >= 0)
+    {
+        return mNodes[node].children[octant];
+    }
+
+    const float halfSize = 0.5f * mNodes[node].halfSize;
+    QVector3D center = mNodes[node].center;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        center[i] += (octant & (1 << i)) ? halfSize : -halfSize;
+    }
+
+    const int child = CreateNode(center, halfSize, node);
+    mNodes[node].children[octant] = child;
+
+    return child;
+}
+
+bool BSplineRenderer::KnotOctree::Contains(const Node& node, const QVector3D& position)
+{
+    return std::abs(position.x() - node.center.x()) <= node.halfSize &&
+           std::abs(position.y() - node.center.y()) <= node.halfSize &&
+           std::abs(position.z() - node.center.z()) <= node.halfSize;
+}
+
+BSplineRenderer::KnotHit BSplineRenderer::KnotOctree::MakeHit(const Instance& instance, int knot, float distance) const
+{
+    // The curve may have lost knots since the last Update()
+    const auto& knots = instance.entry->curve->GetKnots();
+
+    return KnotHit{ instance.entry->curve, knot < knots.size() ? knots[knot] : nullptr, distance };
+}
+
+int BSplineRenderer::KnotOctree::GetOctant(const Node& node, const QVector3D& position)
+{
+    return (position.x() >= node.center.x() ? 1 : 0) | (position.y() >= node.center.y() ? 2 : 0) | (position.z() >= node.center.z() ? 4 : 0);
+}
\ No newline at end of file
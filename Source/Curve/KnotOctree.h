@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Curve/Spline.h"
+#include "Util/Bvh.h"
+#include "Util/Macros.h"
+
+#include <QMatrix4x4>
+#include <QVector>
+#include <unordered_map>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    struct KnotHit
+    {
+        SplinePtr curve{ nullptr };
+        KnotPtr knot{ nullptr };
+
+        // Distance to the ray or to the center of the query
+        float distance{ 0.0f };
+    };
+
+    // Knot picking on the CPU. Every curve keeps the model space positions of its knots in a point octree,
+    // and a Bvh over the world space bounds of the curves is rebuilt when the curves are added or removed,
+    // like CurveBvh. Queries are mapped into the model space of the curves they reach, so a new model matrix
+    // only moves the curve's world bounds. Update() refreshes the knots of the patches changed since the
+    // last version of a curve, knots staying in their leaf are updated in place and only the others are moved
+    // between leaves. Leaves are split when they hold more than LEAF_CAPACITY knots and the root grows towards
+    // knots outside of it. Once the knots are moved, subtrees left with at most LEAF_CAPACITY knots are collapsed
+    // into a leaf, empty subtrees are dropped and the root shrinks to its only non-empty child.
+    class KnotOctree
+    {
+        DISABLE_COPY(KnotOctree);
+
+      public:
+        KnotOctree() = default;
+
+        // Refreshes the changed curves in parallel on the JobSystem, the curves must be up to date
+        void Update(const QVector<SplinePtr>& curves);
+
+        // Knot with the smallest distance to the ray among the knots in front of the origin closer than
+        // radiusScale times the radius of their curve. The direction must be normalized.
+        bool IntersectRay(const QVector3D& origin, const QVector3D& direction, float radiusScale, KnotHit& hit) const;
+
+        QVector<KnotHit> QueryRadius(const QVector3D& center, float radius) const;
+        QVector<KnotHit> QueryBox(const QVector3D& min, const QVector3D& max) const;
+
+        int GetKnotCount() const { return mKnotCount; }
+
+        // Knots moved between leaves by the last Update()
+        int GetMoveCount() const { return mMoveCount; }
+
+        static constexpr int LEAF_CAPACITY = 32;
+
+        // Leaves smaller than this are not split further, e.g. for coincident knots
+        static constexpr float MIN_HALF_SIZE = 1e-3f;
+
+      private:
+        struct Item
+        {
+            QVector3D position;
+
+            // Leaf and position in its item list, -1 if the knot is not in the tree
+            int node{ -1 };
+            int slot{ -1 };
+        };
+
+        struct Node
+        {
+            QVector3D center;
+            float halfSize;
+            int parent;
+
+            // Knots in the subtree
+            int count{ 0 };
+
+            // -1 if absent, all -1 for leaves
+            int children[8]{ -1, -1, -1, -1, -1, -1, -1, -1 };
+            bool leaf{ true };
+
+            std::vector<int> items;
+        };
+
+        // Octree over the knots of one curve in model space, the item of a knot is its index in the curve
+        class Tree
+        {
+          public:
+            // Moves the knots in [firstKnot, lastKnot] to their new positions, returns the number moved between leaves
+            int Refresh(const QVector<KnotPtr>& knots, int firstKnot, int lastKnot);
+            void Rebuild(const QVector<KnotPtr>& knots);
+
+            // Knot closest to the ray and closer than best, which is lowered to its distance. -1 if there is none.
+            int IntersectRay(const QVector3D& origin, const QVector3D& direction, float& best) const;
+
+            // Calls function(knot, position) for the knots whose leaves overlap the box
+            template <typename Function>
+            void QueryBox(const QVector3D& min, const QVector3D& max, const Function& function) const;
+
+            // Knots in the tree, those at non-finite positions are left out
+            int GetKnotCount() const { return mRoot >= 0 ? mNodes[mRoot].count : 0; }
+            int GetItemCount() const { return int(mItems.size()); }
+
+          private:
+            void Insert(int item);
+            void Remove(int item);
+            void GrowRoot(const QVector3D& position);
+            void Split(int node);
+
+            // Collapses or drops the subtrees found by Remove() and shrinks the root
+            void Compact();
+            void Collapse(int node);
+            void ShrinkRoot();
+            bool IsLinked(int node) const;
+
+            int CreateNode(const QVector3D& center, float halfSize, int parent);
+            void FreeSubtree(int node);
+            int GetChild(int node, int octant);
+
+            std::vector<Item> mItems;
+
+            std::vector<Node> mNodes;
+            std::vector<int> mFreeNodes;
+            int mRoot{ -1 };
+
+            // Left for Compact() by Remove(), roots of subtrees that have become small or empty
+            std::vector<int> mCompactions;
+        };
+
+        struct Entry
+        {
+            SplinePtr curve;
+            unsigned long long version{ 0 };
+            Tree tree;
+            bool alive{ false };
+        };
+
+        struct Instance
+        {
+            const Entry* entry;
+            QMatrix4x4 modelMatrix;
+            QMatrix4x4 inverseModelMatrix;
+
+            // The knots are scaled uniformly by the model matrix, 0 if it is singular
+            float scale;
+        };
+
+        KnotHit MakeHit(const Instance& instance, int knot, float distance) const;
+
+        static bool Contains(const Node& node, const QVector3D& position);
+        static int GetOctant(const Node& node, const QVector3D& position);
+
+        // Keyed by the curve ID, the entries do not move in memory
+        std::unordered_map<unsigned long long, Entry> mEntries;
+
+        std::vector<Instance> mInstances;
+        std::vector<Bvh::Box> mCurveBoxes;
+        Bvh mCurveBvh;
+
+        // Curves of the last rebuild of mCurveBvh
+        std::vector<unsigned long long> mCurveIds;
+
+        float mMaxRadius{ 0.0f };
+        int mKnotCount{ 0 };
+        int mMoveCount{ 0 };
+    };
+}
\ No newline at end of file
@@ -0,0 +1,677 @@
+#include "MeshExporter.h"
+
+#include "Curve/TubeMesh.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+// The binary formats are written in the byte order of the host, all supported targets are little endian
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN);
+
+namespace
+{
+    using namespace BSplineRenderer;
+
+    constexpr int PATCHES_PER_CHUNK = 256;
+    constexpr qint64 COPY_BLOCK_SIZE = 4 * 1024 * 1024;
+
+    // A range of patches of one curve, tessellated and written as a whole
+    struct Chunk
+    {
+        int curve;
+        int firstPatch;
+        int lastPatch;
+
+        // Index of the first vertex of the chunk in the scene and in its curve
+        quint64 sceneVertex;
+        quint64 curveVertex;
+    };
+
+    void AppendFloat(QByteArray& out, float value)
+    {
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr - buffer);
+    }
+
+    void AppendInteger(QByteArray& out, quint64 value)
+    {
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr - buffer);
+    }
+
+    template <typename T>
+    void AppendBinary(QByteArray& out, const T& value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    bool Append(QFile& target, QFile& source)
+    {
+        if (source.flush() == false || source.seek(0) == false)
+        {
+            return false;
+        }
+
+        while (source.atEnd() == false)
+        {
+            const QByteArray block = source.read(COPY_BLOCK_SIZE);
+
+            if (block.isEmpty() || target.write(block) != block.size())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Receives the tessellated chunks in scene order
+    class MeshWriter
+    {
+      public:
+        explicit MeshWriter(const QString& filePath)
+            : mFile(filePath)
+        {}
+
+        virtual ~MeshWriter() = default;
+
+        virtual bool Begin(const QVector<SplineGeometry*>& curves, quint64 vertexCount, quint64 triangleCount) = 0;
+        virtual void BeginCurve(int /*curve*/) {}
+        virtual void Write(const Chunk& chunk, const TubeMesh& mesh) = 0;
+        virtual bool End() = 0;
+
+      protected:
+        bool Open() { return mFile.open(QIODevice::WriteOnly | QIODevice::Truncate); }
+        bool Close()
+        {
+            const bool success = mFile.flush() && mFile.error() == QFileDevice::NoError;
+            mFile.close();
+            return success;
+        }
+
+        QFile mFile;
+    };
+
+    class ObjWriter : public MeshWriter
+    {
+      public:
+        using MeshWriter::MeshWriter;
+
+        bool Begin(const QVector<SplineGeometry*>&, quint64, quint64) override
+        {
+            return Open() && mFile.write("# BSplineRenderer tube mesh\n") > 0;
+        }
+
+        void BeginCurve(int curve) override
+        {
+            QByteArray line = "o Curve_";
+            AppendInteger(line, curve);
+            line.append('\n');
+            mFile.write(line);
+        }
+
+        void Write(const Chunk& chunk, const TubeMesh& mesh) override
+        {
+            QByteArray out;
+            out.reserve(mesh.vertices.size() * 80 + mesh.indices.size() * 12);
+
+            for (const auto& vertex : mesh.vertices)
+            {
+                out.append("v ");
+                AppendVector(out, vertex);
+            }
+
+            for (const auto& normal : mesh.normals)
+            {
+                out.append("vn ");
+                AppendVector(out, normal);
+            }
+
+            // OBJ indices start at 1, each corner uses the normal of the same index
+            for (int i = 0; i < mesh.indices.size(); i += 3)
+            {
+                out.append('f');
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    const quint64 index = chunk.sceneVertex + mesh.indices[i + k] + 1;
+                    out.append(' ');
+                    AppendInteger(out, index);
+                    out.append("//");
+                    AppendInteger(out, index);
+                }
+
+                out.append('\n');
+            }
+
+            mFile.write(out);
+        }
+
+        bool End() override { return Close(); }
+
+      private:
+        static void AppendVector(QByteArray& out, const QVector3D& vector)
+        {
+            AppendFloat(out, vector.x());
+            out.append(' ');
+            AppendFloat(out, vector.y());
+            out.append(' ');
+            AppendFloat(out, vector.z());
+            out.append('\n');
+        }
+    };
+
+    // All vertices must precede all faces, the faces are collected in a temporary file meanwhile
+    class PlyWriter : public MeshWriter
+    {
+      public:
+        using MeshWriter::MeshWriter;
+
+        bool Begin(const QVector<SplineGeometry*>&, quint64 vertexCount, quint64 triangleCount) override
+        {
+            if (Open() == false || mFaces.open() == false)
+            {
+                return false;
+            }
+
+            QByteArray header;
+            header.append("ply\n");
+            header.append("format binary_little_endian 1.0\n");
+            header.append("comment BSplineRenderer tube mesh\n");
+            header.append("element vertex ");
+            AppendInteger(header, vertexCount);
+            header.append("\nproperty float x\nproperty float y\nproperty float z\n");
+            header.append("property float nx\nproperty float ny\nproperty float nz\n");
+            header.append("element face ");
+            AppendInteger(header, triangleCount);
+            header.append("\nproperty list uchar uint vertex_indices\n");
+            header.append("end_header\n");
+
+            return mFile.write(header) == header.size();
+        }
+
+        void Write(const Chunk& chunk, const TubeMesh& mesh) override
+        {
+            QByteArray vertices;
+            vertices.reserve(mesh.vertices.size() * 6 * sizeof(float));
+
+            for (int i = 0; i < mesh.vertices.size(); ++i)
+            {
+                const float vertex[6] = {
+                    mesh.vertices[i].x(), mesh.vertices[i].y(), mesh.vertices[i].z(),
+                    mesh.normals[i].x(), mesh.normals[i].y(), mesh.normals[i].z(),
+                };
+
+                AppendBinary(vertices, vertex);
+            }
+
+            QByteArray faces;
+            faces.reserve(mesh.indices.size() / 3 * (1 + 3 * sizeof(quint32)));
+
+            for (int i = 0; i < mesh.indices.size(); i += 3)
+            {
+                AppendBinary(faces, quint8(3));
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    AppendBinary(faces, quint32(chunk.sceneVertex + mesh.indices[i + k]));
+                }
+            }
+
+            mFile.write(vertices);
+            mFaces.write(faces);
+        }
+
+        bool End() override
+        {
+            const bool success = Append(mFile, mFaces);
+            return Close() && success;
+        }
+
+      private:
+        QTemporaryFile mFaces;
+    };
+
+    class StlWriter : public MeshWriter
+    {
+      public:
+        using MeshWriter::MeshWriter;
+
+        bool Begin(const QVector<SplineGeometry*>&, quint64, quint64 triangleCount) override
+        {
+            if (Open() == false || triangleCount > std::numeric_limits<quint32>::max())
+            {
+                return false;
+            }
+
+            char header[80] = {};
+            std::strncpy(header, "BSplineRenderer tube mesh", sizeof(header));
+
+            QByteArray out(header, sizeof(header));
+            AppendBinary(out, quint32(triangleCount));
+
+            return mFile.write(out) == out.size();
+        }
+
+        void Write(const Chunk&, const TubeMesh& mesh) override
+        {
+            QByteArray out;
+            out.reserve(mesh.indices.size() / 3 * 50);
+
+            for (int i = 0; i < mesh.indices.size(); i += 3)
+            {
+                const QVector3D& a = mesh.vertices[mesh.indices[i]];
+                const QVector3D& b = mesh.vertices[mesh.indices[i + 1]];
+                const QVector3D& c = mesh.vertices[mesh.indices[i + 2]];
+                const QVector3D normal = QVector3D::normal(a, b, c);
+
+                const float facet[12] = {
+                    normal.x(), normal.y(), normal.z(),
+                    a.x(), a.y(), a.z(),
+                    b.x(), b.y(), b.z(),
+                    c.x(), c.y(), c.z(),
+                };
+
+                AppendBinary(out, facet);
+                AppendBinary(out, quint16(0));
+            }
+
+            mFile.write(out);
+        }
+
+        bool End() override { return Close(); }
+    };
+
+    // Attributes are collected in three temporary files and concatenated into the binary chunk at the end,
+    // since the JSON chunk before it needs the bounds and the sizes of every accessor.
+    class GlbWriter : public MeshWriter
+    {
+      public:
+        using MeshWriter::MeshWriter;
+
+        bool Begin(const QVector<SplineGeometry*>& curves, quint64, quint64) override
+        {
+            if (mPositions.open() == false || mNormals.open() == false || mIndices.open() == false)
+            {
+                return false;
+            }
+
+            // The convex hull property bounds each patch by its control points
+            QVector3D min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+            QVector3D max = -min;
+
+            for (const auto& curve : curves)
+            {
+                const QVector3D radius(curve->GetRadius(), curve->GetRadius(), curve->GetRadius());
+
+                for (const auto& point : curve->GetBezierControlPoints())
+                {
+                    const QVector3D lower = point - radius;
+                    const QVector3D upper = point + radius;
+                    min = QVector3D(std::min(min.x(), lower.x()), std::min(min.y(), lower.y()), std::min(min.z(), lower.z()));
+                    max = QVector3D(std::max(max.x(), upper.x()), std::max(max.y(), upper.y()), std::max(max.z(), upper.z()));
+                }
+            }
+
+            // A uniform scale keeps the normals valid
+            const QVector3D extent = max - min;
+            const float halfExtent = 0.5f * std::max({ extent.x(), extent.y(), extent.z() });
+
+            mCenter = 0.5f * (min + max);
+            mScale = halfExtent > 0.0f ? halfExtent / QUANTIZATION_RANGE : 1.0f;
+
+            return true;
+        }
+
+        void BeginCurve(int curve) override
+        {
+            Primitive primitive;
+            primitive.curve = curve;
+            primitive.positionOffset = mPositions.pos();
+            primitive.normalOffset = mNormals.pos();
+            primitive.indexOffset = mIndices.pos();
+            mPrimitives << primitive;
+        }
+
+        void Write(const Chunk& chunk, const TubeMesh& mesh) override
+        {
+            Primitive& primitive = mPrimitives.last();
+
+            QByteArray positions;
+            QByteArray normals;
+            QByteArray indices;
+            positions.reserve(mesh.vertices.size() * 4 * sizeof(qint16));
+            normals.reserve(mesh.vertices.size() * 4 * sizeof(qint8));
+            indices.reserve(mesh.indices.size() * sizeof(quint32));
+
+            for (int i = 0; i < mesh.vertices.size(); ++i)
+            {
+                const QVector3D scaled = (mesh.vertices[i] - mCenter) / mScale;
+                const QVector3D& normal = mesh.normals[i];
+
+                // Padded to 4 components, vertex attributes must be 4-byte aligned
+                qint16 position[4] = { 0, 0, 0, 0 };
+                qint8 packedNormal[4] = { 0, 0, 0, 0 };
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    position[k] = qint16(std::clamp(std::lround(scaled[k]), -long(QUANTIZATION_RANGE), long(QUANTIZATION_RANGE)));
+                    packedNormal[k] = qint8(std::clamp(std::lround(127.0f * normal[k]), -127L, 127L));
+                    primitive.min[k] = std::min(primitive.min[k], int(position[k]));
+                    primitive.max[k] = std::max(primitive.max[k], int(position[k]));
+                }
+
+                AppendBinary(positions, position);
+                AppendBinary(normals, packedNormal);
+            }
+
+            for (const auto& index : mesh.indices)
+            {
+                AppendBinary(indices, quint32(chunk.curveVertex + index));
+            }
+
+            primitive.vertexCount += mesh.vertices.size();
+            primitive.indexCount += mesh.indices.size();
+
+            mPositions.write(positions);
+            mNormals.write(normals);
+            mIndices.write(indices);
+        }
+
+        bool End() override
+        {
+            const qint64 positionsSize = mPositions.pos();
+            const qint64 normalsSize = mNormals.pos();
+            const qint64 indicesSize = mIndices.pos();
+            const qint64 binarySize = positionsSize + normalsSize + indicesSize;
+
+            QByteArray json = CreateJson(positionsSize, normalsSize, indicesSize).toJson(QJsonDocument::Compact);
+
+            while (json.size() % 4 != 0)
+            {
+                json.append(' ');
+            }
+
+            const qint64 totalSize = 12 + 8 + json.size() + (binarySize > 0 ? 8 + binarySize : 0);
+
+            if (totalSize > std::numeric_limits<quint32>::max() || Open() == false)
+            {
+                return false;
+            }
+
+            QByteArray header;
+            AppendBinary(header, quint32(0x46546C67)); // "glTF"
+            AppendBinary(header, quint32(2));
+            AppendBinary(header, quint32(totalSize));
+            AppendBinary(header, quint32(json.size()));
+            AppendBinary(header, quint32(0x4E4F534A)); // "JSON"
+            header.append(json);
+
+            bool success = mFile.write(header) == header.size();
+
+            if (binarySize > 0)
+            {
+                QByteArray binaryHeader;
+                AppendBinary(binaryHeader, quint32(binarySize));
+                AppendBinary(binaryHeader, quint32(0x004E4942)); // "BIN"
+
+                success = success && mFile.write(binaryHeader) == binaryHeader.size();
+                success = success && Append(mFile, mPositions) && Append(mFile, mNormals) && Append(mFile, mIndices);
+            }
+
+            return Close() && success;
+        }
+
+      private:
+        static constexpr int QUANTIZATION_RANGE = 32767;
+
+        struct Primitive
+        {
+            int curve{ 0 };
+            qint64 positionOffset{ 0 };
+            qint64 normalOffset{ 0 };
+            qint64 indexOffset{ 0 };
+            qint64 vertexCount{ 0 };
+            qint64 indexCount{ 0 };
+            int min[3] = { QUANTIZATION_RANGE, QUANTIZATION_RANGE, QUANTIZATION_RANGE };
+            int max[3] = { -QUANTIZATION_RANGE, -QUANTIZATION_RANGE, -QUANTIZATION_RANGE };
+        };
+
+        QJsonDocument CreateJson(qint64 positionsSize, qint64 normalsSize, qint64 indicesSize) const
+        {
+            constexpr int BYTE = 5120;
+            constexpr int SHORT = 5122;
+            constexpr int UNSIGNED_INT = 5125;
+            constexpr int ARRAY_BUFFER = 34962;
+            constexpr int ELEMENT_ARRAY_BUFFER = 34963;
+
+            QJsonObject root;
+            root["asset"] = QJsonObject{ { "version", "2.0" }, { "generator", "BSplineRenderer" } };
+            root["extensionsUsed"] = QJsonArray{ "KHR_mesh_quantization" };
+            root["extensionsRequired"] = QJsonArray{ "KHR_mesh_quantization" };
+
+            QJsonArray nodes;
+            QJsonArray meshes;
+            QJsonArray accessors;
+            QJsonArray sceneNodes;
+
+            for (const auto& primitive : mPrimitives)
+            {
+                if (primitive.vertexCount == 0)
+                {
+                    continue;
+                }
+
+                const int firstAccessor = accessors.size();
+
+                accessors.append(QJsonObject{
+                    { "bufferView", 0 },
+                    { "byteOffset", double(primitive.positionOffset) },
+                    { "componentType", SHORT },
+                    { "count", double(primitive.vertexCount) },
+                    { "type", "VEC3" },
+                    { "min", QJsonArray{ primitive.min[0], primitive.min[1], primitive.min[2] } },
+                    { "max", QJsonArray{ primitive.max[0], primitive.max[1], primitive.max[2] } },
+                });
+
+                accessors.append(QJsonObject{
+                    { "bufferView", 1 },
+                    { "byteOffset", double(primitive.normalOffset) },
+                    { "componentType", BYTE },
+                    { "normalized", true },
+                    { "count", double(primitive.vertexCount) },
+                    { "type", "VEC3" },
+                });
+
+                accessors.append(QJsonObject{
+                    { "bufferView", 2 },
+                    { "byteOffset", double(primitive.indexOffset) },
+                    { "componentType", UNSIGNED_INT },
+                    { "count", double(primitive.indexCount) },
+                    { "type", "SCALAR" },
+                });
+
+                const QJsonObject attributes{ { "POSITION", firstAccessor }, { "NORMAL", firstAccessor + 1 } };
+                const QJsonObject meshPrimitive{ { "attributes", attributes }, { "indices", firstAccessor + 2 } };
+                meshes.append(QJsonObject{ { "name", QString("Curve_%1").arg(primitive.curve) }, { "primitives", QJsonArray{ meshPrimitive } } });
+
+                sceneNodes.append(nodes.size());
+                nodes.append(QJsonObject{
+                    { "mesh", meshes.size() - 1 },
+                    { "translation", QJsonArray{ mCenter.x(), mCenter.y(), mCenter.z() } },
+                    { "scale", QJsonArray{ mScale, mScale, mScale } },
+                });
+            }
+
+            root["scene"] = 0;
+            root["scenes"] = QJsonArray{ QJsonObject{ { "nodes", sceneNodes } } };
+
+            if (meshes.isEmpty())
+            {
+                return QJsonDocument(root);
+            }
+
+            root["nodes"] = nodes;
+            root["meshes"] = meshes;
+            root["accessors"] = accessors;
+            root["buffers"] = QJsonArray{ QJsonObject{ { "byteLength", double(positionsSize + normalsSize + indicesSize) } } };
+            root["bufferViews"] = QJsonArray{
+                QJsonObject{ { "buffer", 0 }, { "byteOffset", 0 }, { "byteLength", double(positionsSize) }, { "byteStride", 8 }, { "target", ARRAY_BUFFER } },
+                QJsonObject{ { "buffer", 0 }, { "byteOffset", double(positionsSize) }, { "byteLength", double(normalsSize) }, { "byteStride", 4 }, { "target", ARRAY_BUFFER } },
+                QJsonObject{ { "buffer", 0 }, { "byteOffset", double(positionsSize + normalsSize) }, { "byteLength", double(indicesSize) }, { "target", ELEMENT_ARRAY_BUFFER } },
+            };
+
+            return QJsonDocument(root);
+        }
+
+        QTemporaryFile mPositions;
+        QTemporaryFile mNormals;
+        QTemporaryFile mIndices;
+        QVector<Primitive> mPrimitives;
+
+        QVector3D mCenter;
+        float mScale{ 1.0f };
+    };
+
+    std::unique_ptr<MeshWriter> CreateWriter(MeshFormat format, const QString& filePath)
+    {
+        switch (format)
+        {
+        case MeshFormat::OBJ:
+            return std::make_unique<ObjWriter>(filePath);
+        case MeshFormat::PLY:
+            return std::make_unique<PlyWriter>(filePath);
+        case MeshFormat::STL:
+            return std::make_unique<StlWriter>(filePath);
+        case MeshFormat::GLB:
+            return std::make_unique<GlbWriter>(filePath);
+        }
+
+        return nullptr;
+    }
+}
+
+bool BSplineRenderer::MeshExporter::GetFormat(const QString& filePath, MeshFormat& format)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+
+    if (suffix == "obj")
+    {
+        format = MeshFormat::OBJ;
+    }
+    else if (suffix == "ply")
+    {
+        format = MeshFormat::PLY;
+    }
+    else if (suffix == "stl")
+    {
+        format = MeshFormat::STL;
+    }
+    else if (suffix == "glb")
+    {
+        format = MeshFormat::GLB;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool BSplineRenderer::MeshExporter::Export(const QString& filePath, const QVector<SplineGeometry*>& curves, int segments, int sectors)
+{
+    MeshFormat format;
+
+    if (GetFormat(filePath, format) == false)
+    {
+        return false;
+    }
+
+    return Export(filePath, format, curves, segments, sectors);
+}
+
+bool BSplineRenderer::MeshExporter::Export(const QString& filePath, MeshFormat format, const QVector<SplineGeometry*>& curves, int segments, int sectors)
+{
+    const auto writer = CreateWriter(format, filePath);
+    const int verticesPerPatch = (segments + 1) * (sectors + 1);
+
+    // The frames of curves that were not drawn as tubes may be deferred
+    for (SplineGeometry* curve : curves)
+    {
+        curve->UpdateStaleFrames();
+    }
+
+    QVector<Chunk> chunks;
+    quint64 vertexCount = 0;
+
+    for (int curve = 0; curve < curves.size(); ++curve)
+    {
+        const int patchCount = curves[curve]->GetPatchCount();
+
+        for (int first = 0; first < patchCount; first += PATCHES_PER_CHUNK)
+        {
+            const int last = std::min(first + PATCHES_PER_CHUNK, patchCount) - 1;
+            chunks << Chunk{ curve, first, last, vertexCount, quint64(first) * verticesPerPatch };
+            vertexCount += quint64(last - first + 1) * verticesPerPatch;
+        }
+    }
+
+    const quint64 triangleCount = vertexCount / verticesPerPatch * 2 * segments * sectors;
+
+    if (writer->Begin(curves, vertexCount, triangleCount) == false)
+    {
+        return false;
+    }
+
+    // Only a batch of chunks is kept in memory, a few per thread so that the threads stay busy
+    const int batchSize = 2 * std::max(1, QThread::idealThreadCount());
+    std::vector<TubeMesh> meshes(batchSize);
+    std::vector<int> batch(batchSize);
+    int currentCurve = -1;
+
+    for (int first = 0; first < chunks.size(); first += batchSize)
+    {
+        const int count = std::min<int>(batchSize, chunks.size() - first);
+        batch.resize(count);
+        std::iota(batch.begin(), batch.end(), 0);
+
+        QtConcurrent::blockingMap(batch, [&](int slot) {
+            const Chunk& chunk = chunks[first + slot];
+            TubeMeshBuilder::Allocate(chunk.firstPatch, chunk.lastPatch, segments, sectors, meshes[slot]);
+            TubeMeshBuilder::BuildPatches(*curves[chunk.curve], chunk.firstPatch, chunk.lastPatch, meshes[slot]);
+        });
+
+        for (int slot = 0; slot < count; ++slot)
+        {
+            const Chunk& chunk = chunks[first + slot];
+
+            if (chunk.curve != currentCurve)
+            {
+                currentCurve = chunk.curve;
+                writer->BeginCurve(currentCurve);
+            }
+
+            writer->Write(chunk, meshes[slot]);
+        }
+    }
+
+    return writer->End();
+}
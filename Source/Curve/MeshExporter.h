@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Curve/SplineGeometry.h"
+
+#include <QString>
+#include <QVector>
+
+namespace BSplineRenderer
+{
+    enum class MeshFormat
+    {
+        OBJ,
+        PLY,
+        STL,
+        GLB
+    };
+
+    // Writes the tube meshes of the curves to disk. The curves are tessellated chunk by chunk on
+    // all cores and every chunk is written out before the next ones are built, so the memory
+    // needed does not depend on the size of the scene.
+    //
+    // OBJ:  Text, positions and normals, one object per curve
+    // PLY:  Binary little endian, positions and normals
+    // STL:  Binary, one solid for the whole scene
+    // GLB:  Binary glTF, one mesh per curve. Positions are quantized to 16-bit integers and normals
+    //       to 8-bit normalized integers (KHR_mesh_quantization), the node transforms dequantize them.
+    class MeshExporter
+    {
+      public:
+        MeshExporter() = delete;
+
+        // Guesses the format from the file extension, returns false if it is not known
+        static bool GetFormat(const QString& filePath, MeshFormat& format);
+
+        // The curves must be up to date
+        static bool Export(const QString& filePath, const QVector<SplineGeometry*>& curves, int segments, int sectors);
+        static bool Export(const QString& filePath, MeshFormat format, const QVector<SplineGeometry*>& curves, int segments, int sectors);
+    };
+}
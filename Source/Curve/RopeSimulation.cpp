@@ -0,0 +1,190 @@
+#include "RopeSimulation.h"
+
+#include "Util/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float MIN_LENGTH = 1e-6f;
+}
+
+int BSplineRenderer::RopeSimulation::AddRope(const QVector3D* positions, int count)
+{
+    const int first = mInverseMass.size();
+    const int size = first + count;
+
+    mPositions.Resize(size);
+    mPreviousPositions.Resize(size);
+    mInverseMass.resize(size, 1.0f);
+
+    for (int i = 0; i < count; ++i)
+    {
+        for (SampleArray* array : { &mPositions, &mPreviousPositions })
+        {
+            array->x[first + i] = positions[i].x();
+            array->y[first + i] = positions[i].y();
+            array->z[first + i] = positions[i].z();
+        }
+    }
+
+    const auto add = [&](ConstraintColor& color, int a, int b) {
+        color.a.push_back(a);
+        color.b.push_back(b);
+        color.restLength.push_back((positions[b - first] - positions[a - first]).length());
+    };
+
+    // Particles are only shared by constraints of different colors, see ConstraintColor
+    for (int i = first; i + 1 < size; ++i)
+    {
+        add(mColors[(i - first) % 2], i, i + 1);
+    }
+
+    for (int i = first; i + 2 < size; ++i)
+    {
+        add(mColors[2 + ((i - first) / 2) % 2], i, i + 2);
+    }
+
+    return first;
+}
+
+void BSplineRenderer::RopeSimulation::Clear()
+{
+    mPositions.Resize(0);
+    mPreviousPositions.Resize(0);
+    mInverseMass.clear();
+
+    for (auto& color : mColors)
+    {
+        color.a.clear();
+        color.b.clear();
+        color.restLength.clear();
+    }
+
+    mAccumulator = 0.0f;
+}
+
+void BSplineRenderer::RopeSimulation::SetPinned(int particle, bool pinned)
+{
+    mInverseMass[particle] = pinned ? 0.0f : 1.0f;
+}
+
+void BSplineRenderer::RopeSimulation::SetPosition(int particle, const QVector3D& position)
+{
+    for (SampleArray* array : { &mPositions, &mPreviousPositions })
+    {
+        array->x[particle] = position.x();
+        array->y[particle] = position.y();
+        array->z[particle] = position.z();
+    }
+}
+
+int BSplineRenderer::RopeSimulation::Advance(float deltaTime)
+{
+    const float dt = mParameters.timeStep;
+    mAccumulator += deltaTime;
+
+    int steps = 0;
+
+    while (mAccumulator >= dt && steps < MAX_STEPS_PER_ADVANCE)
+    {
+        Step();
+        mAccumulator -= dt;
+        ++steps;
+    }
+
+    // Drops the time that could not be simulated instead of falling further behind
+    if (steps == MAX_STEPS_PER_ADVANCE)
+    {
+        mAccumulator = std::min(mAccumulator, dt);
+    }
+
+    return steps;
+}
+
+void BSplineRenderer::RopeSimulation::Step()
+{
+    const float dt = mParameters.timeStep;
+
+    JobSystem::Instance().ParallelFor(GetParticleCount(), PARTICLES_PER_JOB, [this, dt](int first, int count) { Integrate(first, count, dt); });
+
+    // Stiffness per iteration such that the iterations together remove the requested fraction
+    const int iterations = std::max(1, mParameters.iterations);
+    const float stretch = 1.0f - std::pow(1.0f - std::clamp(mParameters.stretchStiffness, 0.0f, 1.0f), 1.0f / iterations);
+    const float bend = 1.0f - std::pow(1.0f - std::clamp(mParameters.bendStiffness, 0.0f, 1.0f), 1.0f / iterations);
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (const auto& color : mColors)
+        {
+            const float stiffness = color.bending ? bend : stretch;
+            JobSystem::Instance().ParallelFor(color.a.size(), CONSTRAINTS_PER_JOB, [this, &color, stiffness](int first, int count) { Project(color, first, count, stiffness); });
+        }
+    }
+}
+
+void BSplineRenderer::RopeSimulation::Integrate(int first, int count, float dt)
+{
+    const float retained = 1.0f - std::clamp(mParameters.damping, 0.0f, 1.0f);
+    const QVector3D gravity = mParameters.gravity * dt * dt;
+
+    float* x = mPositions.x.data();
+    float* y = mPositions.y.data();
+    float* z = mPositions.z.data();
+    float* px = mPreviousPositions.x.data();
+    float* py = mPreviousPositions.y.data();
+    float* pz = mPreviousPositions.z.data();
+    const float* w = mInverseMass.data();
+
+    // Verlet, the velocity is the displacement of the last step. Pinned particles get no acceleration and keep still.
+    for (int i = first; i < first + count; ++i)
+    {
+        const float move = w[i] > 0.0f ? 1.0f : 0.0f;
+        const float vx = move * (retained * (x[i] - px[i]) + gravity.x());
+        const float vy = move * (retained * (y[i] - py[i]) + gravity.y());
+        const float vz = move * (retained * (z[i] - pz[i]) + gravity.z());
+
+        px[i] = x[i];
+        py[i] = y[i];
+        pz[i] = z[i];
+
+        x[i] += vx;
+        y[i] += vy;
+        z[i] += vz;
+    }
+}
+
+void BSplineRenderer::RopeSimulation::Project(const ConstraintColor& color, int first, int count, float stiffness)
+{
+    float* x = mPositions.x.data();
+    float* y = mPositions.y.data();
+    float* z = mPositions.z.data();
+    const float* w = mInverseMass.data();
+
+    for (int i = first; i < first + count; ++i)
+    {
+        const int a = color.a[i];
+        const int b = color.b[i];
+        const float weight = w[a] + w[b];
+
+        const float dx = x[b] - x[a];
+        const float dy = y[b] - y[a];
+        const float dz = z[b] - z[a];
+        const float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        if (weight == 0.0f || length < MIN_LENGTH)
+        {
+            continue;
+        }
+
+        const float scale = stiffness * (length - color.restLength[i]) / (weight * length);
+
+        x[a] += w[a] * scale * dx;
+        y[a] += w[a] * scale * dy;
+        z[a] += w[a] * scale * dz;
+        x[b] -= w[b] * scale * dx;
+        y[b] -= w[b] * scale * dy;
+        z[b] -= w[b] * scale * dz;
+    }
+}
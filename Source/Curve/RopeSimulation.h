@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Curve/SplineEvaluator.h"
+#include "Util/Macros.h"
+
+#include <QVector3D>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    struct RopeParameters
+    {
+        QVector3D gravity{ 0.0f, -9.81f, 0.0f };
+
+        // In [0, 1], fraction of a constraint error removed per solver iteration
+        float stretchStiffness{ 1.0f };
+        float bendStiffness{ 0.1f };
+
+        // In [0, 1], fraction of the velocity lost per step
+        float damping{ 0.01f };
+
+        // Fixed step in seconds, independent of the frame rate
+        float timeStep{ 1.0f / 120.0f };
+        int iterations{ 8 };
+    };
+
+    // Position based dynamics of ropes, one particle per knot. The particles of all ropes are stored as
+    // structure of arrays, each rope as a contiguous range. Stretching is resisted by distance constraints
+    // between neighbors and bending by distance constraints between every other particle. The constraints
+    // are split into four colors without shared particles, each color is projected in parallel.
+    class RopeSimulation
+    {
+        DISABLE_COPY(RopeSimulation);
+
+      public:
+        RopeSimulation() = default;
+
+        // Adds a rope at rest through the points, returns the index of its first particle
+        int AddRope(const QVector3D* positions, int count);
+        void Clear();
+
+        // Pinned particles are not moved by the solver, only by SetPosition()
+        void SetPinned(int particle, bool pinned);
+        bool IsPinned(int particle) const { return mInverseMass[particle] == 0.0f; }
+
+        // Teleports the particle without giving it a velocity
+        void SetPosition(int particle, const QVector3D& position);
+
+        // Runs as many fixed steps as fit into the elapsed time plus the remainder of the last call,
+        // at most MAX_STEPS_PER_ADVANCE. Returns the number of steps.
+        int Advance(float deltaTime);
+        void Step();
+
+        int GetParticleCount() const { return mInverseMass.size(); }
+        const SampleArray& GetPositions() const { return mPositions; }
+
+        static constexpr int MAX_STEPS_PER_ADVANCE = 8;
+
+      private:
+        // Constraints between particles a[i] and b[i], no two of them share a particle
+        struct ConstraintColor
+        {
+            std::vector<int> a;
+            std::vector<int> b;
+            std::vector<float> restLength;
+            bool bending;
+        };
+
+        void Integrate(int first, int count, float dt);
+        void Project(const ConstraintColor& color, int first, int count, float stiffness);
+
+        static constexpr int PARTICLES_PER_JOB = 1 << 13;
+        static constexpr int CONSTRAINTS_PER_JOB = 1 << 13;
+
+        SampleArray mPositions;
+        SampleArray mPreviousPositions;
+        std::vector<float> mInverseMass;
+
+        // Stretch constraints starting at even and odd particles, then bend constraints in two alternating pairs
+        ConstraintColor mColors[4]{ { {}, {}, {}, false }, { {}, {}, {}, false }, { {}, {}, {}, true }, { {}, {}, {}, true } };
+
+        float mAccumulator{ 0.0f };
+
+        DEFINE_MEMBER(RopeParameters, Parameters);
+    };
+}
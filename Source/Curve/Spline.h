@@ -1,70 +1,45 @@
 #pragma once
 
-#include "Core/Constants.h"
-#include "Curve/Knot.h"
+#include "Curve/SplineGeometry.h"
 #include "Util/Macros.h"
 
-#include <Dense>
-#include <QOpenGLExtraFunctions>
-#include <QVector>
+#include <QMatrix4x4>
+#include <QVector4D>
+#include <atomic>
 
 namespace BSplineRenderer
 {
-    class Spline : QOpenGLExtraFunctions
+    // SplineGeometry with material and placement. Plain data: it can be created, solved and destroyed
+    // on any thread, the OpenGL buffers mirroring its patches are owned by the renderer's SplineBufferCache.
+    class Spline : public SplineGeometry
     {
-      public:
-        Spline() = default;
-
-        void AddKnot(KnotPtr knot);
-        KnotPtr AddKnot(float x, float y, float z);
-        KnotPtr AddKnot(const QVector3D& position);
-
-        void RemoveLastKnot();
-        void RemoveKnot(KnotPtr knot);
-        void ClearKnots();
-
-        int GetKnotCount() const { return mKnots.size(); }
-        float GetTotalLength() const;
-        QVector3D GetCentroid() const;
-        QPair<QVector3D, QVector3D> GetBoundingBox() const;
+        DISABLE_COPY(Spline);
 
-        const QVector<KnotPtr>& GetKnots() const { return mKnots; }
+      public:
+        Spline();
 
-        KnotPtr GetClosestKnotToRay(const QVector3D& rayOrigin, const QVector3D& rayDirection, float maxDistance) const;
+        // Unique for the lifetime of the process, never reused unlike the address
+        unsigned long long GetId() const { return mId; }
 
-        void Render();
-        void Update();
-        void MakeDirty();
-        void UpdateIfDirty();
-        bool IsDirty() const { return mDirty; }
+        // Knots are in model space, the curve is drawn with the model matrix
+        QVector3D MapToWorld(const QVector3D& point) const { return mModelMatrix.map(point); }
+        QVector3D MapToModel(const QVector3D& point) const { return mModelMatrix.inverted().map(point); }
 
       private:
-        void DestroyOpenGLStuff();
-        void ContructOpenGLStuff();
-        void InitializeOpenGLStuffIfNot();
-
-        Eigen::MatrixXf CreateCoefficientMatrix();
-        void UpdateSplineControlPoints();
-
-        QVector<KnotPtr> mKnots;
-        QVector<QVector3D> mSplineControlPoints;
-        QVector<QVector3D> mBezierControlPoints;
-        GLuint mVertexArray{ 0 };
-        GLuint mVertexBuffer{ 0 };
-
-        bool mDirty{ false };
+        const unsigned long long mId;
 
-        bool mInitialized{ false };
+        static std::atomic<unsigned long long> mNextId;
 
         DEFINE_MEMBER(QVector4D, Color, QVector4D(1.0f, 1.0f, 1.0f, 1.0f));
         DEFINE_MEMBER(float, Ambient, 0.25f);
         DEFINE_MEMBER(float, Diffuse, 0.50f);
         DEFINE_MEMBER(float, Specular, 0.25f);
         DEFINE_MEMBER(float, Shininess, 4.0f);
-        DEFINE_MEMBER(float, Radius, DEFAULT_RADIUS);
 
-        static constexpr int NUM_OF_PATCH_POINTS = 4;
+        // Rigid motion of the whole curve, set by the animations that do not deform it. Must be a
+        // similarity transform: the tube keeps its radius and only its centerline is transformed.
+        DEFINE_MEMBER(QMatrix4x4, ModelMatrix);
     };
 
     using SplinePtr = std::shared_ptr<Spline>;
-}
\ No newline at end of file
+}
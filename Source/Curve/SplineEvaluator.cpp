@@ -0,0 +1,440 @@
+#include "SplineEvaluator.h"
+
+#include "Curve/SplineEvaluatorKernel.h"
+
+#include <cmath>
+
+#if defined(BR_AVX2_KERNEL) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    using namespace BSplineRenderer;
+
+    PatchCoefficients GetCoefficients(const QVector3D* p)
+    {
+        PatchCoefficients patch;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            patch.a[k] = p[0][k];
+            patch.b[k] = 3.0f * (p[1][k] - p[0][k]);
+            patch.c[k] = 3.0f * (p[2][k] - 2.0f * p[1][k] + p[0][k]);
+            patch.d[k] = p[3][k] - 3.0f * p[2][k] + 3.0f * p[1][k] - p[0][k];
+        }
+
+        return patch;
+    }
+
+    QVector3D GetPerpendicular(const QVector3D& tangent)
+    {
+        const QVector3D perpendicular = std::abs(tangent.y()) < 0.9f ? QVector3D(-tangent.z(), 0.0f, tangent.x()) : QVector3D(0.0f, tangent.z(), -tangent.y());
+        return perpendicular / std::sqrt(QVector3D::dotProduct(perpendicular, perpendicular));
+    }
+
+    EvaluationKernel GetSimdKernel()
+    {
+#if defined(BR_AVX2_KERNEL)
+        static const bool supported = IsAVX2Supported();
+
+        if (supported)
+        {
+            return EvaluateAVX2;
+        }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        return EvaluateNEON;
+#endif
+        return nullptr;
+    }
+
+    TransportKernel GetSimdTransportKernel()
+    {
+#if defined(BR_AVX2_KERNEL)
+        static const bool supported = IsAVX2Supported();
+
+        if (supported)
+        {
+            return TransportAVX2;
+        }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        return TransportNEON;
+#endif
+        return nullptr;
+    }
+
+    SampleOutput GetOutput(SplineSamples& samples, int outputs)
+    {
+        SampleOutput output{};
+
+        const auto assign = [](float* (&target)[3], SampleArray& source) {
+            target[0] = source.x.data();
+            target[1] = source.y.data();
+            target[2] = source.z.data();
+        };
+
+        if (outputs & SplineEvaluator::POSITION)
+        {
+            assign(output.position, samples.position);
+        }
+
+        if (outputs & SplineEvaluator::FIRST_DERIVATIVE)
+        {
+            assign(output.firstDerivative, samples.firstDerivative);
+        }
+
+        if (outputs & SplineEvaluator::SECOND_DERIVATIVE)
+        {
+            assign(output.secondDerivative, samples.secondDerivative);
+        }
+
+        if (outputs & SplineEvaluator::FRAME)
+        {
+            assign(output.tangent, samples.tangent);
+            assign(output.normal, samples.normal);
+            assign(output.binormal, samples.binormal);
+        }
+
+        return output;
+    }
+}
+
+bool BSplineRenderer::IsAVX2Supported()
+{
+#if defined(BR_AVX2_KERNEL) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+    // The OS must save the YMM registers on context switches
+    if (fma == false || osxsave == false || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(BR_AVX2_KERNEL)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+void BSplineRenderer::EvaluateScalar(const PatchCoefficients& patch, const float* t, int count, const SampleOutput& output, int offset)
+{
+    const float* a = patch.a;
+    const float* b = patch.b;
+    const float* c = patch.c;
+    const float* d = patch.d;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const float u = t[i];
+        const int index = offset + i;
+
+        float d1[3];
+        float d2[3];
+
+        for (int k = 0; k < 3; ++k)
+        {
+            d1[k] = b[k] + u * (2.0f * c[k] + u * (3.0f * d[k]));
+            d2[k] = 2.0f * c[k] + u * (6.0f * d[k]);
+        }
+
+        if (output.position[0])
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                output.position[k][index] = a[k] + u * (b[k] + u * (c[k] + u * d[k]));
+            }
+        }
+
+        if (output.firstDerivative[0])
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                output.firstDerivative[k][index] = d1[k];
+            }
+        }
+
+        if (output.secondDerivative[0])
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                output.secondDerivative[k][index] = d2[k];
+            }
+        }
+
+        if (output.tangent[0])
+        {
+            // Tangent, falls back to the x-axis on a degenerate patch
+            float tangent[3] = { 1.0f, 0.0f, 0.0f };
+            const float speed2 = d1[0] * d1[0] + d1[1] * d1[1] + d1[2] * d1[2];
+
+            if (speed2 > FRAME_MIN_SPEED_SQUARED)
+            {
+                const float inverse = 1.0f / std::sqrt(speed2);
+                tangent[0] = d1[0] * inverse;
+                tangent[1] = d1[1] * inverse;
+                tangent[2] = d1[2] * inverse;
+            }
+
+            // Binormal along T x B'', falls back to T x Y (or T x X if T is close to Y) on straight parts
+            float binormal[3] = {
+                tangent[1] * d2[2] - tangent[2] * d2[1],
+                tangent[2] * d2[0] - tangent[0] * d2[2],
+                tangent[0] * d2[1] - tangent[1] * d2[0],
+            };
+
+            float binormal2 = binormal[0] * binormal[0] + binormal[1] * binormal[1] + binormal[2] * binormal[2];
+            const float curvature2 = d2[0] * d2[0] + d2[1] * d2[1] + d2[2] * d2[2];
+
+            if (binormal2 <= FRAME_MIN_CURVATURE_RATIO * curvature2 + FRAME_MIN_SPEED_SQUARED)
+            {
+                if (std::abs(tangent[1]) < 0.9f)
+                {
+                    binormal[0] = -tangent[2];
+                    binormal[1] = 0.0f;
+                    binormal[2] = tangent[0];
+                }
+                else
+                {
+                    binormal[0] = 0.0f;
+                    binormal[1] = tangent[2];
+                    binormal[2] = -tangent[1];
+                }
+
+                binormal2 = binormal[0] * binormal[0] + binormal[1] * binormal[1] + binormal[2] * binormal[2];
+            }
+
+            const float inverse = 1.0f / std::sqrt(binormal2);
+
+            for (int k = 0; k < 3; ++k)
+            {
+                binormal[k] *= inverse;
+            }
+
+            output.tangent[0][index] = tangent[0];
+            output.tangent[1][index] = tangent[1];
+            output.tangent[2][index] = tangent[2];
+            output.binormal[0][index] = binormal[0];
+            output.binormal[1][index] = binormal[1];
+            output.binormal[2][index] = binormal[2];
+            output.normal[0][index] = binormal[1] * tangent[2] - binormal[2] * tangent[1];
+            output.normal[1][index] = binormal[2] * tangent[0] - binormal[0] * tangent[2];
+            output.normal[2][index] = binormal[0] * tangent[1] - binormal[1] * tangent[0];
+        }
+    }
+}
+
+void BSplineRenderer::TransportScalar(const float* controlPoints, int count, const SampleOutput& output, int offset)
+{
+    constexpr int SAMPLES = FRAME_STEPS_PER_PATCH + 1;
+
+    const auto store = [&output](int index, const QVector3D& tangent, const QVector3D& normal) {
+        for (int k = 0; k < 3; ++k)
+        {
+            output.tangent[k][index] = tangent[k];
+            output.normal[k][index] = normal[k];
+        }
+    };
+
+    for (int i = 0; i < count; ++i)
+    {
+        const PatchCoefficients patch = GetCoefficients(reinterpret_cast<const QVector3D*>(controlPoints) + 4 * i);
+
+        QVector3D position[SAMPLES];
+        QVector3D tangent[SAMPLES];
+        bool moving[SAMPLES];
+
+        for (int j = 0; j < SAMPLES; ++j)
+        {
+            const float u = j / float(FRAME_STEPS_PER_PATCH);
+            QVector3D derivative;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                position[j][k] = patch.a[k] + u * (patch.b[k] + u * (patch.c[k] + u * patch.d[k]));
+                derivative[k] = patch.b[k] + u * (2.0f * patch.c[k] + u * (3.0f * patch.d[k]));
+            }
+
+            const float speed2 = QVector3D::dotProduct(derivative, derivative);
+            moving[j] = speed2 > FRAME_TRANSPORT_EPSILON;
+            tangent[j] = moving[j] ? derivative / std::sqrt(speed2) : QVector3D();
+        }
+
+        // Degenerate samples (coincident control points) take the tangent of the previous sample, leading
+        // ones that of the first moving sample. A patch without any falls back to the x-axis.
+        for (int j = 1; j < SAMPLES; ++j)
+        {
+            if (moving[j] == false && moving[j - 1])
+            {
+                tangent[j] = tangent[j - 1];
+                moving[j] = true;
+            }
+        }
+
+        for (int j = SAMPLES - 2; j >= 0; --j)
+        {
+            if (moving[j] == false && moving[j + 1])
+            {
+                tangent[j] = tangent[j + 1];
+                moving[j] = true;
+            }
+        }
+
+        for (int j = 0; j < SAMPLES && moving[0] == false; ++j)
+        {
+            tangent[j] = QVector3D(1.0f, 0.0f, 0.0f);
+        }
+
+        QVector3D normal = GetPerpendicular(tangent[0]);
+        store(offset + 4 * i, tangent[0], normal);
+
+        for (int j = 1; j < SAMPLES; ++j)
+        {
+            // Reflect by the bisector plane of the samples, then the reflected tangent onto the tangent. On
+            // coincident samples a single reflection would flip the frame, only the projection below is done.
+            const QVector3D v1 = position[j] - position[j - 1];
+            const float c1 = QVector3D::dotProduct(v1, v1);
+            QVector3D r = normal;
+
+            if (c1 > FRAME_TRANSPORT_EPSILON)
+            {
+                r -= (2.0f / c1) * QVector3D::dotProduct(v1, r) * v1;
+                const QVector3D v2 = tangent[j] - (tangent[j - 1] - (2.0f / c1) * QVector3D::dotProduct(v1, tangent[j - 1]) * v1);
+                const float c2 = QVector3D::dotProduct(v2, v2);
+
+                if (c2 > FRAME_TRANSPORT_EPSILON)
+                {
+                    r -= (2.0f / c2) * QVector3D::dotProduct(v2, r) * v2;
+                }
+            }
+
+            // Back onto the normal plane against rounding
+            r -= QVector3D::dotProduct(r, tangent[j]) * tangent[j];
+            const float r2 = QVector3D::dotProduct(r, r);
+            normal = r2 > FRAME_TRANSPORT_EPSILON ? r / std::sqrt(r2) : GetPerpendicular(tangent[j]);
+
+            if (j % FRAME_STEPS_PER_NORMAL == 0)
+            {
+                store(offset + 4 * i + j / FRAME_STEPS_PER_NORMAL, tangent[j], normal);
+            }
+        }
+    }
+}
+
+void BSplineRenderer::SplineEvaluator::EvaluateUniform(const QVector3D* bezierControlPoints, int patchCount, const float* t, int count, SplineSamples& samples, int outputs)
+{
+    Resize(samples, patchCount * count, outputs);
+
+    const SampleOutput output = GetOutput(samples, outputs);
+    const EvaluationKernel simd = mSimdEnabled ? GetSimdKernel() : nullptr;
+    const EvaluationKernel kernel = simd ? simd : EvaluateScalar;
+
+    for (int i = 0; i < patchCount; ++i)
+    {
+        kernel(GetCoefficients(bezierControlPoints + 4 * i), t, count, output, i * count);
+    }
+}
+
+void BSplineRenderer::SplineEvaluator::Evaluate(const QVector3D* bezierControlPoints, const int* patches, const float* t, int count, SplineSamples& samples, int outputs)
+{
+    Resize(samples, count, outputs);
+
+    const SampleOutput output = GetOutput(samples, outputs);
+    const EvaluationKernel simd = mSimdEnabled ? GetSimdKernel() : nullptr;
+    const EvaluationKernel kernel = simd ? simd : EvaluateScalar;
+
+    for (int first = 0; first < count;)
+    {
+        int last = first + 1;
+
+        while (last < count && patches[last] == patches[first])
+        {
+            ++last;
+        }
+
+        kernel(GetCoefficients(bezierControlPoints + 4 * patches[first]), t + first, last - first, output, first);
+
+        first = last;
+    }
+}
+
+void BSplineRenderer::SplineEvaluator::TransportFrames(const QVector3D* bezierControlPoints, int patchCount, SplineSamples& samples, int offset)
+{
+    SampleOutput output{};
+    output.tangent[0] = samples.tangent.x.data();
+    output.tangent[1] = samples.tangent.y.data();
+    output.tangent[2] = samples.tangent.z.data();
+    output.normal[0] = samples.normal.x.data();
+    output.normal[1] = samples.normal.y.data();
+    output.normal[2] = samples.normal.z.data();
+
+    const TransportKernel simd = mSimdEnabled ? GetSimdTransportKernel() : nullptr;
+    const TransportKernel kernel = simd ? simd : TransportScalar;
+
+    kernel(reinterpret_cast<const float*>(bezierControlPoints), patchCount, output, offset);
+}
+
+void BSplineRenderer::SplineEvaluator::Resize(SplineSamples& samples, int count, int outputs)
+{
+    samples.count = count;
+
+    if (outputs & POSITION)
+    {
+        samples.position.Resize(count);
+    }
+
+    if (outputs & FIRST_DERIVATIVE)
+    {
+        samples.firstDerivative.Resize(count);
+    }
+
+    if (outputs & SECOND_DERIVATIVE)
+    {
+        samples.secondDerivative.Resize(count);
+    }
+
+    if (outputs & FRAME)
+    {
+        samples.tangent.Resize(count);
+        samples.normal.Resize(count);
+        samples.binormal.Resize(count);
+    }
+}
+
+void BSplineRenderer::SplineEvaluator::SetSimdEnabled(bool enabled)
+{
+    mSimdEnabled = enabled;
+}
+
+bool BSplineRenderer::SplineEvaluator::GetSimdEnabled()
+{
+    return mSimdEnabled;
+}
+
+const char* BSplineRenderer::SplineEvaluator::GetKernelName()
+{
+    if (mSimdEnabled == false || GetSimdKernel() == nullptr)
+    {
+        return "Scalar";
+    }
+
+#if defined(BR_AVX2_KERNEL)
+    return "AVX2";
+#else
+    return "NEON";
+#endif
+}
+
+bool BSplineRenderer::SplineEvaluator::mSimdEnabled = true;
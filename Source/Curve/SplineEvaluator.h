@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QVector3D>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // Structure of arrays storage of a 3D quantity, one entry per sample
+    struct SampleArray
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+
+        void Resize(int count)
+        {
+            x.resize(count);
+            y.resize(count);
+            z.resize(count);
+        }
+
+        QVector3D At(int index) const { return QVector3D(x[index], y[index], z[index]); }
+    };
+
+    // Only the arrays of the requested outputs are resized and filled, the others are left unchanged
+    struct SplineSamples
+    {
+        SampleArray position;
+        SampleArray firstDerivative;
+        SampleArray secondDerivative;
+
+        // Frenet frame: unit tangent, principal normal and binormal. Where the curvature vanishes
+        // the normal is an arbitrary unit vector perpendicular to the tangent.
+        SampleArray tangent;
+        SampleArray normal;
+        SampleArray binormal;
+
+        int count{ 0 };
+    };
+
+    // Evaluates cubic Bezier patches on the CPU for many parameters in one call.
+    // Patches are given as in SplineGeometry, 4 consecutive control points each.
+    class SplineEvaluator
+    {
+      public:
+        SplineEvaluator() = delete;
+
+        enum Output
+        {
+            POSITION = 1,
+            FIRST_DERIVATIVE = 2,
+            SECOND_DERIVATIVE = 4,
+            FRAME = 8,
+        };
+
+        // Evaluates every patch at each of the parameters, sample (i * count + j) is patch i at t[j].
+        static void EvaluateUniform(const QVector3D* bezierControlPoints, int patchCount, const float* t, int count, SplineSamples& samples, int outputs = POSITION);
+
+        // Evaluates arbitrary (patch, t) pairs. Consecutive pairs on the same patch are evaluated
+        // as one run, so sorting by patch gives the best throughput.
+        static void Evaluate(const QVector3D* bezierControlPoints, const int* patches, const float* t, int count, SplineSamples& samples, int outputs = POSITION);
+
+        // Rotation minimizing frames by the double reflection method of Wang et al. Every patch is transported on
+        // its own, starting from an arbitrary normal perpendicular to its first tangent, so that patches can be
+        // transported in any order and in parallel. The caller rolls each patch about the tangents to join them.
+        // Writes the unit tangent and normal of patch i at t = k / 3 to sample (offset + 4 * i + k), the tangent
+        // and normal arrays must be large enough. The other arrays and the count are not touched.
+        static void TransportFrames(const QVector3D* bezierControlPoints, int patchCount, SplineSamples& samples, int offset);
+
+        // The vectorized kernels are used by default if the CPU supports them
+        static void SetSimdEnabled(bool enabled);
+        static bool GetSimdEnabled();
+
+        // "AVX2", "NEON" or "Scalar"
+        static const char* GetKernelName();
+
+      private:
+        static void Resize(SplineSamples& samples, int count, int outputs);
+
+        static bool mSimdEnabled;
+    };
+}
@@ -0,0 +1,316 @@
+#include "Curve/SplineEvaluatorKernel.h"
+
+// Built with AVX2 and FMA code generation enabled, only called after a CPU check
+
+#if defined(BR_AVX2_KERNEL)
+
+#include <immintrin.h>
+
+namespace
+{
+    struct Vector3
+    {
+        __m256 x;
+        __m256 y;
+        __m256 z;
+    };
+
+    inline __m256 Dot(const Vector3& u, const Vector3& v)
+    {
+        return _mm256_fmadd_ps(u.x, v.x, _mm256_fmadd_ps(u.y, v.y, _mm256_mul_ps(u.z, v.z)));
+    }
+
+    inline Vector3 Cross(const Vector3& u, const Vector3& v)
+    {
+        return {
+            _mm256_fmsub_ps(u.y, v.z, _mm256_mul_ps(u.z, v.y)),
+            _mm256_fmsub_ps(u.z, v.x, _mm256_mul_ps(u.x, v.z)),
+            _mm256_fmsub_ps(u.x, v.y, _mm256_mul_ps(u.y, v.x)),
+        };
+    }
+
+    inline Vector3 Scale(const Vector3& u, __m256 s)
+    {
+        return { _mm256_mul_ps(u.x, s), _mm256_mul_ps(u.y, s), _mm256_mul_ps(u.z, s) };
+    }
+
+    inline Vector3 Select(const Vector3& ifFalse, const Vector3& ifTrue, __m256 mask)
+    {
+        return {
+            _mm256_blendv_ps(ifFalse.x, ifTrue.x, mask),
+            _mm256_blendv_ps(ifFalse.y, ifTrue.y, mask),
+            _mm256_blendv_ps(ifFalse.z, ifTrue.z, mask),
+        };
+    }
+
+    inline void Store(float* const (&target)[3], int index, const Vector3& v)
+    {
+        _mm256_storeu_ps(target[0] + index, v.x);
+        _mm256_storeu_ps(target[1] + index, v.y);
+        _mm256_storeu_ps(target[2] + index, v.z);
+    }
+
+    inline Vector3 Add(const Vector3& u, const Vector3& v)
+    {
+        return { _mm256_add_ps(u.x, v.x), _mm256_add_ps(u.y, v.y), _mm256_add_ps(u.z, v.z) };
+    }
+
+    inline Vector3 Subtract(const Vector3& u, const Vector3& v)
+    {
+        return { _mm256_sub_ps(u.x, v.x), _mm256_sub_ps(u.y, v.y), _mm256_sub_ps(u.z, v.z) };
+    }
+
+    // u - s * v
+    inline Vector3 SubtractScaled(const Vector3& u, __m256 s, const Vector3& v)
+    {
+        return { _mm256_fnmadd_ps(s, v.x, u.x), _mm256_fnmadd_ps(s, v.y, u.y), _mm256_fnmadd_ps(s, v.z, u.z) };
+    }
+
+    // Lane i goes to index + stride * i
+    inline void Scatter(float* const (&target)[3], int index, int stride, const Vector3& v)
+    {
+        alignas(32) float x[8];
+        alignas(32) float y[8];
+        alignas(32) float z[8];
+
+        _mm256_store_ps(x, v.x);
+        _mm256_store_ps(y, v.y);
+        _mm256_store_ps(z, v.z);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            target[0][index + stride * i] = x[i];
+            target[1][index + stride * i] = y[i];
+            target[2][index + stride * i] = z[i];
+        }
+    }
+}
+
+void BSplineRenderer::EvaluateAVX2(const PatchCoefficients& patch, const float* t, int count, const SampleOutput& output, int offset)
+{
+    constexpr int LANES = 8;
+
+    __m256 a[3], b[3], c2[3], c[3], d[3], d3[3], d6[3];
+
+    for (int k = 0; k < 3; ++k)
+    {
+        a[k] = _mm256_set1_ps(patch.a[k]);
+        b[k] = _mm256_set1_ps(patch.b[k]);
+        c[k] = _mm256_set1_ps(patch.c[k]);
+        c2[k] = _mm256_set1_ps(2.0f * patch.c[k]);
+        d[k] = _mm256_set1_ps(patch.d[k]);
+        d3[k] = _mm256_set1_ps(3.0f * patch.d[k]);
+        d6[k] = _mm256_set1_ps(6.0f * patch.d[k]);
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 nearlyOne = _mm256_set1_ps(0.9f);
+    const __m256 minSpeed2 = _mm256_set1_ps(FRAME_MIN_SPEED_SQUARED);
+    const __m256 minCurvatureRatio = _mm256_set1_ps(FRAME_MIN_CURVATURE_RATIO);
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        const __m256 u = _mm256_loadu_ps(t + i);
+        const int index = offset + i;
+
+        if (output.position[0])
+        {
+            const Vector3 position = {
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d[0], c[0]), b[0]), a[0]),
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d[1], c[1]), b[1]), a[1]),
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d[2], c[2]), b[2]), a[2]),
+            };
+
+            Store(output.position, index, position);
+        }
+
+        if (output.firstDerivative[0] == nullptr && output.secondDerivative[0] == nullptr && output.tangent[0] == nullptr)
+        {
+            continue;
+        }
+
+        const Vector3 d1 = {
+            _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d3[0], c2[0]), b[0]),
+            _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d3[1], c2[1]), b[1]),
+            _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d3[2], c2[2]), b[2]),
+        };
+
+        const Vector3 d2 = {
+            _mm256_fmadd_ps(u, d6[0], c2[0]),
+            _mm256_fmadd_ps(u, d6[1], c2[1]),
+            _mm256_fmadd_ps(u, d6[2], c2[2]),
+        };
+
+        if (output.firstDerivative[0])
+        {
+            Store(output.firstDerivative, index, d1);
+        }
+
+        if (output.secondDerivative[0])
+        {
+            Store(output.secondDerivative, index, d2);
+        }
+
+        if (output.tangent[0])
+        {
+            // Same steps and fallbacks as EvaluateScalar
+            const __m256 speed2 = Dot(d1, d1);
+            const __m256 moving = _mm256_cmp_ps(speed2, minSpeed2, _CMP_GT_OQ);
+            const __m256 inverseSpeed = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_max_ps(speed2, minSpeed2)));
+            const Vector3 tangent = Select({ one, zero, zero }, Scale(d1, inverseSpeed), moving);
+
+            Vector3 binormal = Cross(tangent, d2);
+            const __m256 threshold = _mm256_fmadd_ps(minCurvatureRatio, Dot(d2, d2), minSpeed2);
+            const __m256 straight = _mm256_cmp_ps(Dot(binormal, binormal), threshold, _CMP_LE_OQ);
+
+            if (_mm256_movemask_ps(straight) != 0)
+            {
+                const __m256 negativeZ = _mm256_xor_ps(tangent.z, signMask);
+                const __m256 alongY = _mm256_cmp_ps(_mm256_andnot_ps(signMask, tangent.y), nearlyOne, _CMP_GE_OQ);
+                const Vector3 crossY = { negativeZ, zero, tangent.x };
+                const Vector3 crossX = { zero, tangent.z, _mm256_xor_ps(tangent.y, signMask) };
+                binormal = Select(binormal, Select(crossY, crossX, alongY), straight);
+            }
+
+            binormal = Scale(binormal, _mm256_div_ps(one, _mm256_sqrt_ps(Dot(binormal, binormal))));
+
+            Store(output.tangent, index, tangent);
+            Store(output.binormal, index, binormal);
+            Store(output.normal, index, Cross(binormal, tangent));
+        }
+    }
+
+    EvaluateScalar(patch, t + vectorCount, count - vectorCount, output, offset + vectorCount);
+}
+
+void BSplineRenderer::TransportAVX2(const float* controlPoints, int count, const SampleOutput& output, int offset)
+{
+    // One patch per lane, the steps of TransportScalar with masks instead of branches
+    constexpr int LANES = 8;
+    constexpr int SAMPLES = FRAME_STEPS_PER_PATCH + 1;
+    constexpr int PATCH_SIZE = 12;
+
+    const __m256i patchOffsets = _mm256_setr_epi32(0, 12, 24, 36, 48, 60, 72, 84);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 nearlyOne = _mm256_set1_ps(0.9f);
+    const __m256 epsilon = _mm256_set1_ps(FRAME_TRANSPORT_EPSILON);
+
+    const auto perpendicular = [&](const Vector3& tangent) {
+        const __m256 alongY = _mm256_cmp_ps(_mm256_andnot_ps(signMask, tangent.y), nearlyOne, _CMP_GE_OQ);
+        const Vector3 crossY = { _mm256_xor_ps(tangent.z, signMask), zero, tangent.x };
+        const Vector3 crossX = { zero, tangent.z, _mm256_xor_ps(tangent.y, signMask) };
+        const Vector3 result = Select(crossY, crossX, alongY);
+        return Scale(result, _mm256_div_ps(one, _mm256_sqrt_ps(Dot(result, result))));
+    };
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        Vector3 p[4];
+
+        for (int j = 0; j < 4; ++j)
+        {
+            const float* point = controlPoints + PATCH_SIZE * i + 3 * j;
+            p[j] = { _mm256_i32gather_ps(point, patchOffsets, 4), _mm256_i32gather_ps(point + 1, patchOffsets, 4), _mm256_i32gather_ps(point + 2, patchOffsets, 4) };
+        }
+
+        // Power basis as in GetCoefficients
+        const Vector3 a = p[0];
+        const Vector3 b = Scale(Subtract(p[1], p[0]), three);
+        const Vector3 c = Scale(Add(Subtract(p[2], Scale(p[1], two)), p[0]), three);
+        const Vector3 d = Subtract(Add(Subtract(p[3], Scale(p[2], three)), Scale(p[1], three)), p[0]);
+        const Vector3 c2 = Scale(c, two);
+        const Vector3 d3 = Scale(d, three);
+
+        Vector3 position[SAMPLES];
+        Vector3 tangent[SAMPLES];
+        __m256 moving[SAMPLES];
+
+        for (int j = 0; j < SAMPLES; ++j)
+        {
+            const __m256 u = _mm256_set1_ps(j / float(FRAME_STEPS_PER_PATCH));
+
+            position[j] = {
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d.x, c.x), b.x), a.x),
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d.y, c.y), b.y), a.y),
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d.z, c.z), b.z), a.z),
+            };
+
+            const Vector3 derivative = {
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d3.x, c2.x), b.x),
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d3.y, c2.y), b.y),
+                _mm256_fmadd_ps(u, _mm256_fmadd_ps(u, d3.z, c2.z), b.z),
+            };
+
+            const __m256 speed2 = Dot(derivative, derivative);
+            moving[j] = _mm256_cmp_ps(speed2, epsilon, _CMP_GT_OQ);
+            tangent[j] = Scale(derivative, _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_max_ps(speed2, epsilon))));
+        }
+
+        for (int j = 1; j < SAMPLES; ++j)
+        {
+            tangent[j] = Select(tangent[j], tangent[j - 1], _mm256_andnot_ps(moving[j], moving[j - 1]));
+            moving[j] = _mm256_or_ps(moving[j], moving[j - 1]);
+        }
+
+        for (int j = SAMPLES - 2; j >= 0; --j)
+        {
+            tangent[j] = Select(tangent[j], tangent[j + 1], _mm256_andnot_ps(moving[j], moving[j + 1]));
+            moving[j] = _mm256_or_ps(moving[j], moving[j + 1]);
+        }
+
+        for (int j = 0; j < SAMPLES; ++j)
+        {
+            tangent[j] = Select({ one, zero, zero }, tangent[j], moving[0]);
+        }
+
+        Vector3 normal = perpendicular(tangent[0]);
+        Scatter(output.tangent, offset + 4 * i, 4, tangent[0]);
+        Scatter(output.normal, offset + 4 * i, 4, normal);
+
+        for (int j = 1; j < SAMPLES; ++j)
+        {
+            const Vector3 v1 = Subtract(position[j], position[j - 1]);
+            const __m256 c1 = Dot(v1, v1);
+            const __m256 step = _mm256_cmp_ps(c1, epsilon, _CMP_GT_OQ);
+            const __m256 scale1 = _mm256_and_ps(step, _mm256_div_ps(two, _mm256_max_ps(c1, epsilon)));
+
+            Vector3 r = SubtractScaled(normal, _mm256_mul_ps(scale1, Dot(v1, normal)), v1);
+            const Vector3 v2 = Subtract(tangent[j], SubtractScaled(tangent[j - 1], _mm256_mul_ps(scale1, Dot(v1, tangent[j - 1])), v1));
+            const __m256 c2 = Dot(v2, v2);
+            const __m256 reflect = _mm256_and_ps(step, _mm256_cmp_ps(c2, epsilon, _CMP_GT_OQ));
+            const __m256 scale2 = _mm256_and_ps(reflect, _mm256_div_ps(two, _mm256_max_ps(c2, epsilon)));
+
+            r = SubtractScaled(r, _mm256_mul_ps(scale2, Dot(v2, r)), v2);
+            r = SubtractScaled(r, Dot(r, tangent[j]), tangent[j]);
+
+            const __m256 r2 = Dot(r, r);
+            const __m256 valid = _mm256_cmp_ps(r2, epsilon, _CMP_GT_OQ);
+            normal = Scale(r, _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_max_ps(r2, epsilon))));
+
+            if (_mm256_movemask_ps(valid) != 0xFF)
+            {
+                normal = Select(perpendicular(tangent[j]), normal, valid);
+            }
+
+            if (j % FRAME_STEPS_PER_NORMAL == 0)
+            {
+                Scatter(output.tangent, offset + 4 * i + j / FRAME_STEPS_PER_NORMAL, 4, tangent[j]);
+                Scatter(output.normal, offset + 4 * i + j / FRAME_STEPS_PER_NORMAL, 4, normal);
+            }
+        }
+    }
+
+    TransportScalar(controlPoints + PATCH_SIZE * vectorCount, count - vectorCount, output, offset + 4 * vectorCount);
+}
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+// Internal to SplineEvaluator, shared by the scalar and the vectorized kernels
+
+namespace BSplineRenderer
+{
+    // Power basis of a cubic Bezier patch, B(t) = a + t (b + t (c + t d)) per component
+    struct PatchCoefficients
+    {
+        float a[3];
+        float b[3];
+        float c[3];
+        float d[3];
+    };
+
+    // Output arrays of a run of samples, null arrays are not written
+    struct SampleOutput
+    {
+        float* position[3];
+        float* firstDerivative[3];
+        float* secondDerivative[3];
+        float* tangent[3];
+        float* normal[3];
+        float* binormal[3];
+    };
+
+    // Evaluates one patch at t[0, count) and writes sample i to index (offset + i) of the outputs
+    using EvaluationKernel = void (*)(const PatchCoefficients& patch, const float* t, int count, const SampleOutput& output, int offset);
+
+    // Transports a frame over each of count patches, 12 floats of control points per patch. Writes the tangent
+    // and the normal of patch i at t = k / 3 to index (offset + 4 * i + k), see SplineEvaluator::TransportFrames.
+    using TransportKernel = void (*)(const float* controlPoints, int count, const SampleOutput& output, int offset);
+
+    // True if the CPU and the OS support AVX2 and FMA, shared with the KnotDeformer kernels
+    bool IsAVX2Supported();
+
+    void EvaluateScalar(const PatchCoefficients& patch, const float* t, int count, const SampleOutput& output, int offset);
+    void TransportScalar(const float* controlPoints, int count, const SampleOutput& output, int offset);
+
+#if defined(BR_AVX2_KERNEL)
+    void EvaluateAVX2(const PatchCoefficients& patch, const float* t, int count, const SampleOutput& output, int offset);
+    void TransportAVX2(const float* controlPoints, int count, const SampleOutput& output, int offset);
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    void EvaluateNEON(const PatchCoefficients& patch, const float* t, int count, const SampleOutput& output, int offset);
+    void TransportNEON(const float* controlPoints, int count, const SampleOutput& output, int offset);
+#endif
+
+    // Thresholds of the degenerate cases of the frame computation, shared so that all kernels agree
+    constexpr float FRAME_MIN_SPEED_SQUARED = 1e-20f;
+    constexpr float FRAME_MIN_CURVATURE_RATIO = 1e-8f;
+
+    // Double reflection steps per patch of the transport, a multiple of 3 so that t = 1 / 3 and t = 2 / 3 are steps
+    constexpr int FRAME_STEPS_PER_PATCH = 6;
+    constexpr int FRAME_STEPS_PER_NORMAL = FRAME_STEPS_PER_PATCH / 3;
+
+    // Steps, derivatives and normals with a smaller squared length are degenerate in the transport
+    constexpr float FRAME_TRANSPORT_EPSILON = 1e-12f;
+}
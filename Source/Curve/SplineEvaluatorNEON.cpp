@@ -0,0 +1,322 @@
+#include "Curve/SplineEvaluatorKernel.h"
+
+// NEON is part of the AArch64 baseline, no CPU check is needed
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace
+{
+    struct Vector3
+    {
+        float32x4_t x;
+        float32x4_t y;
+        float32x4_t z;
+    };
+
+    inline float32x4_t Dot(const Vector3& u, const Vector3& v)
+    {
+        return vfmaq_f32(vfmaq_f32(vmulq_f32(u.z, v.z), u.y, v.y), u.x, v.x);
+    }
+
+    inline Vector3 Cross(const Vector3& u, const Vector3& v)
+    {
+        return {
+            vfmsq_f32(vmulq_f32(u.y, v.z), u.z, v.y),
+            vfmsq_f32(vmulq_f32(u.z, v.x), u.x, v.z),
+            vfmsq_f32(vmulq_f32(u.x, v.y), u.y, v.x),
+        };
+    }
+
+    inline Vector3 Scale(const Vector3& u, float32x4_t s)
+    {
+        return { vmulq_f32(u.x, s), vmulq_f32(u.y, s), vmulq_f32(u.z, s) };
+    }
+
+    inline Vector3 Select(const Vector3& ifFalse, const Vector3& ifTrue, uint32x4_t mask)
+    {
+        return {
+            vbslq_f32(mask, ifTrue.x, ifFalse.x),
+            vbslq_f32(mask, ifTrue.y, ifFalse.y),
+            vbslq_f32(mask, ifTrue.z, ifFalse.z),
+        };
+    }
+
+    inline void Store(float* const (&target)[3], int index, const Vector3& v)
+    {
+        vst1q_f32(target[0] + index, v.x);
+        vst1q_f32(target[1] + index, v.y);
+        vst1q_f32(target[2] + index, v.z);
+    }
+
+    inline Vector3 Add(const Vector3& u, const Vector3& v)
+    {
+        return { vaddq_f32(u.x, v.x), vaddq_f32(u.y, v.y), vaddq_f32(u.z, v.z) };
+    }
+
+    inline Vector3 Subtract(const Vector3& u, const Vector3& v)
+    {
+        return { vsubq_f32(u.x, v.x), vsubq_f32(u.y, v.y), vsubq_f32(u.z, v.z) };
+    }
+
+    // u - s * v
+    inline Vector3 SubtractScaled(const Vector3& u, float32x4_t s, const Vector3& v)
+    {
+        return { vfmsq_f32(u.x, s, v.x), vfmsq_f32(u.y, s, v.y), vfmsq_f32(u.z, s, v.z) };
+    }
+
+    // Lane i is read from source[stride * i]
+    inline float32x4_t Gather(const float* source, int stride)
+    {
+        const float lanes[4] = { source[0], source[stride], source[2 * stride], source[3 * stride] };
+        return vld1q_f32(lanes);
+    }
+
+    // Lane i goes to index + stride * i
+    inline void Scatter(float* const (&target)[3], int index, int stride, const Vector3& v)
+    {
+        float x[4];
+        float y[4];
+        float z[4];
+
+        vst1q_f32(x, v.x);
+        vst1q_f32(y, v.y);
+        vst1q_f32(z, v.z);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            target[0][index + stride * i] = x[i];
+            target[1][index + stride * i] = y[i];
+            target[2][index + stride * i] = z[i];
+        }
+    }
+}
+
+void BSplineRenderer::EvaluateNEON(const PatchCoefficients& patch, const float* t, int count, const SampleOutput& output, int offset)
+{
+    constexpr int LANES = 4;
+
+    float32x4_t a[3], b[3], c2[3], c[3], d[3], d3[3], d6[3];
+
+    for (int k = 0; k < 3; ++k)
+    {
+        a[k] = vdupq_n_f32(patch.a[k]);
+        b[k] = vdupq_n_f32(patch.b[k]);
+        c[k] = vdupq_n_f32(patch.c[k]);
+        c2[k] = vdupq_n_f32(2.0f * patch.c[k]);
+        d[k] = vdupq_n_f32(patch.d[k]);
+        d3[k] = vdupq_n_f32(3.0f * patch.d[k]);
+        d6[k] = vdupq_n_f32(6.0f * patch.d[k]);
+    }
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t nearlyOne = vdupq_n_f32(0.9f);
+    const float32x4_t minSpeed2 = vdupq_n_f32(FRAME_MIN_SPEED_SQUARED);
+    const float32x4_t minCurvatureRatio = vdupq_n_f32(FRAME_MIN_CURVATURE_RATIO);
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        const float32x4_t u = vld1q_f32(t + i);
+        const int index = offset + i;
+
+        if (output.position[0])
+        {
+            const Vector3 position = {
+                vfmaq_f32(a[0], u, vfmaq_f32(b[0], u, vfmaq_f32(c[0], u, d[0]))),
+                vfmaq_f32(a[1], u, vfmaq_f32(b[1], u, vfmaq_f32(c[1], u, d[1]))),
+                vfmaq_f32(a[2], u, vfmaq_f32(b[2], u, vfmaq_f32(c[2], u, d[2]))),
+            };
+
+            Store(output.position, index, position);
+        }
+
+        if (output.firstDerivative[0] == nullptr && output.secondDerivative[0] == nullptr && output.tangent[0] == nullptr)
+        {
+            continue;
+        }
+
+        const Vector3 d1 = {
+            vfmaq_f32(b[0], u, vfmaq_f32(c2[0], u, d3[0])),
+            vfmaq_f32(b[1], u, vfmaq_f32(c2[1], u, d3[1])),
+            vfmaq_f32(b[2], u, vfmaq_f32(c2[2], u, d3[2])),
+        };
+
+        const Vector3 d2 = {
+            vfmaq_f32(c2[0], u, d6[0]),
+            vfmaq_f32(c2[1], u, d6[1]),
+            vfmaq_f32(c2[2], u, d6[2]),
+        };
+
+        if (output.firstDerivative[0])
+        {
+            Store(output.firstDerivative, index, d1);
+        }
+
+        if (output.secondDerivative[0])
+        {
+            Store(output.secondDerivative, index, d2);
+        }
+
+        if (output.tangent[0])
+        {
+            // Same steps and fallbacks as EvaluateScalar
+            const float32x4_t speed2 = Dot(d1, d1);
+            const uint32x4_t moving = vcgtq_f32(speed2, minSpeed2);
+            const float32x4_t inverseSpeed = vdivq_f32(one, vsqrtq_f32(vmaxq_f32(speed2, minSpeed2)));
+            const Vector3 tangent = Select({ one, zero, zero }, Scale(d1, inverseSpeed), moving);
+
+            Vector3 binormal = Cross(tangent, d2);
+            const float32x4_t threshold = vfmaq_f32(minSpeed2, minCurvatureRatio, Dot(d2, d2));
+            const uint32x4_t straight = vcleq_f32(Dot(binormal, binormal), threshold);
+
+            if (vmaxvq_u32(straight) != 0)
+            {
+                const uint32x4_t alongY = vcgeq_f32(vabsq_f32(tangent.y), nearlyOne);
+                const Vector3 crossY = { vnegq_f32(tangent.z), zero, tangent.x };
+                const Vector3 crossX = { zero, tangent.z, vnegq_f32(tangent.y) };
+                binormal = Select(binormal, Select(crossY, crossX, alongY), straight);
+            }
+
+            binormal = Scale(binormal, vdivq_f32(one, vsqrtq_f32(Dot(binormal, binormal))));
+
+            Store(output.tangent, index, tangent);
+            Store(output.binormal, index, binormal);
+            Store(output.normal, index, Cross(binormal, tangent));
+        }
+    }
+
+    EvaluateScalar(patch, t + vectorCount, count - vectorCount, output, offset + vectorCount);
+}
+
+void BSplineRenderer::TransportNEON(const float* controlPoints, int count, const SampleOutput& output, int offset)
+{
+    // One patch per lane, the steps of TransportScalar with masks instead of branches
+    constexpr int LANES = 4;
+    constexpr int SAMPLES = FRAME_STEPS_PER_PATCH + 1;
+    constexpr int PATCH_SIZE = 12;
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    const float32x4_t three = vdupq_n_f32(3.0f);
+    const float32x4_t nearlyOne = vdupq_n_f32(0.9f);
+    const float32x4_t epsilon = vdupq_n_f32(FRAME_TRANSPORT_EPSILON);
+
+    const auto perpendicular = [&](const Vector3& tangent) {
+        const uint32x4_t alongY = vcgeq_f32(vabsq_f32(tangent.y), nearlyOne);
+        const Vector3 crossY = { vnegq_f32(tangent.z), zero, tangent.x };
+        const Vector3 crossX = { zero, tangent.z, vnegq_f32(tangent.y) };
+        const Vector3 result = Select(crossY, crossX, alongY);
+        return Scale(result, vdivq_f32(one, vsqrtq_f32(Dot(result, result))));
+    };
+
+    // Zeroes the lanes whose mask is not set
+    const auto mask = [](uint32x4_t condition, float32x4_t value) { return vreinterpretq_f32_u32(vandq_u32(condition, vreinterpretq_u32_f32(value))); };
+
+    const int vectorCount = count - count % LANES;
+
+    for (int i = 0; i < vectorCount; i += LANES)
+    {
+        Vector3 p[4];
+
+        for (int j = 0; j < 4; ++j)
+        {
+            const float* point = controlPoints + PATCH_SIZE * i + 3 * j;
+            p[j] = { Gather(point, PATCH_SIZE), Gather(point + 1, PATCH_SIZE), Gather(point + 2, PATCH_SIZE) };
+        }
+
+        // Power basis as in GetCoefficients
+        const Vector3 a = p[0];
+        const Vector3 b = Scale(Subtract(p[1], p[0]), three);
+        const Vector3 c = Scale(Add(Subtract(p[2], Scale(p[1], two)), p[0]), three);
+        const Vector3 d = Subtract(Add(Subtract(p[3], Scale(p[2], three)), Scale(p[1], three)), p[0]);
+        const Vector3 c2 = Scale(c, two);
+        const Vector3 d3 = Scale(d, three);
+
+        Vector3 position[SAMPLES];
+        Vector3 tangent[SAMPLES];
+        uint32x4_t moving[SAMPLES];
+
+        for (int j = 0; j < SAMPLES; ++j)
+        {
+            const float32x4_t u = vdupq_n_f32(j / float(FRAME_STEPS_PER_PATCH));
+
+            position[j] = {
+                vfmaq_f32(a.x, u, vfmaq_f32(b.x, u, vfmaq_f32(c.x, u, d.x))),
+                vfmaq_f32(a.y, u, vfmaq_f32(b.y, u, vfmaq_f32(c.y, u, d.y))),
+                vfmaq_f32(a.z, u, vfmaq_f32(b.z, u, vfmaq_f32(c.z, u, d.z))),
+            };
+
+            const Vector3 derivative = {
+                vfmaq_f32(b.x, u, vfmaq_f32(c2.x, u, d3.x)),
+                vfmaq_f32(b.y, u, vfmaq_f32(c2.y, u, d3.y)),
+                vfmaq_f32(b.z, u, vfmaq_f32(c2.z, u, d3.z)),
+            };
+
+            const float32x4_t speed2 = Dot(derivative, derivative);
+            moving[j] = vcgtq_f32(speed2, epsilon);
+            tangent[j] = Scale(derivative, vdivq_f32(one, vsqrtq_f32(vmaxq_f32(speed2, epsilon))));
+        }
+
+        for (int j = 1; j < SAMPLES; ++j)
+        {
+            tangent[j] = Select(tangent[j], tangent[j - 1], vbicq_u32(moving[j - 1], moving[j]));
+            moving[j] = vorrq_u32(moving[j], moving[j - 1]);
+        }
+
+        for (int j = SAMPLES - 2; j >= 0; --j)
+        {
+            tangent[j] = Select(tangent[j], tangent[j + 1], vbicq_u32(moving[j + 1], moving[j]));
+            moving[j] = vorrq_u32(moving[j], moving[j + 1]);
+        }
+
+        for (int j = 0; j < SAMPLES; ++j)
+        {
+            tangent[j] = Select({ one, zero, zero }, tangent[j], moving[0]);
+        }
+
+        Vector3 normal = perpendicular(tangent[0]);
+        Scatter(output.tangent, offset + 4 * i, 4, tangent[0]);
+        Scatter(output.normal, offset + 4 * i, 4, normal);
+
+        for (int j = 1; j < SAMPLES; ++j)
+        {
+            const Vector3 v1 = Subtract(position[j], position[j - 1]);
+            const float32x4_t c1 = Dot(v1, v1);
+            const uint32x4_t step = vcgtq_f32(c1, epsilon);
+            const float32x4_t scale1 = mask(step, vdivq_f32(two, vmaxq_f32(c1, epsilon)));
+
+            Vector3 r = SubtractScaled(normal, vmulq_f32(scale1, Dot(v1, normal)), v1);
+            const Vector3 v2 = Subtract(tangent[j], SubtractScaled(tangent[j - 1], vmulq_f32(scale1, Dot(v1, tangent[j - 1])), v1));
+            const float32x4_t c2 = Dot(v2, v2);
+            const uint32x4_t reflect = vandq_u32(step, vcgtq_f32(c2, epsilon));
+            const float32x4_t scale2 = mask(reflect, vdivq_f32(two, vmaxq_f32(c2, epsilon)));
+
+            r = SubtractScaled(r, vmulq_f32(scale2, Dot(v2, r)), v2);
+            r = SubtractScaled(r, Dot(r, tangent[j]), tangent[j]);
+
+            const float32x4_t r2 = Dot(r, r);
+            const uint32x4_t valid = vcgtq_f32(r2, epsilon);
+            normal = Scale(r, vdivq_f32(one, vsqrtq_f32(vmaxq_f32(r2, epsilon))));
+
+            if (vminvq_u32(valid) == 0)
+            {
+                normal = Select(perpendicular(tangent[j]), normal, valid);
+            }
+
+            if (j % FRAME_STEPS_PER_NORMAL == 0)
+            {
+                Scatter(output.tangent, offset + 4 * i + j / FRAME_STEPS_PER_NORMAL, 4, tangent[j]);
+                Scatter(output.normal, offset + 4 * i + j / FRAME_STEPS_PER_NORMAL, 4, normal);
+            }
+        }
+    }
+
+    TransportScalar(controlPoints + PATCH_SIZE * vectorCount, count - vectorCount, output, offset + 4 * vectorCount);
+}
+
+#endif
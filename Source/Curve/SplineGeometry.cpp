@@ -0,0 +1,811 @@
+#include "SplineGeometry.h"
+
+#include "Curve/SplineSolver.h"
+#include "Util/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+    constexpr float FRAME_EPSILON = 1e-12f;
+
+    // Long curves are transported in chunks of this many patches on several threads
+    constexpr int FRAME_PATCHES_PER_JOB = 1024;
+
+    QVector3D GetPerpendicular(const QVector3D& tangent)
+    {
+        if (std::abs(tangent.y()) < 0.9f)
+        {
+            return QVector3D(-tangent.z(), 0.0f, tangent.x()).normalized();
+        }
+
+        return QVector3D(0.0f, tangent.z(), -tangent.y()).normalized();
+    }
+
+    QVector3D Orthonormalize(const QVector3D& normal, const QVector3D& tangent)
+    {
+        const QVector3D projected = normal - QVector3D::dotProduct(normal, tangent) * tangent;
+
+        if (projected.lengthSquared() <= FRAME_EPSILON)
+        {
+            return GetPerpendicular(tangent);
+        }
+
+        return projected.normalized();
+    }
+
+    // Rotates a vector perpendicular to the unit axis about the axis, by the angle of the given cosine and sine
+    QVector3D Rotate(const QVector3D& vector, const QVector3D& axis, float cosine, float sine)
+    {
+        return cosine * vector + sine * QVector3D::crossProduct(axis, vector);
+    }
+
+    // Cosine and sine of the roll about the unit axis that turns the normal "from" onto "to", both
+    // perpendicular to the axis. No roll if "to" is degenerate.
+    void GetRoll(const QVector3D& from, const QVector3D& to, const QVector3D& axis, float& cosine, float& sine)
+    {
+        cosine = QVector3D::dotProduct(to, from);
+        sine = QVector3D::dotProduct(to, QVector3D::crossProduct(axis, from));
+
+        const float length2 = cosine * cosine + sine * sine;
+
+        if (length2 <= FRAME_EPSILON)
+        {
+            cosine = 1.0f;
+            sine = 0.0f;
+            return;
+        }
+
+        const float inverse = 1.0f / std::sqrt(length2);
+        cosine *= inverse;
+        sine *= inverse;
+    }
+}
+
+void BSplineRenderer::SplineGeometry::AddKnot(KnotPtr knot)
+{
+    mKnots << knot;
+    MakeDirty();
+}
+
+BSplineRenderer::KnotPtr BSplineRenderer::SplineGeometry::AddKnot(float x, float y, float z)
+{
+    return AddKnot(QVector3D(x, y, z));
+}
+
+BSplineRenderer::KnotPtr BSplineRenderer::SplineGeometry::AddKnot(const QVector3D& position)
+{
+    KnotPtr knot = std::make_shared<Knot>(position);
+    mKnots << knot;
+    MakeDirty();
+    return knot;
+}
+
+void BSplineRenderer::SplineGeometry::AddKnots(const QVector3D* positions, int count)
+{
+    mKnots.reserve(mKnots.size() + count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        mKnots << std::make_shared<Knot>(positions[i]);
+    }
+
+    MakeDirty();
+}
+
+void BSplineRenderer::SplineGeometry::MakeDirty()
+{
+    mDirty = true;
+}
+
+void BSplineRenderer::SplineGeometry::UpdateIfDirty()
+{
+    if (IsDirty())
+    {
+        Update();
+    }
+}
+
+void BSplineRenderer::SplineGeometry::Update()
+{
+    if (mDirty || UpdateLocally() == false)
+    {
+        UpdateFully();
+    }
+
+    mDirty = false;
+    mControlPointsSolved = false;
+    mDirtyKnotFirst = -1;
+    mDirtyKnotLast = -1;
+    IncrementVersion();
+}
+
+void BSplineRenderer::SplineGeometry::UpdateBatch(const QVector<SplineGeometry*>& splines)
+{
+    struct SolveGroup
+    {
+        QVector<const QVector<KnotPtr>*> knots;
+        QVector<QVector<QVector3D>*> controlPoints;
+    };
+
+    std::unordered_map<int, SolveGroup> groups;
+    QVector<SplineGeometry*> dirtySplines;
+    int dirtyKnotCount = 0;
+
+    for (const auto& spline : splines)
+    {
+        if (spline->IsDirty() == false)
+        {
+            continue;
+        }
+
+        dirtySplines << spline;
+        dirtyKnotCount += spline->mKnots.size();
+
+        if (spline->mDirty && spline->mKnots.size() >= 4)
+        {
+            auto& group = groups[spline->mKnots.size()];
+            group.knots << &spline->mKnots;
+            group.controlPoints << &spline->mSplineControlPoints;
+            spline->mControlPointsSolved = true;
+        }
+    }
+
+    // Large groups are split so that their systems are solved on several threads
+    std::vector<SolveGroup> jobs;
+
+    for (const auto& [knotCount, group] : groups)
+    {
+        for (int first = 0; first < group.knots.size(); first += MAX_SPLINES_PER_SOLVE)
+        {
+            const int count = std::min<int>(MAX_SPLINES_PER_SOLVE, group.knots.size() - first);
+            jobs.push_back({ group.knots.mid(first, count), group.controlPoints.mid(first, count) });
+        }
+    }
+
+    // Every spline only touches its own data and the solver cache is locked, small updates stay on this thread
+    if (dirtyKnotCount < MIN_PARALLEL_KNOT_COUNT)
+    {
+        for (const auto& job : jobs)
+        {
+            SplineSolver::SolveBatch(job.knots, job.controlPoints);
+        }
+
+        for (const auto& spline : dirtySplines)
+        {
+            spline->Update();
+        }
+
+        return;
+    }
+
+    JobSystem::Instance().Map(jobs, [](const SolveGroup& job) { SplineSolver::SolveBatch(job.knots, job.controlPoints); });
+    JobSystem::Instance().Map(dirtySplines, [](SplineGeometry* spline) { spline->Update(); });
+}
+
+void BSplineRenderer::SplineGeometry::SetBakedState(const QVector3D* knots, const QVector3D* controlPoints, const QVector3D* normals)
+{
+    const int n = mKnots.size();
+
+    for (int i = 0; i < n; ++i)
+    {
+        mKnots[i]->SetPosition(knots[i]);
+    }
+
+    if (n >= 4)
+    {
+        mSplineControlPoints.resize(n);
+        std::copy_n(controlPoints, n, mSplineControlPoints.begin());
+        mControlPointsSolved = true;
+    }
+
+    BuildBezierControlPoints();
+    mFrameNormals.resize(mBezierControlPoints.size());
+    std::copy_n(normals, mFrameNormals.size(), mFrameNormals.begin());
+    mStaleFrameFirst = 0;
+    mStaleFrameLast = -1;
+
+    mDirty = false;
+    mControlPointsSolved = false;
+    mDirtyKnotFirst = -1;
+    mDirtyKnotLast = -1;
+    mLocalDisplacement = 0.0f;
+
+    MarkPatchesChanged(0, GetPatchCount() - 1);
+    IncrementVersion();
+}
+
+void BSplineRenderer::SplineGeometry::UpdateFully()
+{
+    BuildBezierControlPoints();
+    ScheduleFrames(0, GetPatchCount() - 1);
+
+    mLocalDisplacement = 0.0f;
+
+    MarkPatchesChanged(0, GetPatchCount() - 1);
+}
+
+void BSplineRenderer::SplineGeometry::BuildBezierControlPoints()
+{
+    mBezierControlPoints.clear();
+
+    if (mKnots.size() == 1)
+    {
+        mBezierControlPoints << mKnots[0]->GetPosition();
+        mBezierControlPoints << mKnots[0]->GetPosition();
+        mBezierControlPoints << mKnots[0]->GetPosition();
+        mBezierControlPoints << mKnots[0]->GetPosition();
+    }
+    else if (mKnots.size() == 2)
+    {
+        mBezierControlPoints << mKnots[0]->GetPosition();
+        mBezierControlPoints << mKnots[0]->GetPosition();
+        mBezierControlPoints << mKnots[1]->GetPosition();
+        mBezierControlPoints << mKnots[1]->GetPosition();
+    }
+    else if (mKnots.size() == 3)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            mBezierControlPoints << mKnots.at(i)->GetPosition();
+            mBezierControlPoints << (2.0f / 3.0f) * mKnots.at(i)->GetPosition() + (1.0f / 3.0f) * mKnots.at(i + 1)->GetPosition();
+            mBezierControlPoints << (1.0f / 3.0f) * mKnots.at(i)->GetPosition() + (2.0f / 3.0f) * mKnots.at(i + 1)->GetPosition();
+            mBezierControlPoints << mKnots.at(i + 1)->GetPosition();
+        }
+    }
+    else if (mKnots.size() >= 4)
+    {
+        if (mControlPointsSolved == false)
+        {
+            UpdateSplineControlPoints();
+        }
+
+        mBezierControlPoints.resize(NUM_OF_PATCH_POINTS * (mKnots.size() - 1));
+        UpdateBezierControlPoints(0, mKnots.size() - 2);
+    }
+}
+
+bool BSplineRenderer::SplineGeometry::UpdateLocally()
+{
+    const int n = mKnots.size();
+
+    // Topology changes and short curves are always solved from scratch
+    if (mLocalUpdateEnabled == false || n < 4 || mBezierControlPoints.size() != NUM_OF_PATCH_POINTS * (n - 1))
+    {
+        return false;
+    }
+
+    float displacement = 0.0f;
+
+    for (int i = mDirtyKnotFirst; i <= mDirtyKnotLast; ++i)
+    {
+        displacement = std::max(displacement, (mKnots[i]->GetPosition() - GetSolvedKnotPosition(i)).length());
+    }
+
+    // Size the window by the accumulated displacement so that the error left outside of it stays bounded
+    mLocalDisplacement += displacement;
+
+    const int radius = SplineSolver::GetInfluenceRadius(mLocalDisplacement, mLocalUpdateTolerance);
+    const int first = std::max(1, mDirtyKnotFirst - radius);
+    const int last = std::min(n - 2, mDirtyKnotLast + radius);
+
+    // Not worth it if the window covers most of the curve
+    if (2 * (last - first + 1) > n)
+    {
+        return false;
+    }
+
+    mSplineControlPoints[0] = mKnots[0]->GetPosition();
+    mSplineControlPoints[n - 1] = mKnots[n - 1]->GetPosition();
+
+    if (first <= last)
+    {
+        SplineSolver::SolveRange(mKnots, mSplineControlPoints, first, last);
+    }
+
+    // Patch i spans from knot i to knot i + 1
+    const int firstPatch = std::max(0, std::min(first, mDirtyKnotFirst) - 1);
+    const int lastPatch = std::min(n - 2, std::max(last, mDirtyKnotLast));
+
+    UpdateBezierControlPoints(firstPatch, lastPatch);
+
+    // The frames after the window keep their roll, UpdateFrames() twists the window to meet them
+    ScheduleFrames(firstPatch, lastPatch);
+    MarkPatchesChanged(firstPatch, lastPatch);
+
+    return true;
+}
+
+void BSplineRenderer::SplineGeometry::UpdateBezierControlPoints(int firstPatch, int lastPatch)
+{
+    for (int i = firstPatch; i <= lastPatch; ++i)
+    {
+        QVector3D* patch = mBezierControlPoints.data() + NUM_OF_PATCH_POINTS * i;
+        patch[0] = mKnots.at(i)->GetPosition();
+        patch[1] = (2.0f / 3.0f) * mSplineControlPoints[i] + (1.0f / 3.0f) * mSplineControlPoints[i + 1];
+        patch[2] = (1.0f / 3.0f) * mSplineControlPoints[i] + (2.0f / 3.0f) * mSplineControlPoints[i + 1];
+        patch[3] = mKnots.at(i + 1)->GetPosition();
+    }
+}
+
+void BSplineRenderer::SplineGeometry::ScheduleFrames(int firstPatch, int lastPatch)
+{
+    mFrameNormals.resize(mBezierControlPoints.size());
+
+    // Stale frames of a previous topology are covered by the full range of the new one
+    if (HasStaleFrames())
+    {
+        firstPatch = std::min(firstPatch, mStaleFrameFirst);
+        lastPatch = std::min(std::max(lastPatch, mStaleFrameLast), GetPatchCount() - 1);
+    }
+
+    mStaleFrameFirst = firstPatch;
+    mStaleFrameLast = lastPatch;
+
+    if (mFramesDeferred == false)
+    {
+        UpdateFrames(mStaleFrameFirst, mStaleFrameLast);
+        mStaleFrameFirst = 0;
+        mStaleFrameLast = -1;
+    }
+}
+
+void BSplineRenderer::SplineGeometry::UpdateStaleFrames()
+{
+    if (HasStaleFrames() == false)
+    {
+        return;
+    }
+
+    UpdateFrames(mStaleFrameFirst, mStaleFrameLast);
+    MarkPatchesChanged(mStaleFrameFirst, mStaleFrameLast);
+
+    mStaleFrameFirst = 0;
+    mStaleFrameLast = -1;
+    IncrementVersion();
+}
+
+void BSplineRenderer::SplineGeometry::UpdateFrames(int firstPatch, int lastPatch)
+{
+    if (firstPatch > lastPatch)
+    {
+        return;
+    }
+
+    const int count = lastPatch - firstPatch + 1;
+    const int chunkCount = (count + FRAME_PATCHES_PER_JOB - 1) / FRAME_PATCHES_PER_JOB;
+
+    mFrameSamples.tangent.Resize(NUM_OF_PATCH_POINTS * count);
+    mFrameSamples.normal.Resize(NUM_OF_PATCH_POINTS * count);
+
+    const auto transport = [this, firstPatch, lastPatch](int first, int size) {
+        for (int chunk = first; chunk < first + size; ++chunk)
+        {
+            const int chunkFirst = firstPatch + chunk * FRAME_PATCHES_PER_JOB;
+            TransportFrames(firstPatch, chunkFirst, std::min(lastPatch, chunkFirst + FRAME_PATCHES_PER_JOB - 1));
+        }
+    };
+
+    if (chunkCount > 1)
+    {
+        JobSystem::Instance().ParallelFor(chunkCount, 1, transport);
+        JoinFrames(firstPatch, lastPatch);
+    }
+    else
+    {
+        transport(0, 1);
+    }
+
+    if (lastPatch + 1 < GetPatchCount())
+    {
+        RollFrames(firstPatch, lastPatch);
+    }
+}
+
+void BSplineRenderer::SplineGeometry::TransportFrames(int windowFirst, int firstPatch, int lastPatch)
+{
+    const int offset = NUM_OF_PATCH_POINTS * (firstPatch - windowFirst);
+    SplineEvaluator::TransportFrames(mBezierControlPoints.constData() + NUM_OF_PATCH_POINTS * firstPatch, lastPatch - firstPatch + 1, mFrameSamples, offset);
+
+    // Every patch was transported on its own, roll each onto the end of the previous one. The window continues
+    // from the normal before it, which did not change, other chunks are joined afterwards.
+    const bool continued = firstPatch == windowFirst && firstPatch > 0;
+    QVector3D normal = continued ? mFrameNormals[NUM_OF_PATCH_POINTS * firstPatch - 1] : QVector3D();
+
+    for (int patch = firstPatch; patch <= lastPatch; ++patch)
+    {
+        const int index = NUM_OF_PATCH_POINTS * (patch - windowFirst);
+
+        float cosine = 1.0f;
+        float sine = 0.0f;
+
+        if (patch > firstPatch || continued)
+        {
+            GetRoll(mFrameSamples.normal.At(index), normal, mFrameSamples.tangent.At(index), cosine, sine);
+        }
+
+        for (int k = 0; k < NUM_OF_PATCH_POINTS; ++k)
+        {
+            mFrameNormals[NUM_OF_PATCH_POINTS * patch + k] = Rotate(mFrameSamples.normal.At(index + k), mFrameSamples.tangent.At(index + k), cosine, sine);
+        }
+
+        normal = mFrameNormals[NUM_OF_PATCH_POINTS * patch + NUM_OF_PATCH_POINTS - 1];
+    }
+}
+
+void BSplineRenderer::SplineGeometry::JoinFrames(int firstPatch, int lastPatch)
+{
+    const int chunkCount = (lastPatch - firstPatch) / FRAME_PATCHES_PER_JOB + 1;
+
+    // Roll of every chunk onto the end of the previous chunk after its own roll, the first one is in place
+    std::vector<float> cosines(chunkCount, 1.0f);
+    std::vector<float> sines(chunkCount, 0.0f);
+
+    for (int chunk = 1; chunk < chunkCount; ++chunk)
+    {
+        const int index = NUM_OF_PATCH_POINTS * chunk * FRAME_PATCHES_PER_JOB;
+        const int patch = firstPatch + chunk * FRAME_PATCHES_PER_JOB;
+        const QVector3D end = Rotate(mFrameNormals[NUM_OF_PATCH_POINTS * patch - 1], mFrameSamples.tangent.At(index - 1), cosines[chunk - 1], sines[chunk - 1]);
+
+        GetRoll(mFrameNormals[NUM_OF_PATCH_POINTS * patch], end, mFrameSamples.tangent.At(index), cosines[chunk], sines[chunk]);
+    }
+
+    JobSystem::Instance().ParallelFor(chunkCount - 1, 1, [&](int first, int size) {
+        for (int chunk = first + 1; chunk < first + 1 + size; ++chunk)
+        {
+            const int chunkFirst = firstPatch + chunk * FRAME_PATCHES_PER_JOB;
+            const int chunkLast = std::min(lastPatch, chunkFirst + FRAME_PATCHES_PER_JOB - 1);
+
+            for (int i = NUM_OF_PATCH_POINTS * chunkFirst; i < NUM_OF_PATCH_POINTS * (chunkLast + 1); ++i)
+            {
+                mFrameNormals[i] = Rotate(mFrameNormals[i], mFrameSamples.tangent.At(i - NUM_OF_PATCH_POINTS * firstPatch), cosines[chunk], sines[chunk]);
+            }
+        }
+    });
+}
+
+void BSplineRenderer::SplineGeometry::RollFrames(int firstPatch, int lastPatch)
+{
+    // Angle about the tangent from the new normal at the end of the window to the old one after it
+    const int last = NUM_OF_PATCH_POINTS * (lastPatch - firstPatch) + NUM_OF_PATCH_POINTS - 1;
+    const QVector3D tangent = mFrameSamples.tangent.At(last);
+    const QVector3D normal = mFrameNormals[NUM_OF_PATCH_POINTS * lastPatch + NUM_OF_PATCH_POINTS - 1];
+    const QVector3D target = Orthonormalize(mFrameNormals[NUM_OF_PATCH_POINTS * (lastPatch + 1)], tangent);
+    const float angle = std::atan2(QVector3D::dotProduct(QVector3D::crossProduct(normal, target), tangent), QVector3D::dotProduct(normal, target));
+
+    // Spread evenly over the thirds of the window, so both ends meet the frames around it. The normals at the
+    // end of a patch and at the start of the next one share a parameter and get the same angle.
+    const float thirds = 3.0f * (lastPatch - firstPatch + 1);
+
+    for (int patch = firstPatch; patch <= lastPatch; ++patch)
+    {
+        for (int k = 0; k < NUM_OF_PATCH_POINTS; ++k)
+        {
+            const int index = NUM_OF_PATCH_POINTS * (patch - firstPatch) + k;
+            const float roll = angle * (3 * (patch - firstPatch) + k) / thirds;
+            QVector3D& frameNormal = mFrameNormals[NUM_OF_PATCH_POINTS * patch + k];
+
+            frameNormal = Rotate(frameNormal, mFrameSamples.tangent.At(index), std::cos(roll), std::sin(roll));
+        }
+    }
+}
+
+void BSplineRenderer::SplineGeometry::MarkPatchesChanged(int firstPatch, int lastPatch)
+{
+    if (mChangedPatchFirst > mChangedPatchLast)
+    {
+        mChangedPatchFirst = firstPatch;
+        mChangedPatchLast = lastPatch;
+    }
+    else
+    {
+        mChangedPatchFirst = std::min(mChangedPatchFirst, firstPatch);
+        mChangedPatchLast = std::max(mChangedPatchLast, lastPatch);
+    }
+}
+
+void BSplineRenderer::SplineGeometry::IncrementVersion()
+{
+    ++mVersion;
+    mPatchChanges[mVersion % PATCH_CHANGE_LOG_SIZE] = PatchChange{ mVersion, mChangedPatchFirst, mChangedPatchLast };
+
+    RefitPatchBounds(mChangedPatchFirst, mChangedPatchLast);
+
+    mChangedPatchFirst = 0;
+    mChangedPatchLast = -1;
+}
+
+void BSplineRenderer::SplineGeometry::RefitPatchBounds(int firstPatch, int lastPatch)
+{
+    const int patchCount = GetPatchCount();
+    const bool rebuild = int(mPatchBoxes.size()) != patchCount;
+
+    if (rebuild)
+    {
+        firstPatch = 0;
+        lastPatch = patchCount - 1;
+        mPatchBoxes.resize(patchCount);
+    }
+
+    lastPatch = std::min(lastPatch, patchCount - 1);
+
+    // The convex hull of the control points contains the patch
+    for (int patch = firstPatch; patch <= lastPatch; ++patch)
+    {
+        Bvh::Box& box = mPatchBoxes[patch];
+        box = Bvh::Box();
+
+        for (int i = 0; i < NUM_OF_PATCH_POINTS; ++i)
+        {
+            const QVector3D& point = mBezierControlPoints[NUM_OF_PATCH_POINTS * patch + i];
+            box = Bvh::Merge(box, Bvh::Box{ point, point });
+        }
+    }
+
+    if (rebuild)
+    {
+        mPatchBvh.Build(mPatchBoxes);
+    }
+    else if (firstPatch <= lastPatch)
+    {
+        mPatchBvh.Refit(mPatchBoxes, firstPatch, lastPatch);
+    }
+}
+
+void BSplineRenderer::SplineGeometry::GetChangedPatches(unsigned long long version, int& firstPatch, int& lastPatch) const
+{
+    firstPatch = 0;
+    lastPatch = -1;
+
+    if (version >= mVersion)
+    {
+        return;
+    }
+
+    for (unsigned long long next = version + 1; next <= mVersion; ++next)
+    {
+        const PatchChange& change = mPatchChanges[next % PATCH_CHANGE_LOG_SIZE];
+
+        // Overwritten by a later version
+        if (change.version != next)
+        {
+            firstPatch = 0;
+            lastPatch = GetPatchCount() - 1;
+            return;
+        }
+
+        if (change.firstPatch > change.lastPatch)
+        {
+            continue;
+        }
+
+        if (firstPatch > lastPatch)
+        {
+            firstPatch = change.firstPatch;
+            lastPatch = change.lastPatch;
+        }
+        else
+        {
+            firstPatch = std::min(firstPatch, change.firstPatch);
+            lastPatch = std::max(lastPatch, change.lastPatch);
+        }
+    }
+
+    // Earlier versions may have had more patches
+    lastPatch = std::min(lastPatch, GetPatchCount() - 1);
+}
+
+void BSplineRenderer::SplineGeometry::MakeKnotDirty(KnotPtr knot)
+{
+    const int index = GetKnotIndex(knot);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    if (mDirtyKnotFirst < 0)
+    {
+        mDirtyKnotFirst = index;
+        mDirtyKnotLast = index;
+    }
+    else
+    {
+        mDirtyKnotFirst = std::min(mDirtyKnotFirst, index);
+        mDirtyKnotLast = std::max(mDirtyKnotLast, index);
+    }
+}
+
+void BSplineRenderer::SplineGeometry::FlushLocalUpdates()
+{
+    if (mLocalDisplacement > 0.0f)
+    {
+        MakeDirty();
+    }
+}
+
+int BSplineRenderer::SplineGeometry::GetKnotIndex(KnotPtr knot)
+{
+    // Consecutive drag events move the same knot
+    if (0 <= mKnotIndexHint && mKnotIndexHint < mKnots.size() && mKnots[mKnotIndexHint] == knot)
+    {
+        return mKnotIndexHint;
+    }
+
+    mKnotIndexHint = mKnots.indexOf(knot);
+    return mKnotIndexHint;
+}
+
+QVector3D BSplineRenderer::SplineGeometry::GetSolvedKnotPosition(int index) const
+{
+    // Each patch starts at its knot, the last knot is the end of the last patch
+    if (index < mKnots.size() - 1)
+    {
+        return mBezierControlPoints[NUM_OF_PATCH_POINTS * index];
+    }
+
+    return mBezierControlPoints[NUM_OF_PATCH_POINTS * (index - 1) + 3];
+}
+
+void BSplineRenderer::SplineGeometry::SetLocalUpdateEnabled(bool enabled)
+{
+    mLocalUpdateEnabled = enabled;
+}
+
+bool BSplineRenderer::SplineGeometry::GetLocalUpdateEnabled()
+{
+    return mLocalUpdateEnabled;
+}
+
+void BSplineRenderer::SplineGeometry::SetLocalUpdateTolerance(float tolerance)
+{
+    mLocalUpdateTolerance = tolerance;
+}
+
+float BSplineRenderer::SplineGeometry::GetLocalUpdateTolerance()
+{
+    return mLocalUpdateTolerance;
+}
+
+void BSplineRenderer::SplineGeometry::UpdateSplineControlPoints()
+{
+    SplineSolver::Solve(mKnots, mSplineControlPoints);
+}
+
+QVector3D BSplineRenderer::SplineGeometry::GetPositionAt(int patch, float t) const
+{
+    const QVector3D* p = mBezierControlPoints.constData() + NUM_OF_PATCH_POINTS * patch;
+    const float s = 1.0f - t;
+
+    return (s * s * s) * p[0] + (3.0f * s * s * t) * p[1] + (3.0f * s * t * t) * p[2] + (t * t * t) * p[3];
+}
+
+QVector3D BSplineRenderer::SplineGeometry::GetTangentAt(int patch, float t) const
+{
+    const QVector3D* p = mBezierControlPoints.constData() + NUM_OF_PATCH_POINTS * patch;
+    const float s = 1.0f - t;
+
+    return (3.0f * s * s) * (p[1] - p[0]) + (6.0f * s * t) * (p[2] - p[1]) + (3.0f * t * t) * (p[3] - p[2]);
+}
+
+void BSplineRenderer::SplineGeometry::Sample(int samplesPerPatch, SplineSamples& samples, int outputs) const
+{
+    std::vector<float> t(samplesPerPatch);
+
+    for (int i = 0; i < samplesPerPatch; ++i)
+    {
+        t[i] = samplesPerPatch > 1 ? i / float(samplesPerPatch - 1) : 0.0f;
+    }
+
+    SplineEvaluator::EvaluateUniform(mBezierControlPoints.constData(), GetPatchCount(), t.data(), samplesPerPatch, samples, outputs);
+}
+
+BSplineRenderer::KnotPtr BSplineRenderer::SplineGeometry::GetClosestKnotToRay(const QVector3D& rayOrigin, const QVector3D& rayDirection, float maxDistance) const
+{
+    float minDistance = std::numeric_limits<float>::infinity();
+    KnotPtr closestKnot = nullptr;
+
+    for (auto& knot : mKnots)
+    {
+        QVector3D difference = knot->GetPosition() - rayOrigin;
+
+        float dot = QVector3D::dotProduct(difference, rayDirection);
+
+        if (dot >= 0.0f)
+        {
+            float distance = (difference - rayDirection * dot).length();
+            if (distance < minDistance)
+            {
+                minDistance = distance;
+                closestKnot = knot;
+            }
+        }
+    }
+
+    if (minDistance >= maxDistance)
+    {
+        closestKnot = nullptr;
+    }
+
+    return closestKnot;
+}
+
+void BSplineRenderer::SplineGeometry::RemoveLastKnot()
+{
+    if (!mKnots.isEmpty())
+    {
+        mKnots.removeLast();
+        MakeDirty();
+    }
+}
+
+void BSplineRenderer::SplineGeometry::RemoveKnot(KnotPtr knot)
+{
+    mKnots.removeAll(knot);
+    MakeDirty();
+}
+
+void BSplineRenderer::SplineGeometry::ClearKnots()
+{
+    mKnots.clear();
+    MakeDirty();
+}
+
+float BSplineRenderer::SplineGeometry::GetTotalLength() const
+{
+    float length = 0.0f;
+    for (int i = 1; i < mKnots.size(); ++i)
+    {
+        length += (mKnots[i]->GetPosition() - mKnots[i - 1]->GetPosition()).length();
+    }
+    return length;
+}
+
+QVector3D BSplineRenderer::SplineGeometry::GetCentroid() const
+{
+    if (mKnots.isEmpty())
+        return QVector3D(0, 0, 0);
+
+    QVector3D sum(0, 0, 0);
+    for (const auto& knot : mKnots)
+    {
+        sum += knot->GetPosition();
+    }
+    return sum / mKnots.size();
+}
+
+QPair<QVector3D, QVector3D> BSplineRenderer::SplineGeometry::GetBoundingBox() const
+{
+    if (mKnots.isEmpty())
+        return { QVector3D(0, 0, 0), QVector3D(0, 0, 0) };
+
+    QVector3D minPos = mKnots[0]->GetPosition();
+    QVector3D maxPos = mKnots[0]->GetPosition();
+
+    for (const auto& knot : mKnots)
+    {
+        const QVector3D& pos = knot->GetPosition();
+        minPos.setX(std::min(minPos.x(), pos.x()));
+        minPos.setY(std::min(minPos.y(), pos.y()));
+        minPos.setZ(std::min(minPos.z(), pos.z()));
+        maxPos.setX(std::max(maxPos.x(), pos.x()));
+        maxPos.setY(std::max(maxPos.y(), pos.y()));
+        maxPos.setZ(std::max(maxPos.z(), pos.z()));
+    }
+
+    return { minPos, maxPos };
+}
+
+QPair<QVector3D, QVector3D> BSplineRenderer::SplineGeometry::GetPatchBounds() const
+{
+    if (mPatchBvh.IsEmpty())
+        return { QVector3D(0, 0, 0), QVector3D(0, 0, 0) };
+
+    return { mPatchBvh.GetBounds().min, mPatchBvh.GetBounds().max };
+}
+
+bool BSplineRenderer::SplineGeometry::mLocalUpdateEnabled = true;
+
+float BSplineRenderer::SplineGeometry::mLocalUpdateTolerance = BSplineRenderer::DEFAULT_LOCAL_UPDATE_TOLERANCE;
\ No newline at end of file
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Curve/Knot.h"
+#include "Curve/SplineEvaluator.h"
+#include "Util/Bvh.h"
+#include "Util/Macros.h"
+
+#include <QPair>
+#include <QVector>
+#include <QVector3D>
+#include <array>
+
+namespace BSplineRenderer
+{
+    // The GPU independent part of a spline: knots, control point solve, Bezier conversion,
+    // evaluation, length and bounds. Does not need an OpenGL context.
+    class SplineGeometry
+    {
+      public:
+        SplineGeometry() = default;
+        virtual ~SplineGeometry() = default;
+
+        void AddKnot(KnotPtr knot);
+        KnotPtr AddKnot(float x, float y, float z);
+        KnotPtr AddKnot(const QVector3D& position);
+
+        // Appends count knots at once, e.g. straight from a loaded file
+        void AddKnots(const QVector3D* positions, int count);
+
+        void RemoveLastKnot();
+        void RemoveKnot(KnotPtr knot);
+        void ClearKnots();
+
+        int GetKnotCount() const { return mKnots.size(); }
+        float GetTotalLength() const;
+        QVector3D GetCentroid() const;
+        QPair<QVector3D, QVector3D> GetBoundingBox() const;
+
+        // Bounds of the Bezier control points, which contain the curve, as of the last version
+        QPair<QVector3D, QVector3D> GetPatchBounds() const;
+
+        // Bvh over the bounds of the control points of each patch, refit to the changed patches with every version
+        const Bvh& GetPatchBvh() const { return mPatchBvh; }
+
+        const QVector<KnotPtr>& GetKnots() const { return mKnots; }
+
+        KnotPtr GetClosestKnotToRay(const QVector3D& rayOrigin, const QVector3D& rayDirection, float maxDistance) const;
+
+        // Bezier patches, NUM_OF_PATCH_POINTS control points each
+        const QVector<QVector3D>& GetBezierControlPoints() const { return mBezierControlPoints; }
+        int GetPatchCount() const { return mBezierControlPoints.size() / NUM_OF_PATCH_POINTS; }
+
+        // Rotation minimizing frames, one unit normal per Bezier control point. The normal stored at
+        // control point k of a patch belongs to t = k / 3 and is perpendicular to the tangent there.
+        // Stale while the frames are deferred, see SetFramesDeferred().
+        const QVector<QVector3D>& GetFrameNormals() const { return mFrameNormals; }
+
+        // While deferred, updates leave the frames of the changed patches stale until UpdateStaleFrames(),
+        // e.g. for curves that are not drawn as tubes. Undeferring does not update them by itself.
+        void SetFramesDeferred(bool deferred) { mFramesDeferred = deferred; }
+        bool GetFramesDeferred() const { return mFramesDeferred; }
+        bool HasStaleFrames() const { return mStaleFrameFirst <= mStaleFrameLast; }
+
+        // Transports the stale frames, their patches count as changed and the version is incremented
+        void UpdateStaleFrames();
+
+        // Solved control points of the interpolation, one per knot. Empty for fewer than 4 knots.
+        const QVector<QVector3D>& GetSplineControlPoints() const { return mSplineControlPoints; }
+
+        // Evaluates the patch at t in [0, 1]. The geometry must be up to date.
+        QVector3D GetPositionAt(int patch, float t) const;
+        QVector3D GetTangentAt(int patch, float t) const;
+
+        // Evaluates every patch at samplesPerPatch parameters evenly spaced over [0, 1], see SplineEvaluator.
+        // The geometry must be up to date.
+        void Sample(int samplesPerPatch, SplineSamples& samples, int outputs = SplineEvaluator::POSITION) const;
+
+        void MakeDirty();
+        void UpdateIfDirty();
+        bool IsDirty() const { return mDirty || mDirtyKnotFirst >= 0; }
+
+        // Solves the control points and rebuilds the Bezier patches
+        void Update();
+
+        // Marks a single moved knot. If local updates are enabled, only a window around
+        // the knot is re-solved on the next update.
+        void MakeKnotDirty(KnotPtr knot);
+
+        // Schedules a full solve if local updates were applied since the last one,
+        // discarding the error they accumulated.
+        void FlushLocalUpdates();
+
+        // Incremented whenever the Bezier patches change
+        unsigned long long GetVersion() const { return mVersion; }
+
+        // Patches changed by the versions after the given one, first > last if there is none. Each consumer
+        // passes the version it has last seen; every patch has changed if that version is no longer logged.
+        // Consumers mirroring the patches must copy everything if the patch count has changed.
+        void GetChangedPatches(unsigned long long version, int& firstPatch, int& lastPatch) const;
+
+        // Restores a state saved from GetKnots(), GetSplineControlPoints() and GetFrameNormals() without
+        // solving anything. The arrays must match the current knot count.
+        void SetBakedState(const QVector3D* knots, const QVector3D* controlPoints, const QVector3D* normals);
+
+        // Updates the dirty splines. Splines needing a full solve are grouped by their
+        // knot count and each group is solved as one multi-right-hand-side system.
+        // Large updates are spread over the JobSystem.
+        static void UpdateBatch(const QVector<SplineGeometry*>& splines);
+
+        static void SetLocalUpdateEnabled(bool enabled);
+        static bool GetLocalUpdateEnabled();
+        static void SetLocalUpdateTolerance(float tolerance);
+        static float GetLocalUpdateTolerance();
+
+        static constexpr int NUM_OF_PATCH_POINTS = 4;
+
+        // Below this many dirty knots UpdateBatch runs on the calling thread
+        static constexpr int MIN_PARALLEL_KNOT_COUNT = 1 << 13;
+
+        // Most right hand sides solved by one task of UpdateBatch
+        static constexpr int MAX_SPLINES_PER_SOLVE = 64;
+
+        // Versions whose changed patches are kept for GetChangedPatches()
+        static constexpr int PATCH_CHANGE_LOG_SIZE = 16;
+
+      protected:
+        QVector<KnotPtr> mKnots;
+        QVector<QVector3D> mBezierControlPoints;
+        QVector<QVector3D> mFrameNormals;
+
+      private:
+        void UpdateFully();
+        void BuildBezierControlPoints();
+        bool UpdateLocally();
+        void UpdateSplineControlPoints();
+        void UpdateBezierControlPoints(int firstPatch, int lastPatch);
+        void MarkPatchesChanged(int firstPatch, int lastPatch);
+
+        // Logs the patches marked since the last version under a new version and refits their bounds
+        void IncrementVersion();
+        void RefitPatchBounds(int firstPatch, int lastPatch);
+
+        // Updates the frames of the patches now, or marks them stale if the frames are deferred
+        void ScheduleFrames(int firstPatch, int lastPatch);
+
+        // Transports the frames over the window, in chunks on several threads if it is long. If patches
+        // follow, the window is rolled to end on their frames.
+        void UpdateFrames(int firstPatch, int lastPatch);
+        void TransportFrames(int windowFirst, int firstPatch, int lastPatch);
+        void JoinFrames(int firstPatch, int lastPatch);
+        void RollFrames(int firstPatch, int lastPatch);
+
+        int GetKnotIndex(KnotPtr knot);
+        QVector3D GetSolvedKnotPosition(int index) const;
+
+        QVector<QVector3D> mSplineControlPoints;
+
+        // Scratch buffer of UpdateFrames(), the tangents and the unjoined normals of the window
+        SplineSamples mFrameSamples;
+
+        bool mDirty{ false };
+
+        bool mFramesDeferred{ false };
+        int mStaleFrameFirst{ 0 };
+        int mStaleFrameLast{ -1 };
+
+        // Set by UpdateBatch, the control points are up to date and only the Bezier patches remain
+        bool mControlPointsSolved{ false };
+
+        // Range of knots moved since the last update, -1 if there is none
+        int mDirtyKnotFirst{ -1 };
+        int mDirtyKnotLast{ -1 };
+        int mKnotIndexHint{ -1 };
+
+        // Sum of the knot displacements handled locally since the last full solve
+        float mLocalDisplacement{ 0.0f };
+
+        struct PatchChange
+        {
+            unsigned long long version;
+            int firstPatch;
+            int lastPatch;
+        };
+
+        unsigned long long mVersion{ 0 };
+
+        // Patches marked for the next version, and those of the last versions indexed by the version modulo the log size
+        int mChangedPatchFirst{ 0 };
+        int mChangedPatchLast{ -1 };
+        std::array<PatchChange, PATCH_CHANGE_LOG_SIZE> mPatchChanges{};
+
+        std::vector<Bvh::Box> mPatchBoxes;
+        Bvh mPatchBvh;
+
+        static bool mLocalUpdateEnabled;
+        static float mLocalUpdateTolerance;
+
+        DEFINE_MEMBER(float, Radius, DEFAULT_RADIUS);
+    };
+}
@@ -0,0 +1,148 @@
+#include "SplineSolver.h"
+
+#include <cmath>
+
+void BSplineRenderer::SplineSolver::Solve(const QVector<KnotPtr>& knots, QVector<QVector3D>& controlPoints)
+{
+    const int n = knots.size();
+
+    controlPoints.resize(n);
+    controlPoints[0] = knots[0]->GetPosition();
+    controlPoints[n - 1] = knots[n - 1]->GetPosition();
+
+    SolveRange(knots, controlPoints, 1, n - 2);
+}
+
+void BSplineRenderer::SplineSolver::SolveRange(const QVector<KnotPtr>& knots, QVector<QVector3D>& controlPoints, int first, int last)
+{
+    const int m = last - first + 1; // Number of unknowns
+
+    const auto factorization = GetFactorization(m);
+    const float* c = factorization->data();
+
+    // Forward sweep, the modified right hand side is written in place
+    for (int i = 0; i < m; ++i)
+    {
+        const int row = first + i;
+
+        QVector3D rhs = 6.0f * knots[row]->GetPosition() - controlPoints[row - 1];
+
+        if (i == m - 1)
+        {
+            rhs -= controlPoints[row + 1];
+        }
+
+        controlPoints[row] = rhs * c[i];
+    }
+
+    // Back substitution
+    for (int i = m - 2; i >= 0; --i)
+    {
+        controlPoints[first + i] -= c[i] * controlPoints[first + i + 1];
+    }
+}
+
+void BSplineRenderer::SplineSolver::SolveBatch(const QVector<const QVector<KnotPtr>*>& knots, const QVector<QVector<QVector3D>*>& controlPoints)
+{
+    const int count = knots.size();
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    const int n = knots[0]->size();
+    const int m = n - 2;
+
+    const auto factorization = GetFactorization(m);
+    const float* c = factorization->data();
+
+    for (int j = 0; j < count; ++j)
+    {
+        controlPoints[j]->resize(n);
+        (*controlPoints[j])[0] = (*knots[j])[0]->GetPosition();
+        (*controlPoints[j])[n - 1] = (*knots[j])[n - 1]->GetPosition();
+    }
+
+    // Same sweeps as in SolveRange, interleaved over the right hand sides
+    for (int i = 0; i < m; ++i)
+    {
+        const int row = 1 + i;
+
+        for (int j = 0; j < count; ++j)
+        {
+            QVector3D* x = controlPoints[j]->data();
+            QVector3D rhs = 6.0f * (*knots[j])[row]->GetPosition() - x[row - 1];
+
+            if (i == m - 1)
+            {
+                rhs -= x[row + 1];
+            }
+
+            x[row] = rhs * c[i];
+        }
+    }
+
+    for (int i = m - 2; i >= 0; --i)
+    {
+        for (int j = 0; j < count; ++j)
+        {
+            QVector3D* x = controlPoints[j]->data();
+            x[1 + i] -= c[i] * x[2 + i];
+        }
+    }
+}
+
+int BSplineRenderer::SplineSolver::GetInfluenceRadius(float displacement, float tolerance)
+{
+    // The response of the control points to a displacement d of a knot is about sqrt(3) * d * rho^k at k rows away.
+    const float rho = 2.0f - std::sqrt(3.0f);
+    const float magnitude = std::sqrt(3.0f) * displacement;
+
+    if (magnitude <= tolerance)
+    {
+        return 0;
+    }
+
+    return static_cast<int>(std::ceil(std::log(tolerance / magnitude) / std::log(rho)));
+}
+
+std::shared_ptr<const BSplineRenderer::SplineSolver::Factorization> BSplineRenderer::SplineSolver::GetFactorization(int rows)
+{
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    if (const auto it = mCache.find(rows); it != mCache.end())
+    {
+        ++mCacheHitCount;
+        return it->second;
+    }
+
+    ++mCacheMissCount;
+
+    // Curves rarely come in more than a handful of sizes, start over instead of tracking usage
+    if (mCache.size() >= MAX_CACHED_FACTORIZATIONS)
+    {
+        mCache.clear();
+    }
+
+    // With a unit sub and super diagonal, the modified super diagonal equals the inverse pivot
+    auto factorization = std::make_shared<Factorization>(rows);
+    auto& c = *factorization;
+
+    for (int i = 0; i < rows; ++i)
+    {
+        c[i] = 1.0f / (i == 0 ? 4.0f : 4.0f - c[i - 1]);
+    }
+
+    mCache.emplace(rows, factorization);
+
+    return factorization;
+}
+
+std::mutex BSplineRenderer::SplineSolver::mCacheMutex;
+
+std::unordered_map<int, std::shared_ptr<const BSplineRenderer::SplineSolver::Factorization>> BSplineRenderer::SplineSolver::mCache;
+
+std::atomic_ullong BSplineRenderer::SplineSolver::mCacheHitCount = 0;
+
+std::atomic_ullong BSplineRenderer::SplineSolver::mCacheMissCount = 0;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Curve/Knot.h"
+
+#include <QVector>
+#include <QVector3D>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // Computes the B-spline control points of the cubic spline interpolating a sequence of knots.
+    // The interior control points satisfy the banded [1 4 1] system
+    //
+    //     D(i-1) + 4 D(i) + D(i+1) = 6 P(i),    D(0) = P(0),    D(n-1) = P(n-1)
+    //
+    // which is solved with the Thomas algorithm in O(n) time and memory.
+    class SplineSolver
+    {
+      public:
+        SplineSolver() = delete;
+
+        // Requires at least 3 knots. controlPoints is resized to knots.size().
+        static void Solve(const QVector<KnotPtr>& knots, QVector<QVector3D>& controlPoints);
+
+        // Re-solves the rows [first, last] only (1 <= first <= last <= n - 2), keeping
+        // controlPoints[first - 1] and controlPoints[last + 1] fixed as boundary values.
+        static void SolveRange(const QVector<KnotPtr>& knots, QVector<QVector3D>& controlPoints, int first, int last);
+
+        // Solves several curves having the same number of knots as one multi-right-hand-side system.
+        static void SolveBatch(const QVector<const QVector<KnotPtr>*>& knots, const QVector<QVector<QVector3D>*>& controlPoints);
+
+        // A change of the right hand side at one row fades out by (2 - sqrt(3))^k after k rows.
+        // Returns the number of rows k after which a knot displacement has decayed below the tolerance.
+        static int GetInfluenceRadius(float displacement, float tolerance);
+
+        static unsigned long long GetCacheHitCount() { return mCacheHitCount; }
+        static unsigned long long GetCacheMissCount() { return mCacheMissCount; }
+
+      private:
+        using Factorization = std::vector<float>;
+
+        // Returns the forward sweep coefficients of the system with the given number of rows.
+        // They depend on nothing but the size, so they are computed once and shared by every solve.
+        static std::shared_ptr<const Factorization> GetFactorization(int rows);
+
+        static constexpr int MAX_CACHED_FACTORIZATIONS = 256;
+
+        static std::mutex mCacheMutex;
+        static std::unordered_map<int, std::shared_ptr<const Factorization>> mCache;
+        static std::atomic_ullong mCacheHitCount;
+        static std::atomic_ullong mCacheMissCount;
+    };
+}
@@ -0,0 +1,119 @@
+#include "TubeMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+void BSplineRenderer::TubeMeshBuilder::Build(const SplineGeometry& geometry, int segments, int sectors, TubeMesh& mesh)
+{
+    Allocate(geometry, segments, sectors, mesh);
+    BuildPatches(geometry, 0, geometry.GetPatchCount() - 1, mesh);
+}
+
+void BSplineRenderer::TubeMeshBuilder::Allocate(const SplineGeometry& geometry, int segments, int sectors, TubeMesh& mesh)
+{
+    Allocate(0, geometry.GetPatchCount() - 1, segments, sectors, mesh);
+}
+
+void BSplineRenderer::TubeMeshBuilder::Allocate(int firstPatch, int lastPatch, int segments, int sectors, TubeMesh& mesh)
+{
+    mesh.segments = segments;
+    mesh.sectors = sectors;
+    mesh.firstPatch = firstPatch;
+    mesh.patchCount = std::max(0, lastPatch - firstPatch + 1);
+    mesh.vertices.resize(mesh.patchCount * mesh.GetVertexCountPerPatch());
+    mesh.normals.resize(mesh.patchCount * mesh.GetVertexCountPerPatch());
+    mesh.indices.resize(mesh.patchCount * mesh.GetIndexCountPerPatch());
+}
+
+void BSplineRenderer::TubeMeshBuilder::BuildPatches(const SplineGeometry& geometry, int firstPatch, int lastPatch, TubeMesh& mesh)
+{
+    firstPatch = std::max(firstPatch, mesh.firstPatch);
+    lastPatch = std::min(lastPatch, mesh.firstPatch + mesh.patchCount - 1);
+
+    if (firstPatch > lastPatch)
+    {
+        return;
+    }
+
+    const int segments = mesh.segments;
+    const int sectors = mesh.sectors;
+    const float radius = geometry.GetRadius();
+    const QVector3D* points = geometry.GetBezierControlPoints().constData();
+    const QVector3D* frameNormals = geometry.GetFrameNormals().constData();
+
+    std::vector<float> t(segments + 1);
+    std::vector<float> cosines(sectors + 1);
+    std::vector<float> sines(sectors + 1);
+
+    for (int i = 0; i <= segments; ++i)
+    {
+        t[i] = i / float(segments);
+    }
+
+    for (int j = 0; j <= sectors; ++j)
+    {
+        const float angle = 2.0f * std::numbers::pi_v<float> * j / sectors;
+        cosines[j] = std::cos(angle);
+        sines[j] = std::sin(angle);
+    }
+
+    SplineSamples samples;
+    const int outputs = SplineEvaluator::POSITION | SplineEvaluator::FIRST_DERIVATIVE;
+    SplineEvaluator::EvaluateUniform(points + SplineGeometry::NUM_OF_PATCH_POINTS * firstPatch, lastPatch - firstPatch + 1, t.data(), segments + 1, samples, outputs);
+
+    for (int patch = firstPatch; patch <= lastPatch; ++patch)
+    {
+        const QVector3D* p = points + SplineGeometry::NUM_OF_PATCH_POINTS * patch;
+        const QVector3D* n = frameNormals + SplineGeometry::NUM_OF_PATCH_POINTS * patch;
+        const int vertexBase = (patch - mesh.firstPatch) * mesh.GetVertexCountPerPatch();
+
+        for (int i = 0; i <= segments; ++i)
+        {
+            const int sample = (patch - firstPatch) * (segments + 1) + i;
+            const QVector3D position = samples.position.At(sample);
+            QVector3D tangent = samples.firstDerivative.At(sample);
+
+            // Same fallback and frame interpolation as Spline.tes
+            tangent = tangent.lengthSquared() > 1e-12f ? tangent.normalized() : (p[3] - p[0] + QVector3D(1e-6f, 0.0f, 0.0f)).normalized();
+
+            const float u = t[i];
+            const float l0 = -4.5f * (u - 1.0f / 3.0f) * (u - 2.0f / 3.0f) * (u - 1.0f);
+            const float l1 = 13.5f * u * (u - 2.0f / 3.0f) * (u - 1.0f);
+            const float l2 = -13.5f * u * (u - 1.0f / 3.0f) * (u - 1.0f);
+            const float l3 = 4.5f * u * (u - 1.0f / 3.0f) * (u - 2.0f / 3.0f);
+
+            QVector3D frameNormal = l0 * n[0] + l1 * n[1] + l2 * n[2] + l3 * n[3];
+            frameNormal = (frameNormal - QVector3D::dotProduct(frameNormal, tangent) * tangent).normalized();
+            const QVector3D frameBinormal = QVector3D::crossProduct(tangent, frameNormal);
+
+            for (int j = 0; j <= sectors; ++j)
+            {
+                const QVector3D normal = cosines[j] * frameNormal + sines[j] * frameBinormal;
+                const int vertex = vertexBase + i * (sectors + 1) + j;
+                mesh.vertices[vertex] = position + radius * normal;
+                mesh.normals[vertex] = normal;
+            }
+        }
+
+        unsigned int* index = mesh.indices.data() + (patch - mesh.firstPatch) * mesh.GetIndexCountPerPatch();
+
+        for (int i = 0; i < segments; ++i)
+        {
+            for (int j = 0; j < sectors; ++j)
+            {
+                const unsigned int v0 = vertexBase + i * (sectors + 1) + j;
+                const unsigned int v1 = v0 + sectors + 1;
+
+                // Counter-clockwise seen from outside
+                *index++ = v0;
+                *index++ = v0 + 1;
+                *index++ = v1;
+                *index++ = v0 + 1;
+                *index++ = v1 + 1;
+                *index++ = v1;
+            }
+        }
+    }
+}
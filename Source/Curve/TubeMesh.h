@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Curve/SplineGeometry.h"
+
+#include <QVector>
+#include <QVector3D>
+
+namespace BSplineRenderer
+{
+    // Indexed triangle mesh of the tube around a spline, or around a range of its patches. Every patch
+    // has (segments + 1) rings of (sectors + 1) vertices, the seam and the patch boundaries are duplicated.
+    struct TubeMesh
+    {
+        QVector<QVector3D> vertices;
+        QVector<QVector3D> normals;
+
+        // Relative to the first vertex of the mesh
+        QVector<unsigned int> indices;
+
+        int segments{ 0 };
+        int sectors{ 0 };
+
+        // Patches stored in the mesh
+        int firstPatch{ 0 };
+        int patchCount{ 0 };
+
+        int GetVertexCountPerPatch() const { return (segments + 1) * (sectors + 1); }
+        int GetIndexCountPerPatch() const { return 6 * segments * sectors; }
+    };
+
+    // Generates the same surface as the tessellation shaders on the CPU
+    class TubeMeshBuilder
+    {
+      public:
+        TubeMeshBuilder() = delete;
+
+        static void Build(const SplineGeometry& geometry, int segments, int sectors, TubeMesh& mesh);
+
+        // Build() in two steps so that the patches can be filled on several threads:
+        // Allocate() sizes the arrays for every patch or for the patches [firstPatch, lastPatch] only,
+        // BuildPatches() fills the allocated patches within [firstPatch, lastPatch].
+        static void Allocate(const SplineGeometry& geometry, int segments, int sectors, TubeMesh& mesh);
+        static void Allocate(int firstPatch, int lastPatch, int segments, int sectors, TubeMesh& mesh);
+        static void BuildPatches(const SplineGeometry& geometry, int firstPatch, int lastPatch, TubeMesh& mesh);
+    };
+}
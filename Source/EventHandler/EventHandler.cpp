@@ -1,9 +1,16 @@
 #include "EventHandler.h"
 
 #include "Core/CurveContainer.h"
+#include "Curve/CurveBvh.h"
 #include "Renderer/RendererManager.h"
 #include "Util/Logger.h"
 
+namespace
+{
+    // Knots are picked within this many tube radii of the mouse ray
+    constexpr float KNOT_PICK_RADIUS_SCALE = 3.0f;
+}
+
 BSplineRenderer::EventHandler::EventHandler(QObject* parent)
     : QObject(parent)
 {
@@ -50,10 +57,8 @@ void BSplineRenderer::EventHandler::OnMousePressed(QMouseEvent* event)
 
         if (mSelectedCurve)
         {
-            float x = mSelectedCurve->GetKnots().last()->GetPosition().x();
-            float y = mSelectedCurve->GetKnots().last()->GetPosition().y();
-            float z = mSelectedCurve->GetKnots().last()->GetPosition().z();
-            Eigen::Vector3f lastKnotPosition = Eigen::Vector3f(x, y, z);
+            const QVector3D lastKnot = mSelectedCurve->MapToWorld(mSelectedCurve->GetKnots().last()->GetPosition());
+            Eigen::Vector3f lastKnotPosition = Eigen::Vector3f(lastKnot.x(), lastKnot.y(), lastKnot.z());
 
             Eigen::Hyperplane<float, 3> plane = Eigen::Hyperplane<float, 3>(normal, -normal.dot(lastKnotPosition));
             const float t = ray.intersection(plane);
@@ -61,7 +66,7 @@ void BSplineRenderer::EventHandler::OnMousePressed(QMouseEvent* event)
 
             if (std::isnan(t) == false && std::isinf(t) == false && t > 0)
             {
-                const auto knot = mSelectedCurve->AddKnot(intersection.x(), intersection.y(), intersection.z());
+                const auto knot = mSelectedCurve->AddKnot(mSelectedCurve->MapToModel(QVector3D(intersection.x(), intersection.y(), intersection.z())));
                 SetSelectedKnot(knot);
             }
             else
@@ -95,6 +100,12 @@ void BSplineRenderer::EventHandler::OnMouseReleased(QMouseEvent* event)
 {
     mCamera->MouseReleased(event);
 
+    // The drag is over, replace the local solves done while dragging with an exact one
+    if (mMouse.button == Qt::LeftButton && mSelectedCurve)
+    {
+        mSelectedCurve->FlushLocalUpdates();
+    }
+
     mMouse.button = Qt::NoButton;
 }
 
@@ -115,24 +126,21 @@ void BSplineRenderer::EventHandler::OnMouseMoved(QMouseEvent* event)
 
             if (std::isnan(t) == false && std::isinf(t) == false)
             {
-                mSelectedKnot->SetPosition(intersection.x(), intersection.y(), intersection.z());
-
                 if (mSelectedCurve)
                 {
-                    mSelectedCurve->MakeDirty();
+                    mSelectedKnot->SetPosition(mSelectedCurve->MapToModel(QVector3D(intersection.x(), intersection.y(), intersection.z())));
+                    mSelectedCurve->MakeKnotDirty(mSelectedKnot);
                 }
             }
         }
     }
     else if (mMouse.button == Qt::NoButton)
     {
-        if (mSelectedCurve)
-        {
-            QVector3D direction = mCamera->GetDirectionFromScreenCoodinates(mMouse.x, mMouse.y);
-            QVector3D origin = mCamera->GetPosition();
-            KnotPtr knot = mSelectedCurve->GetClosestKnotToRay(origin, direction, 3.0f * mSelectedCurve->GetRadius());
-            SetKnotAround(knot);
-        }
+        mHoverMoved = true;
+
+        // The knots of all curves, not only of the selected one
+        const KnotHit hit = GetClosestKnot(mMouse.x, mMouse.y);
+        SetKnotAround(hit.knot, hit.curve);
     }
 }
 
@@ -140,6 +148,23 @@ void BSplineRenderer::EventHandler::OnWheelMoved(QWheelEvent* event)
 {
 }
 
+void BSplineRenderer::EventHandler::Update()
+{
+    if (mHoverQuery.valid() && mHoverQuery.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        // The index is the curve's position in the container when the query was issued
+        const CurveQueryInfo info = mHoverQuery.get();
+        const auto& curves = mCurveContainer->GetCurves();
+        SetHoveredCurve(info.result == 1 && info.index < curves.size() ? curves[info.index] : nullptr);
+    }
+
+    if (mHoverMoved && mHoverQuery.valid() == false)
+    {
+        mHoverQuery = mRendererManager->Query(QPoint(mMouse.x, mMouse.y));
+        mHoverMoved = false;
+    }
+}
+
 Eigen::Vector3f BSplineRenderer::EventHandler::GetViewDirection() const
 {
     const auto& direction = mCamera->GetViewDirection();
@@ -155,13 +180,22 @@ void BSplineRenderer::EventHandler::SetSelectedKnot(KnotPtr knot)
     emit SelectedKnotChanged(mSelectedKnot);
 }
 
-void BSplineRenderer::EventHandler::SetKnotAround(KnotPtr knot)
+void BSplineRenderer::EventHandler::SetKnotAround(KnotPtr knot, SplinePtr curve)
 {
     if (mKnotAround == knot)
         return;
 
     mKnotAround = knot;
-    emit KnotAroundChanged(mKnotAround);
+    emit KnotAroundChanged(mKnotAround, curve);
+}
+
+void BSplineRenderer::EventHandler::SetHoveredCurve(SplinePtr spline)
+{
+    if (mHoveredCurve == spline)
+        return;
+
+    mHoveredCurve = spline;
+    emit HoveredCurveChanged(mHoveredCurve);
 }
 
 void BSplineRenderer::EventHandler::SetSelectedCurve(SplinePtr spline)
@@ -176,26 +210,41 @@ void BSplineRenderer::EventHandler::SetSelectedCurve(SplinePtr spline)
 
 void BSplineRenderer::EventHandler::TrySelectKnot(float x, float y)
 {
-    KnotPtr selectedKnot = nullptr;
+    const KnotHit hit = GetClosestKnot(x, y);
 
-    if (mSelectedCurve)
+    // A knot of another curve selects its curve as well
+    if (hit.knot)
     {
-        QVector3D direction = mCamera->GetDirectionFromScreenCoodinates(x, y);
-        QVector3D origin = mCamera->GetPosition();
-        selectedKnot = mSelectedCurve->GetClosestKnotToRay(origin, direction, 3.0f * mSelectedCurve->GetRadius());
+        SetSelectedCurve(hit.curve);
     }
 
-    SetSelectedKnot(selectedKnot);
+    SetSelectedKnot(hit.knot);
     UpdateKnotTranslationPlane();
 }
 
+BSplineRenderer::KnotHit BSplineRenderer::EventHandler::GetClosestKnot(float x, float y) const
+{
+    // In world space, the pick distance follows the tube radius which is not affected by the model matrix
+    KnotHit hit;
+    mKnotOctree->IntersectRay(mCamera->GetPosition(), mCamera->GetDirectionFromScreenCoodinates(x, y).normalized(), KNOT_PICK_RADIUS_SCALE, hit);
+
+    // The curve may have been removed since the last frame
+    if (hit.knot && mCurveContainer->GetCurves().contains(hit.curve) == false)
+    {
+        return KnotHit();
+    }
+
+    return hit;
+}
+
 void BSplineRenderer::EventHandler::TrySelectCurve(float x, float y)
 {
-    CurveQueryInfo info = mRendererManager->Query(QPoint(x, y));
+    // Ray cast on the CPU instead of reading back the ID pass, the curve may have been removed since the last frame
+    CurveHit hit;
 
-    if (info.result == 1)
+    if (mCurveBvh->Intersect(mCamera->GetPosition(), mCamera->GetDirectionFromScreenCoodinates(x, y), hit) && mCurveContainer->GetCurves().contains(hit.curve))
     {
-        SetSelectedCurve(mCurveContainer->GetCurve(info.index));
+        SetSelectedCurve(hit.curve);
     }
     else
     {
@@ -207,10 +256,8 @@ void BSplineRenderer::EventHandler::UpdateKnotTranslationPlane()
 {
     if (mSelectedKnot)
     {
-        const float x = mSelectedKnot->GetPosition().x();
-        const float y = mSelectedKnot->GetPosition().y();
-        const float z = mSelectedKnot->GetPosition().z();
-        Eigen::Vector3f knotPosition = Eigen::Vector3f(x, y, z);
+        const QVector3D position = mSelectedCurve ? mSelectedCurve->MapToWorld(mSelectedKnot->GetPosition()) : mSelectedKnot->GetPosition();
+        Eigen::Vector3f knotPosition = Eigen::Vector3f(position.x(), position.y(), position.z());
         Eigen::Vector3f normal = GetCameraViewDirection<Eigen::Vector3f>();
         mKnotTranslationPlane = Eigen::Hyperplane<float, 3>(normal, -normal.dot(knotPosition));
     }
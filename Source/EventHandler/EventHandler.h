@@ -1,15 +1,20 @@
 #pragma once
 
+#include "Curve/KnotOctree.h"
 #include "Curve/Spline.h"
 #include "Node/Camera/FreeCamera.h"
+#include "Renderer/Base/CurveSelectionFramebuffer.h"
 #include "Structs/Mouse.h"
 
 #include <Dense>
 #include <QInputEvent>
 #include <QObject>
+#include <future>
 
 namespace BSplineRenderer
 {
+    class CurveBvh;
+    class KnotOctree;
     class CurveContainer;
     class RendererManager;
 
@@ -26,25 +31,33 @@ namespace BSplineRenderer
         void OnMouseMoved(QMouseEvent*);
         void OnWheelMoved(QWheelEvent*);
 
+        // Picks up the hover query of an earlier frame and issues the next one, once per frame on the context thread
+        void Update();
+
         void SetCamera(FreeCameraPtr camera) { mCamera = camera; }
         void SetCurveContainer(CurveContainer* curveContainer) { mCurveContainer = curveContainer; }
         void SetRendererManager(RendererManager* manager) { mRendererManager = manager; }
+        void SetCurveBvh(const CurveBvh* curveBvh) { mCurveBvh = curveBvh; }
+        void SetKnotOctree(const KnotOctree* knotOctree) { mKnotOctree = knotOctree; }
 
         Eigen::Vector3f GetViewDirection() const;
 
         void SetSelectedCurve(SplinePtr spline);
         void SetSelectedKnot(KnotPtr knot);
-        void SetKnotAround(KnotPtr knot);
+        void SetKnotAround(KnotPtr knot, SplinePtr curve);
+        void SetHoveredCurve(SplinePtr spline);
 
         void SetDevicePixelRatio(float devicePixelRatio) { mDevicePixelRatio = devicePixelRatio; }
 
       signals:
         void SelectedKnotChanged(KnotPtr knot);
         void SelectedCurveChanged(SplinePtr curve);
-        void KnotAroundChanged(KnotPtr knot);
+        void KnotAroundChanged(KnotPtr knot, SplinePtr curve);
+        void HoveredCurveChanged(SplinePtr curve);
 
       private:
         void TrySelectKnot(float x, float y);
+        KnotHit GetClosestKnot(float x, float y) const;
         void TrySelectCurve(float x, float y);
         void UpdateKnotTranslationPlane();
         Eigen::ParametrizedLine<float, 3> GetRayFromScreenCoordinates(float x, float y);
@@ -54,9 +67,16 @@ namespace BSplineRenderer
         SplinePtr mSelectedCurve{ nullptr };
         KnotPtr mSelectedKnot{ nullptr };
         KnotPtr mKnotAround{ nullptr };
+        SplinePtr mHoveredCurve{ nullptr };
+
+        // At most one hover query in flight, issued for the latest mouse position
+        std::future<CurveQueryInfo> mHoverQuery;
+        bool mHoverMoved{ false };
 
         CurveContainer* mCurveContainer;
         RendererManager* mRendererManager;
+        const CurveBvh* mCurveBvh;
+        const KnotOctree* mKnotOctree;
 
         float mDevicePixelRatio{ 1.0f };
 
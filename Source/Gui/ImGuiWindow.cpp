@@ -1,14 +1,21 @@
 #include "ImGuiWindow.h"
 
 #include "Core/AnimationManager.h"
-#include "Core/CurveSerializer.h"
+#include "Core/AsyncSerializer.h"
+#include "Core/FrameScheduler.h"
 #include "Core/PresetShapes.h"
 #include "Core/UndoRedoManager.h"
+#include "Curve/MeshExporter.h"
+#include "Curve/SplineSolver.h"
 #include "Renderer/RendererManager.h"
+#include "Util/JobSystem.h"
 #include "Util/Logger.h"
 
 #include <QFileDialog>
+#include <QThread>
 #include <QtImGui.h>
+#include <algorithm>
+#include <cmath>
 #include <imgui.h>
 
 BSplineRenderer::ImGuiWindow::ImGuiWindow(QObject* parent)
@@ -30,19 +37,21 @@ void BSplineRenderer::ImGuiWindow::Draw()
     {
         if (ImGui::BeginMenu("File"))
         {
-            if (ImGui::MenuItem("Save Curves", "Ctrl+S"))
+            const bool busy = mAsyncSerializer->IsBusy();
+            if (ImGui::MenuItem("Save Curves", "Ctrl+S", false, !busy))
             {
                 if (mCurveContainer)
                 {
-                    CurveSerializer::SaveToFile(QString(mFilePath), mCurveContainer);
+                    mAsyncSerializer->Save(QString(mFilePath), mCurveContainer);
                 }
             }
-            if (ImGui::MenuItem("Load Curves", "Ctrl+O"))
+            if (ImGui::MenuItem("Load Curves", "Ctrl+O", false, !busy))
             {
-                if (mCurveContainer)
-                {
-                    CurveSerializer::LoadFromFile(QString(mFilePath), mCurveContainer);
-                }
+                mAsyncSerializer->Load(QString(mFilePath));
+            }
+            if (ImGui::MenuItem("Export Mesh"))
+            {
+                ExportMesh();
             }
             ImGui::EndMenu();
         }
@@ -65,6 +74,11 @@ void BSplineRenderer::ImGuiWindow::Draw()
             ImGui::MenuItem("Help", "F1", &mShowHelp);
             ImGui::EndMenu();
         }
+        if (mAsyncSerializer->IsBusy())
+        {
+            // Visible while the File Operations panel is collapsed
+            ImGui::ProgressBar(mAsyncSerializer->GetProgress(), ImVec2(120, 0));
+        }
         ImGui::EndMenuBar();
     }
 
@@ -106,6 +120,32 @@ void BSplineRenderer::ImGuiWindow::DrawRenderSettings()
 
         ImGui::Checkbox("Wireframe", mRendererManager->GetWireframe());
 
+        bool cpuTubeMesh = mRendererManager->GetCpuTubeMesh();
+        if (ImGui::Checkbox("CPU Tube Mesh", &cpuTubeMesh))
+        {
+            mRendererManager->SetCpuTubeMesh(cpuTubeMesh);
+        }
+
+        bool impostors = mRendererManager->GetImpostors();
+        if (ImGui::Checkbox("Impostors", &impostors))
+        {
+            mRendererManager->SetImpostors(impostors);
+        }
+
+        bool localUpdate = Spline::GetLocalUpdateEnabled();
+        if (ImGui::Checkbox("Local Re-solve", &localUpdate))
+        {
+            Spline::SetLocalUpdateEnabled(localUpdate);
+        }
+
+        ImGui::BeginDisabled(!localUpdate);
+        float tolerance = Spline::GetLocalUpdateTolerance();
+        if (ImGui::SliderFloat("Tolerance", &tolerance, 1e-6f, 1e-2f, "%.1e", ImGuiSliderFlags_Logarithmic))
+        {
+            Spline::SetLocalUpdateTolerance(tolerance);
+        }
+        ImGui::EndDisabled();
+
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
     }
 }
@@ -278,7 +318,7 @@ void BSplineRenderer::ImGuiWindow::DrawAnimationPanel()
             }
         }
 
-        const char* animTypes[] = { "None", "Rotate", "Pulse", "Wave", "Bounce", "Spiral" };
+        const char* animTypes[] = { "None", "Rotate", "Pulse", "Wave", "Bounce", "Spiral", "Keyframes", "Rope" };
         if (ImGui::Combo("Animation Type", &mSelectedAnimationType, animTypes, IM_ARRAYSIZE(animTypes)))
         {
             animManager.SetAnimationType(static_cast<AnimationType>(mSelectedAnimationType));
@@ -302,28 +342,183 @@ void BSplineRenderer::ImGuiWindow::DrawAnimationPanel()
         {
             animManager.Reset();
         }
+
+        if (animManager.GetAnimationType() == AnimationType::Keyframes)
+        {
+            DrawTimelinePanel();
+        }
+
+        if (animManager.GetAnimationType() == AnimationType::Rope)
+        {
+            DrawRopePanel();
+        }
     }
 }
 
-void BSplineRenderer::ImGuiWindow::DrawStatisticsPanel()
+void BSplineRenderer::ImGuiWindow::DrawRopePanel()
 {
-    ImGui::Begin("Statistics", &mShowStatistics);
+    auto& animManager = AnimationManager::Instance();
+    RopeParameters& parameters = animManager.GetRopeParameters();
 
-    if (mCurveContainer)
+    ImGui::Separator();
+    ImGui::Text("Rope");
+
+    ImGui::DragFloat3("Gravity", &parameters.gravity[0], 0.1f, -50.0f, 50.0f);
+    ImGui::SliderFloat("Stretch Stiffness", &parameters.stretchStiffness, 0.0f, 1.0f);
+    ImGui::SliderFloat("Bend Stiffness", &parameters.bendStiffness, 0.0f, 1.0f);
+    ImGui::SliderFloat("Damping", &parameters.damping, 0.0f, 0.2f);
+    ImGui::SliderInt("Iterations", &parameters.iterations, 1, 32);
+
+    int stepRate = int(std::round(1.0f / parameters.timeStep));
+    if (ImGui::SliderInt("Step Rate", &stepRate, 30, 480, "%d Hz"))
+    {
+        parameters.timeStep = 1.0f / stepRate;
+    }
+
+    bool pinEnds = animManager.GetPinEnds();
+    if (ImGui::Checkbox("Pin Ends", &pinEnds))
+    {
+        animManager.SetPinEnds(pinEnds);
+    }
+
+    // Pinned knots follow the mouse while dragged and hold the rope in place
+    ImGui::BeginDisabled(mSelectedKnot == nullptr);
+    const bool pinned = mSelectedKnot && animManager.IsKnotPinned(mSelectedKnot);
+    if (ImGui::Button(pinned ? "Unpin Knot" : "Pin Knot"))
+    {
+        animManager.SetKnotPinned(mSelectedKnot, !pinned);
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    if (ImGui::Button("Restart") && mCurveContainer)
+    {
+        animManager.Reset();
+        animManager.SaveOriginalPositions(mCurveContainer);
+    }
+}
+
+void BSplineRenderer::ImGuiWindow::DrawTimelinePanel()
+{
+    auto& animManager = AnimationManager::Instance();
+    Timeline& timeline = animManager.GetTimeline();
+
+    ImGui::Separator();
+    ImGui::Text("Timeline");
+
+    if (ImGui::Button(animManager.IsPaused() ? "Play" : "Pause"))
+    {
+        animManager.SetPaused(!animManager.IsPaused());
+    }
+
+    ImGui::SameLine();
+
+    float time = animManager.GetTime();
+    if (ImGui::SliderFloat("Time", &time, 0.0f, timeline.GetDuration(), "%.2f s"))
+    {
+        animManager.SetTime(time);
+    }
+
+    float duration = timeline.GetDuration();
+    if (ImGui::InputFloat("Duration", &duration, 1.0f, 5.0f, "%.2f s"))
+    {
+        timeline.SetDuration(duration);
+    }
+
+    float frameRate = timeline.GetFrameRate();
+    if (ImGui::InputFloat("Frame Rate", &frameRate, 1.0f, 10.0f, "%.0f"))
+    {
+        timeline.SetFrameRate(frameRate);
+    }
+
+    int interpolation = static_cast<int>(timeline.GetInterpolation());
+    const char* interpolations[] = { "Linear", "Smooth" };
+    if (ImGui::Combo("Interpolation", &interpolation, interpolations, IM_ARRAYSIZE(interpolations)))
+    {
+        timeline.SetInterpolation(static_cast<Interpolation>(interpolation));
+    }
+
+    // Keys are set at the current time, pause and scrub to place them
+    if (mSelectedCurve)
+    {
+        ImGui::BeginDisabled(mSelectedKnot == nullptr);
+        if (ImGui::Button("Key Knot"))
+        {
+            animManager.SetKnotKey(mSelectedCurve, mSelectedKnot);
+        }
+        ImGui::EndDisabled();
+
+        ImGui::SameLine();
+        if (ImGui::Button("Remove Keys"))
+        {
+            animManager.RemoveKeys(mSelectedCurve);
+        }
+
+        ImGui::DragFloat3("Translation", mKeyTranslation, 0.05f);
+        ImGui::SameLine();
+        if (ImGui::Button("Key Curve"))
+        {
+            animManager.SetCurveKey(mSelectedCurve, QVector3D(mKeyTranslation[0], mKeyTranslation[1], mKeyTranslation[2]));
+        }
+
+        const QVector<float> keyTimes = timeline.GetKeyTimes(mSelectedCurve);
+
+        if (keyTimes.isEmpty() == false)
+        {
+            QString times;
+
+            for (const float keyTime : keyTimes)
+            {
+                times += QString::number(keyTime, 'f', 2) + " ";
+            }
+
+            ImGui::TextWrapped("Keys: %s", times.toUtf8().constData());
+        }
+    }
+    else
     {
-        int totalCurves = mCurveContainer->GetCurves().size();
-        int totalKnots = 0;
-        float totalLength = 0.0f;
+        ImGui::TextDisabled("Select a curve to set keys");
+    }
 
-        for (const auto& curve : mCurveContainer->GetCurves())
+    ImGui::InputText("Cache Path", mBakePath, sizeof(mBakePath));
+
+    if (animManager.IsBaking())
+    {
+        const QString label = QString("Baking %1%").arg(int(100 * animManager.GetBakeProgress()));
+        ImGui::ProgressBar(animManager.GetBakeProgress(), ImVec2(-FLT_MIN, 0), label.toUtf8().constData());
+
+        if (ImGui::Button("Cancel Bake"))
+        {
+            animManager.CancelBake();
+        }
+    }
+    else
+    {
+        if (ImGui::Button("Bake"))
         {
-            totalKnots += curve->GetKnotCount();
-            totalLength += curve->GetTotalLength();
+            animManager.StartBake(QString(mBakePath));
         }
 
-        ImGui::Text("Total Curves: %d", totalCurves);
-        ImGui::Text("Total Knots: %d", totalKnots);
-        ImGui::Text("Total Length: %.2f units", totalLength);
+        ImGui::SameLine();
+        ImGui::TextDisabled(animManager.IsCacheValid() ? "Playing from cache" : "Not baked, solving live");
+    }
+}
+
+void BSplineRenderer::ImGuiWindow::DrawStatisticsPanel()
+{
+    ImGui::Begin("Statistics", &mShowStatistics);
+
+    if (mCurveContainer)
+    {
+        // Gathered on all cores by the frame scheduler
+        const FrameStatistics& statistics = mFrameScheduler->GetStatistics();
+
+        ImGui::Text("Total Curves: %d", statistics.curveCount);
+        ImGui::Text("Visible Curves: %d", mRendererManager->GetVisibleCurveCount());
+        ImGui::Text("Impostor Curves: %d", mRendererManager->GetImpostorCurveCount());
+        ImGui::Text("Total Knots: %d", statistics.knotCount);
+        ImGui::Text("Total Patches: %d", statistics.patchCount);
+        ImGui::Text("Total Length: %.2f units", statistics.totalLength);
 
         ImGui::Separator();
 
@@ -343,6 +538,42 @@ void BSplineRenderer::ImGuiWindow::DrawStatisticsPanel()
         }
     }
 
+    ImGui::Separator();
+    const unsigned long long cacheHits = SplineSolver::GetCacheHitCount();
+    const unsigned long long cacheMisses = SplineSolver::GetCacheMissCount();
+    const unsigned long long cacheLookups = cacheHits + cacheMisses;
+    ImGui::Text("Solver Cache: %llu hits, %llu misses", cacheHits, cacheMisses);
+    ImGui::Text("Solver Cache Hit Rate: %.1f%%", cacheLookups > 0 ? 100.0 * cacheHits / cacheLookups : 0.0);
+
+    if (mRendererManager->GetCpuTubeMesh())
+    {
+        ImGui::Text("Tube Meshes Rebuilt: %d", mRendererManager->GetTubeMeshRebuildCount());
+    }
+
+    ImGui::Text("Picking BVH Refits: %d", mFrameScheduler->GetCurveBvh().GetRefitCount());
+    ImGui::Text("Knot Octree Moves: %d", mFrameScheduler->GetKnotOctree().GetMoveCount());
+    ImGui::Text("Uploaded: %.1f KB / frame", mRendererManager->GetUploadedBytes() / 1024.0);
+    ImGui::Text("Upload Stall: %.3f ms", mRendererManager->GetUploadStallTime());
+    ImGui::Text("Readback Latency: %.3f ms", mRendererManager->GetReadbackLatency());
+    ImGui::Text("Readback Stall: %.3f ms", mRendererManager->GetReadbackStallTime());
+
+    ImGui::Separator();
+    auto& jobSystem = JobSystem::Instance();
+    int threadCount = jobSystem.GetThreadCount();
+    if (ImGui::SliderInt("Threads", &threadCount, 1, std::max(1, QThread::idealThreadCount())))
+    {
+        // Between frames, no job is running
+        jobSystem.SetThreadCount(threadCount);
+    }
+
+    const TaskGraph& taskGraph = mFrameScheduler->GetTaskGraph();
+    ImGui::Text("Frame Tasks: %.3f ms", taskGraph.GetRunTime());
+
+    for (int task = 0; task < taskGraph.GetTaskCount(); ++task)
+    {
+        ImGui::Text("  %s: %.3f ms", taskGraph.GetTaskName(task).c_str(), taskGraph.GetTaskTime(task));
+    }
+
     ImGui::Separator();
     auto& undoManager = UndoRedoManager::Instance();
     ImGui::Text("Undo Stack: %d", undoManager.UndoCount());
@@ -357,26 +588,41 @@ void BSplineRenderer::ImGuiWindow::DrawFileOperationsPanel()
     {
         ImGui::InputText("File Path", mFilePath, sizeof(mFilePath));
 
-        if (ImGui::Button("Save Curves"))
+        if (mAsyncSerializer->IsBusy())
         {
-            if (mCurveContainer)
+            const bool saving = mAsyncSerializer->GetOperation() == AsyncSerializer::Operation::Save;
+            const QString label = QString("%1 %2%").arg(saving ? "Saving" : "Loading").arg(int(100 * mAsyncSerializer->GetProgress()));
+            ImGui::ProgressBar(mAsyncSerializer->GetProgress(), ImVec2(-FLT_MIN, 0), label.toUtf8().constData());
+
+            ImGui::BeginDisabled(mAsyncSerializer->IsCancelled());
+            if (ImGui::Button("Cancel"))
             {
-                if (CurveSerializer::SaveToFile(QString(mFilePath), mCurveContainer))
-                {
-                    LOG_INFO("Curves saved to: {}", mFilePath);
-                }
+                mAsyncSerializer->Cancel();
             }
+            ImGui::EndDisabled();
         }
-        ImGui::SameLine();
-        if (ImGui::Button("Load Curves"))
+        else
         {
-            if (mCurveContainer)
+            if (ImGui::Button("Save Curves"))
             {
-                if (CurveSerializer::LoadFromFile(QString(mFilePath), mCurveContainer))
+                if (mCurveContainer)
                 {
-                    LOG_INFO("Curves loaded from: {}", mFilePath);
+                    mAsyncSerializer->Save(QString(mFilePath), mCurveContainer);
                 }
             }
+            ImGui::SameLine();
+            if (ImGui::Button("Load Curves"))
+            {
+                mAsyncSerializer->Load(QString(mFilePath));
+            }
+        }
+
+        ImGui::Separator();
+        ImGui::InputText("Mesh Path", mExportPath, sizeof(mExportPath));
+
+        if (ImGui::Button("Export Mesh"))
+        {
+            ExportMesh();
         }
 
         ImGui::Separator();
@@ -393,6 +639,25 @@ void BSplineRenderer::ImGuiWindow::DrawFileOperationsPanel()
     }
 }
 
+void BSplineRenderer::ImGuiWindow::ExportMesh()
+{
+    if (mCurveContainer == nullptr)
+    {
+        return;
+    }
+
+    mCurveContainer->UpdateDirtyCurves();
+
+    if (MeshExporter::Export(QString(mExportPath), mCurveContainer->GetGeometries(), mNumberOfSegments, mNumberOfSectors))
+    {
+        LOG_INFO("Mesh exported to: {}", mExportPath);
+    }
+    else
+    {
+        LOG_WARN("Mesh could not be exported to: {}", mExportPath);
+    }
+}
+
 void BSplineRenderer::ImGuiWindow::DrawThemePanel()
 {
     if (ImGui::CollapsingHeader("Theme"))
@@ -494,7 +759,8 @@ void BSplineRenderer::ImGuiWindow::DrawHelpPanel()
     ImGui::Text("Features:");
     ImGui::BulletText("Preset Shapes: Create ready-made curves");
     ImGui::BulletText("Animation: Animate your curves");
-    ImGui::BulletText("Save/Load: Export/import curves as JSON");
+    ImGui::BulletText("Save/Load: Export/import curves as JSON, or binary with the .bscene extension");
+    ImGui::BulletText("Export Mesh: Write the tubes as OBJ, PLY, STL or GLB");
     ImGui::BulletText("Statistics: View curve information");
     ImGui::BulletText("Themes: Change UI appearance");
 
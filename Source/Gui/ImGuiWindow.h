@@ -12,6 +12,8 @@
 namespace BSplineRenderer
 {
     class RendererManager;
+    class AsyncSerializer;
+    class FrameScheduler;
 
     enum class ThemeStyle
     {
@@ -31,6 +33,8 @@ namespace BSplineRenderer
 
         void SetRendererManager(RendererManager* manager);
         void SetCurveContainer(CurveContainer* container) { mCurveContainer = container; }
+        void SetAsyncSerializer(AsyncSerializer* serializer) { mAsyncSerializer = serializer; }
+        void SetFrameScheduler(FrameScheduler* scheduler) { mFrameScheduler = scheduler; }
 
       signals:
         void CurveAdded(SplinePtr spline);
@@ -42,12 +46,16 @@ namespace BSplineRenderer
         void DrawCurvePanel();
         void DrawPresetShapesPanel();
         void DrawAnimationPanel();
+        void DrawTimelinePanel();
+        void DrawRopePanel();
         void DrawStatisticsPanel();
         void DrawFileOperationsPanel();
         void DrawThemePanel();
         void DrawCameraPanel();
         void DrawHelpPanel();
 
+        void ExportMesh();
+
         void ApplyTheme(ThemeStyle style);
 
         int mNumberOfSegments;
@@ -55,6 +63,8 @@ namespace BSplineRenderer
 
         RendererManager* mRendererManager;
         CurveContainer* mCurveContainer{ nullptr };
+        AsyncSerializer* mAsyncSerializer{ nullptr };
+        FrameScheduler* mFrameScheduler{ nullptr };
 
         ThemeStyle mCurrentTheme{ ThemeStyle::Dark };
         bool mShowStatistics{ false };
@@ -70,9 +80,12 @@ namespace BSplineRenderer
         int mSelectedAnimationType{ 0 };
         float mAnimationSpeed{ 1.0f };
         float mAnimationAmplitude{ 1.0f };
+        float mKeyTranslation[3] = { 0.0f, 0.0f, 0.0f };
+        char mBakePath[256] = "timeline.banim";
 
         // Dosya işlemleri
         char mFilePath[256] = "curves.json";
+        char mExportPath[256] = "curves.glb";
 
         DEFINE_MEMBER(SplinePtr, SelectedCurve, nullptr);
         DEFINE_MEMBER(KnotPtr, SelectedKnot, nullptr);
@@ -1,13 +1,80 @@
+#include "Core/Constants.h"
 #include "Core/Controller.h"
+#include "Core/CurveContainer.h"
+#include "Core/CurveSerializer.h"
+#include "Curve/MeshExporter.h"
 #include "Util/Logger.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCoreApplication>
 #include <QImageReader>
+#include <algorithm>
+#include <cstring>
 
 using namespace BSplineRenderer;
 
+namespace
+{
+    // BSplineRenderer --export <scene.{json,bscene}> <mesh.{obj,ply,stl,glb}> [--segments N] [--sectors N]
+    // Loads the scene and writes its tube meshes without creating a window or an OpenGL context.
+    int RunExport(int argc, char* argv[])
+    {
+        QCoreApplication app(argc, argv);
+
+        qInstallMessageHandler(Logger::QtMessageOutputCallback);
+
+        QCommandLineParser parser;
+        parser.setApplicationDescription("Exports the tube meshes of a scene and quits.");
+        parser.addHelpOption();
+        parser.addPositionalArgument("scene", "Scene file to load.");
+        parser.addPositionalArgument("mesh", "Mesh file to write, the extension selects the format: obj, ply, stl or glb.");
+
+        const QCommandLineOption exportOption("export", "Export without opening a window.");
+        const QCommandLineOption segmentsOption("segments", "Segments per patch.", "count", QString::number(DEFAULT_NUMBER_OF_SEGMENTS));
+        const QCommandLineOption sectorsOption("sectors", "Sectors around the tube.", "count", QString::number(DEFAULT_NUMBER_OF_SECTORS));
+        parser.addOptions({ exportOption, segmentsOption, sectorsOption });
+
+        parser.process(app);
+
+        const QStringList arguments = parser.positionalArguments();
+        const int segments = parser.value(segmentsOption).toInt();
+        const int sectors = parser.value(sectorsOption).toInt();
+
+        if (arguments.size() != 2 || segments < 1 || sectors < 1)
+        {
+            parser.showHelp(1);
+        }
+
+        CurveContainer container;
+
+        if (CurveSerializer::LoadFromFile(arguments[0], &container) == false)
+        {
+            LOG_FATAL("Scene could not be loaded from: {}", arguments[0].toStdString());
+            return 1;
+        }
+
+        container.UpdateDirtyCurves();
+
+        if (MeshExporter::Export(arguments[1], container.GetGeometries(), segments, sectors) == false)
+        {
+            LOG_FATAL("Mesh could not be exported to: {}", arguments[1].toStdString());
+            return 1;
+        }
+
+        LOG_INFO("{} curve(s) exported to: {}", container.GetCurves().size(), arguments[1].toStdString());
+
+        return 0;
+    }
+}
+
 int main(int argc, char* argv[])
 {
+    if (std::any_of(argv + 1, argv + argc, [](const char* argument) { return std::strcmp(argument, "--export") == 0; }))
+    {
+        return RunExport(argc, argv);
+    }
+
     QApplication app(argc, argv);
 
     qInstallMessageHandler(Logger::QtMessageOutputCallback);
@@ -0,0 +1,84 @@
+#include "ArenaAllocator.h"
+
+int BSplineRenderer::ArenaAllocator::Allocate(int count)
+{
+    if (count <= 0)
+    {
+        return 0;
+    }
+
+    // First fit, the lowest offsets are reused first so the used part of the buffer stays compact
+    for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it)
+    {
+        const auto [offset, size] = *it;
+
+        if (size < count)
+            continue;
+
+        mFreeRanges.erase(it);
+
+        if (size > count)
+        {
+            mFreeRanges[offset + count] = size - count;
+        }
+
+        mUsed += count;
+
+        return offset;
+    }
+
+    return -1;
+}
+
+void BSplineRenderer::ArenaAllocator::Free(int offset, int count)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    mUsed -= count;
+
+    auto it = mFreeRanges.emplace(offset, count).first;
+
+    const auto next = std::next(it);
+
+    if (next != mFreeRanges.end() && offset + count == next->first)
+    {
+        it->second += next->second;
+        mFreeRanges.erase(next);
+    }
+
+    if (it != mFreeRanges.begin())
+    {
+        const auto previous = std::prev(it);
+
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += it->second;
+            mFreeRanges.erase(it);
+        }
+    }
+}
+
+void BSplineRenderer::ArenaAllocator::Grow(int capacity)
+{
+    if (capacity <= mCapacity)
+    {
+        return;
+    }
+
+    const int oldCapacity = mCapacity;
+    mCapacity = capacity;
+
+    // Counted as used by Free()
+    mUsed += capacity - oldCapacity;
+    Free(oldCapacity, capacity - oldCapacity);
+}
+
+void BSplineRenderer::ArenaAllocator::Clear()
+{
+    mFreeRanges.clear();
+    mCapacity = 0;
+    mUsed = 0;
+}
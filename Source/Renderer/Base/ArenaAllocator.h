@@ -0,0 +1,33 @@
+#pragma once
+
+#include <map>
+
+namespace BSplineRenderer
+{
+    // Sub-allocates ranges of a buffer of capacity units. Free ranges are kept sorted by offset
+    // and merged with their neighbours when a range is freed. Does not own any memory.
+    class ArenaAllocator
+    {
+      public:
+        ArenaAllocator() = default;
+
+        // Offset of count free units, -1 if no free range is large enough
+        int Allocate(int count);
+        void Free(int offset, int count);
+
+        // Appends the units up to capacity as a free range
+        void Grow(int capacity);
+
+        void Clear();
+
+        int GetCapacity() const { return mCapacity; }
+        int GetUsed() const { return mUsed; }
+
+      private:
+        // Offset to size of the free ranges
+        std::map<int, int> mFreeRanges;
+
+        int mCapacity{ 0 };
+        int mUsed{ 0 };
+    };
+}
@@ -2,6 +2,12 @@
 
 #include "Util/Logger.h"
 
+namespace
+{
+    constexpr GLbitfield MAP_FLAGS = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    constexpr GLuint64 WAIT_TIMEOUT = 1'000'000'000;
+}
+
 BSplineRenderer::CurveSelectionFramebuffer::CurveSelectionFramebuffer(int width, int height)
     : mWidth(width)
     , mHeight(height)
@@ -20,6 +26,13 @@ BSplineRenderer::CurveSelectionFramebuffer::CurveSelectionFramebuffer(int width,
     // Bind texture to the framebuffer
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexture, 0);
 
+    // The nearest curve wins where curves overlap
+    glGenRenderbuffers(1, &mDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mWidth, mHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
     {
         BR_EXIT_FAILURE("CurveSelectionFramebuffer::CurveSelectionFramebuffer: Could not create framebuffer!");
@@ -27,10 +40,44 @@ BSplineRenderer::CurveSelectionFramebuffer::CurveSelectionFramebuffer(int width,
 
     glBindTexture(GL_TEXTURE_2D, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &mPixelBuffer);
+
+    if (mPixelBuffer == 0)
+    {
+        BR_EXIT_FAILURE("CurveSelectionFramebuffer::CurveSelectionFramebuffer: OpenGL handle could not be created!");
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixelBuffer);
+    glBufferStorage(GL_PIXEL_PACK_BUFFER, READ_SLOT_COUNT * sizeof(CurveQueryInfo), nullptr, MAP_FLAGS);
+    mPixels = static_cast<const CurveQueryInfo*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, READ_SLOT_COUNT * sizeof(CurveQueryInfo), MAP_FLAGS));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (mPixels == nullptr)
+    {
+        BR_EXIT_FAILURE("CurveSelectionFramebuffer::CurveSelectionFramebuffer: Pixel buffer could not be mapped!");
+    }
 }
 
 BSplineRenderer::CurveSelectionFramebuffer::~CurveSelectionFramebuffer()
 {
+    // Nobody is left waiting on a future
+    for (auto& read : mPendingReads)
+    {
+        Wait(read.fence);
+        Resolve(read);
+    }
+
+    mPendingReads.clear();
+
+    if (mPixelBuffer != 0)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixelBuffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteBuffers(1, &mPixelBuffer);
+    }
+
     if (mFramebuffer != 0)
     {
         glDeleteFramebuffers(1, &mFramebuffer);
@@ -40,27 +87,110 @@ BSplineRenderer::CurveSelectionFramebuffer::~CurveSelectionFramebuffer()
     {
         glDeleteTextures(1, &mTexture);
     }
+
+    if (mDepthBuffer != 0)
+    {
+        glDeleteRenderbuffers(1, &mDepthBuffer);
+    }
 }
 
-void BSplineRenderer::CurveSelectionFramebuffer::Clear()
+void BSplineRenderer::CurveSelectionFramebuffer::BindPixel(const QPoint& point)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
     glViewport(0, 0, mWidth, mHeight);
+
+    // Only the pixel read by Query() is cleared and shaded
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(point.x(), mHeight - point.y(), 1, 1);
+
     glClearColor(0, 0, 0, 0);
-    glClear(GL_COLOR_BUFFER_BIT);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void BSplineRenderer::CurveSelectionFramebuffer::Bind()
+void BSplineRenderer::CurveSelectionFramebuffer::Release()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-BSplineRenderer::CurveQueryInfo BSplineRenderer::CurveSelectionFramebuffer::Query(const QPoint& queryPoint)
+std::future<BSplineRenderer::CurveQueryInfo> BSplineRenderer::CurveSelectionFramebuffer::Query(const QPoint& queryPoint)
 {
-    CurveQueryInfo info;
-    Bind();
+    mStallTime = 0.0;
+
+    if (mPendingReads.size() == READ_SLOT_COUNT)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Wait(mPendingReads.front().fence);
+        mStallTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        Resolve(mPendingReads.front());
+        mPendingReads.pop_front();
+    }
+
+    const int slot = mNextSlot;
+    mNextSlot = (mNextSlot + 1) % READ_SLOT_COUNT;
+
+    // Into the pixel buffer, glReadPixels returns without waiting for the ID pass
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
     glReadBuffer(GL_COLOR_ATTACHMENT0);
-    glReadPixels(queryPoint.x(), mHeight - queryPoint.y(), 1, 1, GL_RGBA_INTEGER, GL_INT, &info);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mPixelBuffer);
+    glReadPixels(queryPoint.x(), mHeight - queryPoint.y(), 1, 1, GL_RGBA_INTEGER, GL_INT, reinterpret_cast<void*>(slot * sizeof(CurveQueryInfo)));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    PendingRead read{ slot, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), {}, std::chrono::steady_clock::now() };
+    std::future<CurveQueryInfo> future = read.promise.get_future();
+    mPendingReads.push_back(std::move(read));
+
+    return future;
+}
+
+void BSplineRenderer::CurveSelectionFramebuffer::Poll()
+{
+    while (mPendingReads.empty() == false)
+    {
+        const GLenum result = glClientWaitSync(mPendingReads.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            break;
+        }
+
+        if (result == GL_WAIT_FAILED)
+        {
+            LOG_WARN("CurveSelectionFramebuffer::Poll: glClientWaitSync failed. Slot = {}", mPendingReads.front().slot);
+        }
+
+        Resolve(mPendingReads.front());
+        mPendingReads.pop_front();
+    }
+}
+
+void BSplineRenderer::CurveSelectionFramebuffer::Wait(GLsync fence)
+{
+    while (true)
+    {
+        const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT);
+
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+
+        if (result == GL_WAIT_FAILED)
+        {
+            LOG_WARN("CurveSelectionFramebuffer::Wait: glClientWaitSync failed.");
+            break;
+        }
+    }
+}
+
+void BSplineRenderer::CurveSelectionFramebuffer::Resolve(PendingRead& read)
+{
+    glDeleteSync(read.fence);
+    read.fence = nullptr;
 
-    return info;
+    // Coherent mapping, the data is visible once the fence has signaled
+    read.promise.set_value(mPixels[read.slot]);
+    mLatency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - read.time).count();
 }
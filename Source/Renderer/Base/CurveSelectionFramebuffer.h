@@ -3,6 +3,9 @@
 #include <QOpenGLFunctions_4_5_Core>
 #include <QPoint>
 #include <QVector4D>
+#include <chrono>
+#include <deque>
+#include <future>
 #include <memory>
 
 namespace BSplineRenderer
@@ -15,22 +18,61 @@ namespace BSplineRenderer
         int result; // 0: Fail, 1: Success
     };
 
+    // Integer ID target of the curve picking pass. Pixels are read back asynchronously into a persistently
+    // mapped pixel buffer object and fenced, the CPU picks the result up a frame later instead of waiting
+    // for the GPU to finish the frame.
     class CurveSelectionFramebuffer : protected QOpenGLFunctions_4_5_Core
     {
       public:
         CurveSelectionFramebuffer(int width, int height);
         ~CurveSelectionFramebuffer();
 
-        void Clear();
-        void Bind();
-        CurveQueryInfo Query(const QPoint& queryPoint);
+        // Clears the pixel at the point and restricts drawing to it until Release()
+        void BindPixel(const QPoint& point);
+        void Release();
+
+        // Issues the read of the pixel, the future is resolved by Poll() once the GPU has written it.
+        // Waits for the oldest read only if all READ_SLOT_COUNT reads are still in flight.
+        std::future<CurveQueryInfo> Query(const QPoint& queryPoint);
+
+        // Resolves the reads the GPU has finished, never waits
+        void Poll();
 
         GLuint GetHandle() const { return mFramebuffer; }
         GLuint GetTexture() const { return mTexture; }
 
+        // Time from issuing to resolving the last resolved read and the time the last Query() waited, in ms
+        double GetLatency() const { return mLatency; }
+        double GetStallTime() const { return mStallTime; }
+
+        static constexpr int READ_SLOT_COUNT = 4;
+
       private:
+        struct PendingRead
+        {
+            int slot;
+            GLsync fence;
+            std::promise<CurveQueryInfo> promise;
+            std::chrono::steady_clock::time_point time;
+        };
+
+        void Wait(GLsync fence);
+        void Resolve(PendingRead& read);
+
         GLuint mFramebuffer{ 0 };
         GLuint mTexture{ 0 };
+        GLuint mDepthBuffer{ 0 };
+
+        // One CurveQueryInfo per slot, the slots are used in order
+        GLuint mPixelBuffer{ 0 };
+        const CurveQueryInfo* mPixels{ nullptr };
+        int mNextSlot{ 0 };
+
+        // Oldest first, the GPU finishes them in order
+        std::deque<PendingRead> mPendingReads;
+
+        double mLatency{ 0.0 };
+        double mStallTime{ 0.0 };
 
         int mWidth;
         int mHeight;
@@ -0,0 +1,146 @@
+#include "RingBuffer.h"
+
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    constexpr GLbitfield MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    constexpr GLuint64 WAIT_TIMEOUT = 1'000'000'000;
+}
+
+BSplineRenderer::RingBuffer::RingBuffer(GLsizeiptr regionSize)
+{
+    initializeOpenGLFunctions();
+    Create(regionSize);
+}
+
+BSplineRenderer::RingBuffer::~RingBuffer()
+{
+    Destroy();
+}
+
+void BSplineRenderer::RingBuffer::BeginFrame()
+{
+    mRegion = (mRegion + 1) % REGION_COUNT;
+    mHead = 0;
+    mBytes = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    WaitRegion(mRegion);
+    mStallTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BSplineRenderer::RingBuffer::EndFrame()
+{
+    if (mFences[mRegion])
+    {
+        glDeleteSync(mFences[mRegion]);
+    }
+
+    mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mFrameBytes = mBytes;
+}
+
+char* BSplineRenderer::RingBuffer::Map(GLsizeiptr size, GLintptr& offset)
+{
+    const GLsizeiptr aligned = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    if (mHead + aligned > mRegionSize)
+    {
+        // The copies queued from the old buffer keep it alive until the GPU is done with them
+        const GLsizeiptr regionSize = std::max(2 * mRegionSize, aligned);
+
+        LOG_DEBUG("RingBuffer::Map: Region size {} -> {}", mRegionSize, regionSize);
+
+        Destroy();
+        Create(regionSize);
+        mHead = 0;
+    }
+
+    offset = mRegion * mRegionSize + mHead;
+    mHead += aligned;
+    mBytes += size;
+
+    return mData + offset;
+}
+
+void BSplineRenderer::RingBuffer::Copy(GLintptr offset, GLuint target, GLintptr targetOffset, GLsizeiptr size)
+{
+    glCopyNamedBufferSubData(mBuffer, target, offset, targetOffset, size);
+}
+
+void BSplineRenderer::RingBuffer::Create(GLsizeiptr regionSize)
+{
+    glGenBuffers(1, &mBuffer);
+
+    if (mBuffer == 0)
+    {
+        BR_EXIT_FAILURE("RingBuffer::Create: OpenGL handle could not be created! Region size = {}", regionSize);
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, REGION_COUNT * regionSize, nullptr, MAP_FLAGS);
+    mData = static_cast<char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, REGION_COUNT * regionSize, MAP_FLAGS));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (mData == nullptr)
+    {
+        BR_EXIT_FAILURE("RingBuffer::Create: Buffer could not be mapped! Region size = {}", regionSize);
+    }
+
+    mRegionSize = regionSize;
+}
+
+void BSplineRenderer::RingBuffer::Destroy()
+{
+    for (auto& fence : mFences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (mBuffer != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &mBuffer);
+        mBuffer = 0;
+        mData = nullptr;
+    }
+}
+
+void BSplineRenderer::RingBuffer::WaitRegion(int region)
+{
+    GLsync& fence = mFences[region];
+
+    if (fence == nullptr)
+    {
+        return;
+    }
+
+    while (true)
+    {
+        const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT);
+
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+
+        if (result == GL_WAIT_FAILED)
+        {
+            LOG_WARN("RingBuffer::WaitRegion: glClientWaitSync failed. Region = {}", region);
+            break;
+        }
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
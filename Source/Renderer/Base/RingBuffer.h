@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Util/Macros.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+
+namespace BSplineRenderer
+{
+    // Persistently mapped staging buffer for the uploads of a frame. The buffer is split into one
+    // region per frame in flight and each region is fenced at the end of its frame, so the CPU writes
+    // into memory the GPU is done with instead of letting the driver allocate a new buffer per upload.
+    // The data is moved into the destination buffers with glCopyBufferSubData or read in place.
+    class RingBuffer : protected QOpenGLFunctions_4_5_Core
+    {
+        DISABLE_COPY(RingBuffer);
+
+      public:
+        explicit RingBuffer(GLsizeiptr regionSize);
+        ~RingBuffer();
+
+        // Waits until the GPU has finished reading the region of this frame
+        void BeginFrame();
+
+        // Fences the region written since BeginFrame(), again if more was written after the last call
+        void EndFrame();
+
+        // Space for size bytes in this frame's region, offset is its position in GetBuffer().
+        // The region grows if it is full. Both are valid until the next Map().
+        char* Map(GLsizeiptr size, GLintptr& offset);
+
+        // Copies size bytes written by Map() at offset into the target buffer
+        void Copy(GLintptr offset, GLuint target, GLintptr targetOffset, GLsizeiptr size);
+
+        GLuint GetBuffer() const { return mBuffer; }
+
+        // Bytes Map() can still return in this frame without growing the region
+        GLsizeiptr GetAvailableSize() const { return mRegionSize - mHead; }
+
+        // Bytes mapped in the last frame and the time spent waiting for its region
+        GLsizeiptr GetFrameBytes() const { return mFrameBytes; }
+        double GetStallTime() const { return mStallTime; }
+
+        static constexpr int REGION_COUNT = 3;
+        static constexpr GLsizeiptr ALIGNMENT = 256;
+
+      private:
+        void Create(GLsizeiptr regionSize);
+        void Destroy();
+        void WaitRegion(int region);
+
+        GLuint mBuffer{ 0 };
+        char* mData{ nullptr };
+        GLsizeiptr mRegionSize{ 0 };
+
+        GLsync mFences[REGION_COUNT]{};
+        int mRegion{ 0 };
+        GLsizeiptr mHead{ 0 };
+
+        GLsizeiptr mFrameBytes{ 0 };
+        GLsizeiptr mBytes{ 0 };
+        double mStallTime{ 0.0 };
+    };
+}
@@ -4,6 +4,9 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
+
+QByteArray BSplineRenderer::Shader::mPrelude;
 
 BSplineRenderer::Shader::Shader(const QString& name)
     : mProgram(nullptr)
@@ -21,7 +24,7 @@ void BSplineRenderer::Shader::Initialize()
 
     for (const auto [shaderType, path] : mPaths)
     {
-        const auto bytes = Util::GetBytes(path);
+        const auto bytes = AddPrelude(AddIncludes(Util::GetBytes(path), path));
         if (!mProgram->addShaderFromSourceCode(shaderType, bytes))
         {
             BR_EXIT_FAILURE("Shader::Initialize: '{}' could not be loaded.", GetShaderTypeString(shaderType).toStdString());
@@ -51,6 +54,70 @@ void BSplineRenderer::Shader::Release()
     mProgram->release();
 }
 
+GLint BSplineRenderer::Shader::GetUniformLocation(const QString& name)
+{
+    const GLint location = mProgram->uniformLocation(name);
+
+    if (location < 0)
+    {
+        LOG_WARN("Shader::GetUniformLocation: Uniform location '{}' could not be found in '{}'.", name.toStdString(), mName.toStdString());
+    }
+
+    return location;
+}
+
+void BSplineRenderer::Shader::SetPrelude(const QByteArray& prelude)
+{
+    mPrelude = prelude;
+}
+
+QByteArray BSplineRenderer::Shader::AddPrelude(const QByteArray& source)
+{
+    const qsizetype version = source.indexOf("#version");
+    const qsizetype end = version < 0 ? -1 : source.indexOf('\n', version);
+
+    if (mPrelude.isEmpty() || end < 0)
+    {
+        return source;
+    }
+
+    // The #line directive keeps the line numbers of the compiler messages those of the file
+    const QByteArray head = source.left(end + 1);
+    const QByteArray line = "#line " + QByteArray::number(head.count('\n') + 1) + "\n";
+
+    return head + mPrelude + line + source.mid(end + 1);
+}
+
+QByteArray BSplineRenderer::Shader::AddIncludes(const QByteArray& source, const QString& path)
+{
+    const QString directory = QFileInfo(path).path();
+    const QList<QByteArray> lines = source.split('\n');
+
+    QByteArray result;
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        const QByteArray line = lines[i].trimmed();
+        const qsizetype first = line.indexOf('"');
+        const qsizetype last = line.lastIndexOf('"');
+
+        if (line.startsWith("#include") && 0 <= first && first < last)
+        {
+            const QString includePath = directory + "/" + QString::fromUtf8(line.mid(first + 1, last - first - 1));
+
+            // The #line directives keep the line numbers of the compiler messages those of the files
+            result += "#line 1\n" + AddIncludes(Util::GetBytes(includePath), includePath) + "\n#line " + QByteArray::number(i + 2) + "\n";
+        }
+        else
+        {
+            result += lines[i];
+            result += i + 1 < lines.size() ? "\n" : "";
+        }
+    }
+
+    return result;
+}
+
 void BSplineRenderer::Shader::AddPath(QOpenGLShader::ShaderTypeBit type, const QString& path)
 {
     mPaths.emplace(type, path);
@@ -2,6 +2,7 @@
 
 #include "Util/Logger.h"
 
+#include <QByteArray>
 #include <QObject>
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLShader>
@@ -18,62 +19,68 @@ namespace BSplineRenderer
         bool Bind();
         void Release();
 
+        // Lines of the form #include "File.glsl" are replaced by the file, relative to the directory of the shader
         void AddPath(QOpenGLShader::ShaderTypeBit type, const QString& path);
 
         QString GetName() const;
 
         static QString GetShaderTypeString(QOpenGLShader::ShaderTypeBit type);
 
+        // Declarations shared by all shaders, inserted after the #version line of every stage.
+        // Must be set before the shaders are initialized.
+        static void SetPrelude(const QByteArray& prelude);
+
+        // -1 if the program has no such uniform. Meant to be called once after Initialize(), the
+        // locations are then passed to SetUniformValue() every frame.
+        GLint GetUniformLocation(const QString& name);
+
         template<typename T>
-        void SetUniformValue(const QString& name, T value)
+        void SetUniformValue(GLint location, T value)
         {
-            const auto location = mProgram->uniformLocation(name);
-
             if (0 <= location)
             {
                 mProgram->setUniformValue(location, value);
             }
-            else
-            {
-                LOG_WARN("Shader::SetUniformValue: Uniform location '{}' could not be found.", name.toStdString());
-            }
+        }
+
+        template<typename T>
+        void SetUniformValue(const QString& name, T value)
+        {
+            SetUniformValue(GetUniformLocation(name), value);
         }
 
         template<typename T>
         void SetUniformValueArray(const QString& name, const QVector<T>& values)
         {
-            const auto location = mProgram->uniformLocation(name);
+            const auto location = GetUniformLocation(name);
 
             if (0 <= location)
             {
                 mProgram->setUniformValueArray(location, values.constData(), values.size());
             }
-            else
-            {
-                LOG_WARN("Shader::SetUniformValue: Uniform location '{}' could not be found.", name.toStdString());
-            }
         }
 
         void SetUniformValueFloatArray(const QString& name, const QVector<float>& values)
         {
-            const auto location = mProgram->uniformLocation(name);
+            const auto location = GetUniformLocation(name);
 
             if (0 <= location)
             {
                 mProgram->setUniformValueArray(location, values.constData(), values.size(), 1);
             }
-            else
-            {
-                LOG_WARN("Shader::SetUniformValue: Uniform location '{}' could not be found.", name.toStdString());
-            }
         }
 
         void SetSampler(const QString& name, GLuint unit, GLuint textureId, GLuint target = GL_TEXTURE_2D);
 
       private:
+        static QByteArray AddPrelude(const QByteArray& source);
+        static QByteArray AddIncludes(const QByteArray& source, const QString& path);
+
         QSharedPointer<QOpenGLShaderProgram> mProgram;
         std::map<QOpenGLShader::ShaderTypeBit, QString> mPaths;
 
         QString mName;
+
+        static QByteArray mPrelude;
     };
 }
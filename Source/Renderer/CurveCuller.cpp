@@ -0,0 +1,74 @@
+#include "CurveCuller.h"
+
+#include "Util/Frustum.h"
+#include "Util/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace
+{
+    constexpr int CURVES_PER_JOB = 256;
+
+    // Closer than this the bounds are treated as reaching behind the camera
+    constexpr float MIN_DEPTH = 1e-4f;
+
+    // Smallest clip space w, the distance along the view direction for a perspective projection, of a box
+    float GetNearestDepth(const QMatrix4x4& viewProjection, const QVector3D& min, const QVector3D& max)
+    {
+        float depth = viewProjection(3, 3);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            depth += std::min(viewProjection(3, i) * min[i], viewProjection(3, i) * max[i]);
+        }
+
+        return depth;
+    }
+}
+
+void BSplineRenderer::CurveCuller::Cull(const QVector<SplinePtr>& curves, const QMatrix4x4& viewProjection, float pixelScale, float impostorPixelRadius)
+{
+    const Frustum frustum(viewProjection);
+    std::atomic<int> visibleCount{ 0 };
+    std::atomic<int> impostorCount{ 0 };
+
+    mVisible.assign(curves.size(), 0);
+    mImpostor.assign(curves.size(), 0);
+    mPixelRadius.assign(curves.size(), 0.0f);
+
+    JobSystem::Instance().ParallelFor(curves.size(), CURVES_PER_JOB, [&](int first, int count) {
+        int visible = 0;
+        int impostors = 0;
+
+        for (int i = first; i < first + count; ++i)
+        {
+            const auto& curve = curves[i];
+            const auto [min, max] = curve->GetPatchBounds();
+
+            QVector3D worldMin;
+            QVector3D worldMax;
+            Frustum::Transform(curve->GetModelMatrix(), min, max, curve->GetRadius(), worldMin, worldMax);
+
+            const float depth = GetNearestDepth(viewProjection, worldMin, worldMax);
+            mPixelRadius[i] = depth > MIN_DEPTH ? pixelScale * curve->GetRadius() / depth : std::numeric_limits<float>::infinity();
+
+            mVisible[i] = frustum.Intersects(worldMin, worldMax);
+            mImpostor[i] = mVisible[i] && mPixelRadius[i] < impostorPixelRadius;
+            visible += mVisible[i];
+            impostors += mImpostor[i];
+        }
+
+        visibleCount += visible;
+        impostorCount += impostors;
+    });
+
+    mVisibleCount = visibleCount;
+    mImpostorCount = impostorCount;
+}
+
+float BSplineRenderer::CurveCuller::GetPixelRadius(int index) const
+{
+    return 0 <= index && index < int(mPixelRadius.size()) ? mPixelRadius[index] : std::numeric_limits<float>::infinity();
+}
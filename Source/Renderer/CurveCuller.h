@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Curve/Spline.h"
+
+#include <QMatrix4x4>
+#include <QVector>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // Visibility of the curves for a camera. The bounds of the Bezier control points, transformed
+    // by the model matrix and widened by the tube radius, are tested against the view frustum.
+    // The radius of the tube in pixels at the nearest corner of the bounds decides whether a
+    // visible curve is drawn with impostors instead of tessellated tubes.
+    class CurveCuller
+    {
+      public:
+        CurveCuller() = default;
+
+        // Culls every curve on the JobSystem, the curves must be up to date. pixelScale is the height of the
+        // viewport in pixels of an object of height one at distance one. Visible curves whose tube radius is
+        // under impostorPixelRadius pixels are marked as impostors.
+        void Cull(const QVector<SplinePtr>& curves, const QMatrix4x4& viewProjection, float pixelScale, float impostorPixelRadius);
+
+        // Index into the curves of the last Cull(). Curves added since are visible and not impostors.
+        bool IsVisible(int index) const { return index >= int(mVisible.size()) || mVisible[index]; }
+        bool IsImpostor(int index) const { return index < int(mImpostor.size()) && mImpostor[index]; }
+
+        // Upper bound of the tube radius in pixels, infinite if the bounds reach behind the camera
+        float GetPixelRadius(int index) const;
+
+        int GetVisibleCount() const { return mVisibleCount; }
+        int GetImpostorCount() const { return mImpostorCount; }
+
+      private:
+        std::vector<char> mVisible;
+        std::vector<char> mImpostor;
+        std::vector<float> mPixelRadius;
+        int mVisibleCount{ 0 };
+        int mImpostorCount{ 0 };
+    };
+}
@@ -10,29 +10,85 @@ void BSplineRenderer::CurveSelectionRenderer::Initialize()
     mShader->AddPath(QOpenGLShader::TessellationEvaluation, ":/Resources/Shaders/Spline.tes");
     mShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/CurveSelection.frag");
     mShader->Initialize();
+
+    mNumberOfSegmentsLocation = mShader->GetUniformLocation("numberOfSegments");
+    mNumberOfSectorsLocation = mShader->GetUniformLocation("numberOfSectors");
+
+    mTubeShader = new Shader("Curve Selection Tube Shader");
+    mTubeShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/Tube.vert");
+    mTubeShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/CurveSelection.frag");
+    mTubeShader->Initialize();
+
+    mCurveIndexLocation = mTubeShader->GetUniformLocation("curveIndex");
+
+    mImpostorShader = new Shader("Curve Selection Impostor Shader");
+    mImpostorShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/TubeImpostor.vert");
+    mImpostorShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/CurveSelectionImpostor.frag");
+    mImpostorShader->Initialize();
 }
 
-void BSplineRenderer::CurveSelectionRenderer::Render()
+std::future<BSplineRenderer::CurveQueryInfo> BSplineRenderer::CurveSelectionRenderer::Query(const QPoint& queryPoint)
 {
-    mFramebuffer->Clear();
-    mFramebuffer->Bind();
+    // Drawn on demand into the queried pixel only, with the buffers and the visibility of the last frame
+    mFramebuffer->BindPixel(queryPoint);
+
+    Shader* shader = mCpuTubeMesh ? mTubeShader : mShader;
 
-    mShader->Bind();
-    mShader->SetUniformValue("numberOfSegments", mNumberOfSegments);
-    mShader->SetUniformValue("numberOfSectors", mNumberOfSectors);
-    mShader->SetUniformValue("VP", mCamera->GetViewProjectionMatrix());
+    shader->Bind();
+
+    if (mCpuTubeMesh == false)
+    {
+        shader->SetUniformValue(mNumberOfSegmentsLocation, mNumberOfSegments);
+        shader->SetUniformValue(mNumberOfSectorsLocation, mNumberOfSectors);
+    }
 
     const auto& curves = mCurveContainer->GetCurves();
 
-    for (int index = 0; index < curves.size(); ++index)
+    if (mCpuTubeMesh)
     {
-        const auto& curve = curves[index];
-        mShader->SetUniformValue("curveIndex", index);
-        mShader->SetUniformValue("radius", curve->GetRadius());
-        curve->Render();
+        mSplineBufferCache->BindCurveData();
+
+        for (int index = 0; index < curves.size(); ++index)
+        {
+            if (mCurveCuller->IsVisible(index))
+            {
+                shader->SetUniformValue(mCurveIndexLocation, index);
+                mTubeMeshCache->Render(curves[index]);
+            }
+        }
     }
+    else
+    {
+        mSplineBufferCache->Draw(curves, *mCurveCuller);
+    }
+
+    shader->Release();
+
+    if (mCpuTubeMesh == false && mCurveCuller->GetImpostorCount() > 0)
+    {
+        mImpostorShader->Bind();
+        mSplineBufferCache->DrawImpostors(curves, *mCurveCuller);
+        mImpostorShader->Release();
+    }
+
+    mFramebuffer->Release();
+
+    return mFramebuffer->Query(queryPoint);
+}
+
+void BSplineRenderer::CurveSelectionRenderer::Poll()
+{
+    mFramebuffer->Poll();
+}
 
-    mShader->Release();
+double BSplineRenderer::CurveSelectionRenderer::GetReadbackLatency() const
+{
+    return mFramebuffer ? mFramebuffer->GetLatency() : 0.0;
+}
+
+double BSplineRenderer::CurveSelectionRenderer::GetReadbackStallTime() const
+{
+    return mFramebuffer ? mFramebuffer->GetStallTime() : 0.0;
 }
 
 void BSplineRenderer::CurveSelectionRenderer::Resize(int width, int height)
@@ -46,17 +102,22 @@ void BSplineRenderer::CurveSelectionRenderer::Resize(int width, int height)
     mFramebuffer = new CurveSelectionFramebuffer(width, height);
 }
 
-BSplineRenderer::CurveQueryInfo BSplineRenderer::CurveSelectionRenderer::Query(const QPoint& queryPoint)
+void BSplineRenderer::CurveSelectionRenderer::SetCurveContainer(CurveContainer* curveContainer)
 {
-    return mFramebuffer->Query(queryPoint);
+    mCurveContainer = curveContainer;
 }
 
-void BSplineRenderer::CurveSelectionRenderer::SetCurveContainer(CurveContainer* curveContainer)
+void BSplineRenderer::CurveSelectionRenderer::SetTubeMeshCache(TubeMeshCache* tubeMeshCache)
 {
-    mCurveContainer = curveContainer;
+    mTubeMeshCache = tubeMeshCache;
+}
+
+void BSplineRenderer::CurveSelectionRenderer::SetSplineBufferCache(SplineBufferCache* splineBufferCache)
+{
+    mSplineBufferCache = splineBufferCache;
 }
 
-void BSplineRenderer::CurveSelectionRenderer::SetCamera(FreeCameraPtr camera)
+void BSplineRenderer::CurveSelectionRenderer::SetCurveCuller(CurveCuller* curveCuller)
 {
-    mCamera = camera;
+    mCurveCuller = curveCuller;
 }
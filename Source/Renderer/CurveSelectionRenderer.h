@@ -1,9 +1,11 @@
 #pragma once
 
 #include "Core/CurveContainer.h"
-#include "Node/Camera/FreeCamera.h"
 #include "Renderer/Base/CurveSelectionFramebuffer.h"
 #include "Renderer/Base/Shader.h"
+#include "Renderer/CurveCuller.h"
+#include "Renderer/SplineBufferCache.h"
+#include "Renderer/TubeMeshCache.h"
 
 #include <QOpenGLExtraFunctions>
 
@@ -15,21 +17,39 @@ namespace BSplineRenderer
         CurveSelectionRenderer() = default;
 
         void Initialize();
-        void Render();
         void Resize(int width, int height);
 
-        CurveQueryInfo Query(const QPoint& queryPoint);
+        // Renders the curve IDs under the point, the ID in front is read back asynchronously
+        std::future<CurveQueryInfo> Query(const QPoint& queryPoint);
+
+        // Resolves the queries the GPU has finished
+        void Poll();
+
+        double GetReadbackLatency() const;
+        double GetReadbackStallTime() const;
 
         void SetCurveContainer(CurveContainer* curveContainer);
-        void SetCamera(FreeCameraPtr camera);
+        void SetTubeMeshCache(TubeMeshCache* tubeMeshCache);
+        void SetSplineBufferCache(SplineBufferCache* splineBufferCache);
+        void SetCurveCuller(CurveCuller* curveCuller);
 
       private:
         CurveContainer* mCurveContainer;
         Shader* mShader;
-        FreeCameraPtr mCamera;
+        Shader* mTubeShader;
+        Shader* mImpostorShader;
+
+        // Uniform locations of the spline and the tube shader, looked up once they are linked
+        GLint mNumberOfSegmentsLocation{ -1 };
+        GLint mNumberOfSectorsLocation{ -1 };
+        GLint mCurveIndexLocation{ -1 };
+        TubeMeshCache* mTubeMeshCache;
+        SplineBufferCache* mSplineBufferCache;
+        CurveCuller* mCurveCuller;
         CurveSelectionFramebuffer* mFramebuffer{ nullptr };
 
         DEFINE_MEMBER(int, NumberOfSegments, DEFAULT_NUMBER_OF_SEGMENTS);
         DEFINE_MEMBER(int, NumberOfSectors, DEFAULT_NUMBER_OF_SECTORS);
+        DEFINE_MEMBER(bool, CpuTubeMesh, false);
     };
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "KnotRenderer.h"
+
+#include "Node/Mesh/Sphere.h"
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+    constexpr int INITIAL_CAPACITY = 1024;
+
+    constexpr float KNOT_AMBIENT = 0.10f;
+    constexpr float KNOT_DIFFUSE = 0.50f;
+}
+
+BSplineRenderer::KnotRenderer::~KnotRenderer()
+{
+    glDeleteVertexArrays(1, &mVertexArray);
+    glDeleteBuffers(1, &mVertexBuffer);
+    glDeleteBuffers(1, &mNormalBuffer);
+    glDeleteBuffers(1, &mIndexBuffer);
+    glDeleteBuffers(1, &mInstanceBuffer);
+}
+
+void BSplineRenderer::KnotRenderer::Initialize()
+{
+    initializeOpenGLFunctions();
+
+    mShader = new Shader("Knot Shader");
+    mShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/Knot.vert");
+    mShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Knot.frag");
+    mShader->Initialize();
+
+    mImpostorShader = new Shader("Knot Impostor Shader");
+    mImpostorShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/KnotImpostor.vert");
+    mImpostorShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/KnotImpostor.frag");
+    mImpostorShader->Initialize();
+
+    mAmbientLocation = mShader->GetUniformLocation("ambient");
+    mDiffuseLocation = mShader->GetUniformLocation("diffuse");
+    mImpostorAmbientLocation = mImpostorShader->GetUniformLocation("ambient");
+    mImpostorDiffuseLocation = mImpostorShader->GetUniformLocation("diffuse");
+
+    glGenVertexArrays(1, &mVertexArray);
+    glGenBuffers(1, &mVertexBuffer);
+    glGenBuffers(1, &mNormalBuffer);
+    glGenBuffers(1, &mIndexBuffer);
+
+    if (mVertexArray == 0 || mVertexBuffer == 0 || mNormalBuffer == 0 || mIndexBuffer == 0)
+    {
+        BR_EXIT_FAILURE("KnotRenderer::Initialize: OpenGL handle(s) could not be created!");
+    }
+
+    // Only the vertices of the unit sphere are needed, the knots are placed by the instance attributes
+    const Sphere sphere;
+    mIndexCount = sphere.GetIndexCount();
+
+    glBindVertexArray(mVertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sphere.GetVertexSize(), sphere.GetVertices(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*) nullptr);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mNormalBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sphere.GetNormalSize(), sphere.GetNormals(), GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*) nullptr);
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere.GetIndexSize(), sphere.GetIndices(), GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    Grow(INITIAL_CAPACITY);
+}
+
+void BSplineRenderer::KnotRenderer::Render(SplinePtr curve, KnotPtr selectedKnot, KnotPtr knotAround, SplinePtr knotAroundCurve, bool impostors)
+{
+    UpdateInstances(curve, selectedKnot, knotAround, knotAroundCurve);
+
+    if (mInstanceCount == 0)
+    {
+        return;
+    }
+
+    Upload();
+
+    Shader* shader = impostors ? mImpostorShader : mShader;
+
+    shader->Bind();
+    shader->SetUniformValue(impostors ? mImpostorAmbientLocation : mAmbientLocation, KNOT_AMBIENT);
+    shader->SetUniformValue(impostors ? mImpostorDiffuseLocation : mDiffuseLocation, KNOT_DIFFUSE);
+
+    glBindVertexArray(mVertexArray);
+
+    // The impostors only read the instance attributes
+    if (impostors)
+    {
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, mInstanceCount);
+    }
+    else
+    {
+        glDrawElementsInstanced(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, nullptr, mInstanceCount);
+    }
+
+    glBindVertexArray(0);
+
+    shader->Release();
+}
+
+void BSplineRenderer::KnotRenderer::UpdateInstances(const SplinePtr& curve, const KnotPtr& selectedKnot, const KnotPtr& knotAround, const SplinePtr& knotAroundCurve)
+{
+    const QVector<KnotPtr> noKnots;
+    const QVector<KnotPtr>& knots = curve ? curve->GetKnots() : noKnots;
+    const int knotCount = knots.size();
+
+    // The knot around is drawn after the knots of the curve if it belongs to another curve
+    const bool foreign = knotAround && knotAroundCurve && knotAroundCurve != curve;
+    const int count = knotCount + (foreign ? 1 : 0);
+
+    // A quarter spare for the knot around and for curves that are still being extended
+    if (count > mCapacity)
+    {
+        Grow(std::max(2 * mCapacity, count + count / 4));
+    }
+
+    const unsigned long long curveId = curve ? curve->GetId() : 0;
+    const bool rebuild = curveId != mCurveId || knotCount != mKnotCount;
+    const bool moved = curve && (curve->GetVersion() != mVersion || curve->GetModelMatrix() != mModelMatrix || curve->GetRadius() != mRadius);
+
+    const int oldSelectedIndex = mSelectedIndex;
+    const int oldAroundIndex = mAroundIndex;
+
+    // A new version may also have replaced the knots, otherwise the indices are only looked up when the knots change
+    if (rebuild || moved || selectedKnot != mSelectedKnot || knotAround != mKnotAround)
+    {
+        mSelectedIndex = selectedKnot ? knots.indexOf(selectedKnot) : -1;
+        mAroundIndex = knotAround && foreign == false ? knots.indexOf(knotAround) : -1;
+    }
+
+    if (rebuild || moved)
+    {
+        for (int index = 0; index < knotCount; ++index)
+        {
+            SetInstance(index, MakeInstance(*curve, *knots[index], GetState(index)));
+        }
+    }
+    else
+    {
+        // Only the flags of the knots that were or are highlighted
+        for (const int index : { oldSelectedIndex, oldAroundIndex, mSelectedIndex, mAroundIndex })
+        {
+            if (0 <= index && index < knotCount)
+            {
+                SetState(index);
+            }
+        }
+    }
+
+    if (foreign)
+    {
+        SetInstance(knotCount, MakeInstance(*knotAroundCurve, *knotAround, AROUND));
+    }
+
+    mCurveId = curveId;
+    mVersion = curve ? curve->GetVersion() : 0;
+    mModelMatrix = curve ? curve->GetModelMatrix() : QMatrix4x4();
+    mRadius = curve ? curve->GetRadius() : 0.0f;
+    mKnotCount = knotCount;
+    mSelectedKnot = selectedKnot;
+    mKnotAround = knotAround;
+    mInstanceCount = count;
+}
+
+void BSplineRenderer::KnotRenderer::SetInstance(int index, const Instance& instance)
+{
+    if (std::memcmp(&mInstances[index], &instance, sizeof(Instance)) != 0)
+    {
+        mInstances[index] = instance;
+        mDirty[index] = 1;
+    }
+}
+
+void BSplineRenderer::KnotRenderer::SetState(int index)
+{
+    const State state = GetState(index);
+
+    if (mInstances[index].state != state)
+    {
+        mInstances[index].state = state;
+        mDirty[index] = 1;
+    }
+}
+
+BSplineRenderer::KnotRenderer::State BSplineRenderer::KnotRenderer::GetState(int index) const
+{
+    if (index == mSelectedIndex)
+    {
+        return SELECTED;
+    }
+
+    return index == mAroundIndex ? AROUND : NORMAL;
+}
+
+void BSplineRenderer::KnotRenderer::Upload()
+{
+    int size = 0;
+
+    for (int index = 0; index < mInstanceCount; ++index)
+    {
+        size += mDirty[index];
+    }
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    GLintptr stagingOffset = 0;
+    Instance* staging = reinterpret_cast<Instance*>(mRingBuffer->Map(size * sizeof(Instance), stagingOffset));
+
+    // One copy per run of consecutive dirty instances
+    int staged = 0;
+
+    for (int first = 0; first < mInstanceCount;)
+    {
+        if (mDirty[first] == 0)
+        {
+            ++first;
+            continue;
+        }
+
+        int last = first;
+
+        while (last + 1 < mInstanceCount && mDirty[last + 1])
+        {
+            ++last;
+        }
+
+        const int count = last - first + 1;
+        std::copy(mInstances.begin() + first, mInstances.begin() + last + 1, staging + staged);
+        std::fill(mDirty.begin() + first, mDirty.begin() + last + 1, 0);
+        mRingBuffer->Copy(stagingOffset + staged * sizeof(Instance), mInstanceBuffer, first * sizeof(Instance), count * sizeof(Instance));
+
+        staged += count;
+        first = last + 1;
+    }
+}
+
+void BSplineRenderer::KnotRenderer::Grow(int capacity)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+
+    if (buffer == 0)
+    {
+        BR_EXIT_FAILURE("KnotRenderer::Grow: OpenGL handle could not be created! Capacity = {}", capacity);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_DYNAMIC_DRAW);
+    glDeleteBuffers(1, &mInstanceBuffer);
+
+    LOG_DEBUG("KnotRenderer::Grow: Instance capacity {} -> {}", mCapacity, capacity);
+
+    glBindVertexArray(mVertexArray);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*) offsetof(Instance, position));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(3, 1, GL_INT, sizeof(Instance), (void*) offsetof(Instance, state));
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(3);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The new buffer is empty, every instance is uploaded again
+    mInstanceBuffer = buffer;
+    mInstances.resize(capacity);
+    mDirty.assign(capacity, 1);
+    mCapacity = capacity;
+}
+
+BSplineRenderer::KnotRenderer::Instance BSplineRenderer::KnotRenderer::MakeInstance(const Spline& curve, const Knot& knot, State state)
+{
+    const QVector3D position = curve.MapToWorld(knot.GetPosition());
+    return Instance{ { position.x(), position.y(), position.z() }, KNOT_SCALE * curve.GetRadius(), state, { 0, 0, 0 } };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Curve/Spline.h"
+#include "Renderer/Base/RingBuffer.h"
+#include "Renderer/Base/Shader.h"
+#include "Util/Macros.h"
+
+#include <QMatrix4x4>
+#include <QOpenGLFunctions_4_5_Core>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // The knots of the selected curve, and the knot under the mouse if it belongs to another curve, as
+    // instances of one sphere mesh drawn with a single instanced call. The position, scale and highlight
+    // state of every knot are mirrored on the CPU and only the instances that differ from the mirror are
+    // uploaded: moving a few knots uploads those knots, selecting or hovering a knot uploads one or two
+    // instances. Everything is uploaded again when the curve or its knot count changes. The same
+    // instances are drawn either as sphere meshes or as ray cast impostors on screen aligned quads.
+    class KnotRenderer : protected QOpenGLFunctions_4_5_Core
+    {
+        DISABLE_COPY(KnotRenderer);
+
+      public:
+        KnotRenderer() = default;
+        ~KnotRenderer();
+
+        void Initialize();
+
+        // The curve may be null, knotAround may belong to any curve. The curves must be up to date.
+        void Render(SplinePtr curve, KnotPtr selectedKnot, KnotPtr knotAround, SplinePtr knotAroundCurve, bool impostors);
+
+        void SetRingBuffer(RingBuffer* ringBuffer) { mRingBuffer = ringBuffer; }
+
+        // Matches the constants in Knot.vert and Knot.frag
+        enum State : GLint
+        {
+            NORMAL = 0,
+            AROUND = 1,
+            SELECTED = 2,
+        };
+
+        // Radius of a knot relative to the radius of its curve, and of a highlighted knot relative to
+        // the others. The highlight scale is applied in the shaders.
+        static constexpr float KNOT_SCALE = 2.0f;
+        static constexpr float HIGHLIGHT_SCALE = 1.25f;
+
+      private:
+        struct Instance
+        {
+            float position[3];
+            float scale;
+            GLint state;
+            GLint padding[3];
+        };
+
+        void UpdateInstances(const SplinePtr& curve, const KnotPtr& selectedKnot, const KnotPtr& knotAround, const SplinePtr& knotAroundCurve);
+        void SetInstance(int index, const Instance& instance);
+        void SetState(int index);
+        State GetState(int index) const;
+        void Upload();
+        void Grow(int count);
+
+        static Instance MakeInstance(const Spline& curve, const Knot& knot, State state);
+
+        Shader* mShader;
+        Shader* mImpostorShader;
+
+        // Uniform locations, looked up once the shaders are linked
+        GLint mAmbientLocation{ -1 };
+        GLint mDiffuseLocation{ -1 };
+        GLint mImpostorAmbientLocation{ -1 };
+        GLint mImpostorDiffuseLocation{ -1 };
+        RingBuffer* mRingBuffer;
+
+        GLuint mVertexArray{ 0 };
+        GLuint mVertexBuffer{ 0 };
+        GLuint mNormalBuffer{ 0 };
+        GLuint mIndexBuffer{ 0 };
+        GLuint mInstanceBuffer{ 0 };
+        GLsizei mIndexCount{ 0 };
+
+        // Mirror of the instance buffer, the knots of the curve first and then the foreign knot around
+        std::vector<Instance> mInstances;
+        std::vector<unsigned char> mDirty;
+        int mCapacity{ 0 };
+        int mInstanceCount{ 0 };
+
+        // State of the curve as of the last Render()
+        unsigned long long mCurveId{ 0 };
+        unsigned long long mVersion{ 0 };
+        QMatrix4x4 mModelMatrix;
+        float mRadius{ 0.0f };
+        int mKnotCount{ 0 };
+
+        KnotPtr mSelectedKnot{ nullptr };
+        KnotPtr mKnotAround{ nullptr };
+        int mSelectedIndex{ -1 };
+        int mAroundIndex{ -1 };
+    };
+}
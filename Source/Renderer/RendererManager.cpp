@@ -1,7 +1,28 @@
 #include "RendererManager.h"
 
 #include "Core/CurveContainer.h"
+#include "Renderer/KnotRenderer.h"
+#include "Renderer/SplineBufferCache.h"
 #include "Renderer/SplineRenderer.h"
+#include "Renderer/TubeMeshCache.h"
+#include "Util/JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Staging memory per frame in flight, grows if a frame uploads more
+    constexpr GLsizeiptr UPLOAD_REGION_SIZE = 8 << 20;
+
+    // Tubes thinner than this are drawn as capsules, a few pixels do not show the tessellation anyway
+    constexpr float TUBE_IMPOSTOR_PIXEL_RADIUS = 3.0f;
+
+    // Larger knots are drawn as meshes, an impostor that large costs more in fragments than the mesh in vertices
+    constexpr float KNOT_IMPOSTOR_PIXEL_RADIUS = 64.0f;
+
+    constexpr int CURVES_PER_JOB = 64;
+}
 
 BSplineRenderer::RendererManager::RendererManager()
 {
@@ -13,34 +34,74 @@ BSplineRenderer::RendererManager::RendererManager()
 
     mSplineRenderer = new SplineRenderer;
     mCurveSelectionRenderer = new CurveSelectionRenderer;
+    mKnotRenderer = new KnotRenderer;
+    mCurveCuller = new CurveCuller;
 }
 
 void BSplineRenderer::RendererManager::Initialize()
 {
     initializeOpenGLFunctions();
 
-    mSplineRenderer->SetCamera(mCamera);
-    mSplineRenderer->SetLight(mLight);
+    mRingBuffer = new RingBuffer(UPLOAD_REGION_SIZE);
+
+    mTubeMeshCache = new TubeMeshCache;
+    mTubeMeshCache->SetRingBuffer(mRingBuffer);
+
+    mSplineBufferCache = new SplineBufferCache;
+    mSplineBufferCache->SetRingBuffer(mRingBuffer);
+
+    // Bound once, every shader reads the camera and the light from it
+    glGenBuffers(1, &mFrameDataBuffer);
+
+    if (mFrameDataBuffer == 0)
+    {
+        BR_EXIT_FAILURE("RendererManager::Initialize: OpenGL handle could not be created!");
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, mFrameDataBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, mFrameDataBuffer);
+
+    const QString frameData = QString(FRAME_DATA_DECLARATION).arg(FRAME_DATA_BINDING);
+    const QString curveData = QString(SplineBufferCache::CURVE_DATA_DECLARATION).arg(SplineBufferCache::CURVE_DATA_BINDING);
+    Shader::SetPrelude((frameData + curveData).toUtf8());
+
     mSplineRenderer->SetCurveContainer(mCurveContainer);
+    mSplineRenderer->SetTubeMeshCache(mTubeMeshCache);
+    mSplineRenderer->SetSplineBufferCache(mSplineBufferCache);
+    mSplineRenderer->SetCurveCuller(mCurveCuller);
     mSplineRenderer->Initialize();
 
-    mCurveSelectionRenderer->SetCamera(mCamera);
     mCurveSelectionRenderer->SetCurveContainer(mCurveContainer);
+    mCurveSelectionRenderer->SetTubeMeshCache(mTubeMeshCache);
+    mCurveSelectionRenderer->SetSplineBufferCache(mSplineBufferCache);
+    mCurveSelectionRenderer->SetCurveCuller(mCurveCuller);
     mCurveSelectionRenderer->Initialize();
 
+    mKnotRenderer->SetRingBuffer(mRingBuffer);
+    mKnotRenderer->Initialize();
+
     mModelShader = new Shader("Model Shader");
     mModelShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/Model.vert");
     mModelShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Model.frag");
     mModelShader->Initialize();
 
+    mModelMatrixLocation = mModelShader->GetUniformLocation("modelMatrix");
+    mNormalMatrixLocation = mModelShader->GetUniformLocation("normalMatrix");
+    mModelColorLocation = mModelShader->GetUniformLocation("model.color");
+    mModelAmbientLocation = mModelShader->GetUniformLocation("model.ambient");
+    mModelDiffuseLocation = mModelShader->GetUniformLocation("model.diffuse");
+
     mSkyBoxShader = new Shader("SkyBox Shader");
     mSkyBoxShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/SkyBox.vert");
     mSkyBoxShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/SkyBox.frag");
     mSkyBoxShader->Initialize();
 
-    mSkyBox = std::make_shared<SkyBox>("Resources/SkyBox", ".png");
+    mSkyBoxLocation = mSkyBoxShader->GetUniformLocation("skybox");
+    mSkyBoxBrightnessLocation = mSkyBoxShader->GetUniformLocation("brightness");
 
-    mSphereModel = new Model(std::make_shared<Sphere>());
+    mSkyBox = std::make_shared<SkyBox>("Resources/SkyBox", ".png");
 
     Resize(INITIAL_WIDTH, INITIAL_HEIGHT);
 }
@@ -54,51 +115,108 @@ void BSplineRenderer::RendererManager::Render()
 {
     mLight->SetDirection(mCamera->GetViewDirection());
 
+    // Knots of the other curves are only shown when the mouse is near them
+    const SplinePtr knotAroundCurve = mKnotAround ? mKnotAroundCurve : nullptr;
+    ResolveCurveIndex(mSelectedCurve, mSelectedCurveIndex);
+    ResolveCurveIndex(knotAroundCurve, mKnotAroundCurveIndex);
+    ResolveCurveIndex(mHoveredCurve, mHoveredCurveIndex);
+
+    mRingBuffer->BeginFrame();
+    UpdateFrameData();
+    mTubeMeshCache->Upload();
+
+    // The patches are only drawn if the tubes are tessellated on the GPU
+    if (mSplineRenderer->GetCpuTubeMesh() == false)
+    {
+        mSplineBufferCache->UpdatePatches(mCurveContainer->GetCurves());
+    }
+
+    mSplineBufferCache->UpdateCurveData(mCurveContainer->GetCurves());
+
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(0, 0, mCamera->GetWidth(), mCamera->GetHeight());
     glClearColor(0, 0, 0, 1);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     mSkyBoxShader->Bind();
-    mSkyBoxShader->SetUniformValue("rotation", mCamera->GetRotationMatrix());
-    mSkyBoxShader->SetUniformValue("projection", mCamera->GetProjectionMatrix());
-    mSkyBoxShader->SetUniformValue("skybox", 0);
-    mSkyBoxShader->SetUniformValue("brightness", mSkyBox->GetBrightness());
+    mSkyBoxShader->SetUniformValue(mSkyBoxLocation, 0);
+    mSkyBoxShader->SetUniformValue(mSkyBoxBrightnessLocation, mSkyBox->GetBrightness());
     mSkyBox->Render();
     mSkyBoxShader->Release();
 
     mModelShader->Bind();
-    mModelShader->SetUniformValue("viewProjectionMatrix", mCamera->GetProjectionMatrix() * mCamera->GetViewMatrix());
-    mModelShader->SetUniformValue("light.color", mLight->GetColor());
-    mModelShader->SetUniformValue("light.direction", mLight->GetDirection());
-    mModelShader->SetUniformValue("light.ambient", mLight->GetAmbient());
-    mModelShader->SetUniformValue("light.diffuse", mLight->GetDiffuse());
 
     for (const auto& model : mModels)
     {
-        mModelShader->SetUniformValue("modelMatrix", model->GetTransformation());
-        mModelShader->SetUniformValue("normalMatrix", model->GetTransformation().normalMatrix());
-        mModelShader->SetUniformValue("model.color", model->GetColor());
-        mModelShader->SetUniformValue("model.ambient", model->GetAmbient());
-        mModelShader->SetUniformValue("model.diffuse", model->GetDiffuse());
+        mModelShader->SetUniformValue(mModelMatrixLocation, model->GetTransformation());
+        mModelShader->SetUniformValue(mNormalMatrixLocation, model->GetTransformation().normalMatrix());
+        mModelShader->SetUniformValue(mModelColorLocation, model->GetColor());
+        mModelShader->SetUniformValue(mModelAmbientLocation, model->GetAmbient());
+        mModelShader->SetUniformValue(mModelDiffuseLocation, model->GetDiffuse());
         model->GetMesh()->Render();
     }
 
     mModelShader->Release();
 
-    if (mSelectedCurve)
+    const float knotPixelRadius = KnotRenderer::KNOT_SCALE * KnotRenderer::HIGHLIGHT_SCALE * std::max(GetPixelRadius(mSelectedCurveIndex), GetPixelRadius(mKnotAroundCurveIndex));
+    mKnotRenderer->Render(mSelectedCurve, mSelectedKnot, mKnotAround, mKnotAroundCurve, mImpostors && knotPixelRadius < KNOT_IMPOSTOR_PIXEL_RADIUS);
+
+    mSplineRenderer->Render();
+
+    mRingBuffer->EndFrame();
+}
+
+void BSplineRenderer::RendererManager::Cull(const QMatrix4x4& viewProjection)
+{
+    // The second row of the view projection is the vertical projection scale times a unit vector
+    const float projectionScale = QVector3D(viewProjection(1, 0), viewProjection(1, 1), viewProjection(1, 2)).length();
+    const float pixelScale = 0.5f * mCamera->GetHeight() * projectionScale;
+
+    // The capsules are cast along the patches of the GPU path
+    const bool impostors = mImpostors && mSplineRenderer->GetCpuTubeMesh() == false;
+
+    mCurveCuller->Cull(mCurveContainer->GetCurves(), viewProjection, pixelScale, impostors ? TUBE_IMPOSTOR_PIXEL_RADIUS : 0.0f);
+}
+
+void BSplineRenderer::RendererManager::UpdateFrames()
+{
+    const auto& curves = mCurveContainer->GetCurves();
+
+    JobSystem::Instance().ParallelFor(curves.size(), CURVES_PER_JOB, [this, &curves](int first, int count) {
+        for (int i = first; i < first + count; ++i)
+        {
+            const bool tube = mCurveCuller->IsVisible(i) && mCurveCuller->IsImpostor(i) == false;
+            curves[i]->SetFramesDeferred(tube == false);
+
+            if (tube)
+            {
+                curves[i]->UpdateStaleFrames();
+            }
+        }
+    });
+}
+
+void BSplineRenderer::RendererManager::BuildTubeMeshes()
+{
+    if (mSplineRenderer->GetCpuTubeMesh())
     {
-        RenderKnots(mSelectedCurve);
+        mTubeMeshCache->Build(mCurveContainer->GetCurves(), mSplineRenderer->GetNumberOfSegments(), mSplineRenderer->GetNumberOfSectors());
     }
+}
 
-    mSplineRenderer->Render();
-    mCurveSelectionRenderer->Render();
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+std::future<BSplineRenderer::CurveQueryInfo> BSplineRenderer::RendererManager::Query(const QPoint& queryPoint)
+{
+    std::future<CurveQueryInfo> info = mCurveSelectionRenderer->Query(queryPoint);
+
+    // The draw commands of the query were staged after the frame's fence
+    mRingBuffer->EndFrame();
+
+    return info;
 }
 
-BSplineRenderer::CurveQueryInfo BSplineRenderer::RendererManager::Query(const QPoint& queryPoint)
+void BSplineRenderer::RendererManager::ResolveQueries()
 {
-    return mCurveSelectionRenderer->Query(queryPoint);
+    mCurveSelectionRenderer->Poll();
 }
 
 void BSplineRenderer::RendererManager::AddModel(ModelPtr model)
@@ -138,40 +256,101 @@ bool* BSplineRenderer::RendererManager::GetWireframe()
     return &mSplineRenderer->GetWireframe_NonConst();
 }
 
-void BSplineRenderer::RendererManager::RenderKnots(SplinePtr curve)
+void BSplineRenderer::RendererManager::SetCpuTubeMesh(bool enabled)
 {
-    const auto& knots = curve->GetKnots();
-    const float r = curve->GetRadius();
+    mSplineRenderer->SetCpuTubeMesh(enabled);
+    mCurveSelectionRenderer->SetCpuTubeMesh(enabled);
+}
 
-    mModelShader->Bind();
-    mModelShader->SetUniformValue("model.ambient", mSphereModel->GetAmbient());
-    mModelShader->SetUniformValue("model.diffuse", mSphereModel->GetDiffuse());
+bool BSplineRenderer::RendererManager::GetCpuTubeMesh() const
+{
+    return mSplineRenderer->GetCpuTubeMesh();
+}
+
+int BSplineRenderer::RendererManager::GetTubeMeshRebuildCount() const
+{
+    return mTubeMeshCache->GetRebuildCount();
+}
+
+int BSplineRenderer::RendererManager::GetVisibleCurveCount() const
+{
+    return mCurveCuller->GetVisibleCount();
+}
+
+int BSplineRenderer::RendererManager::GetImpostorCurveCount() const
+{
+    return mCurveCuller->GetImpostorCount();
+}
 
-    for (const auto& knot : knots)
+void BSplineRenderer::RendererManager::UpdateFrameData()
+{
+    FrameData data;
+    std::memcpy(data.viewProjectionMatrix, mCamera->GetViewProjectionMatrix().constData(), sizeof(data.viewProjectionMatrix));
+    std::memcpy(data.projectionMatrix, mCamera->GetProjectionMatrix().constData(), sizeof(data.projectionMatrix));
+    std::memcpy(data.rotationMatrix, mCamera->GetRotationMatrix().constData(), sizeof(data.rotationMatrix));
+
+    const QVector4D& color = mLight->GetColor();
+    const QVector3D& direction = mLight->GetDirection();
+
+    for (int i = 0; i < 4; ++i)
     {
-        if (mSelectedKnot == knot)
-        {
-            mSphereModel->SetColor(QVector4D(0, 1, 0, 1));
-            mSphereModel->SetScale(2.5 * r, 2.5 * r, 2.5 * r);
-        }
-        else if (mKnotAround == knot)
-        {
-            mSphereModel->SetColor(QVector4D(1, 1, 0, 1));
-            mSphereModel->SetScale(2.5 * r, 2.5 * r, 2.5 * r);
-        }
-        else
-        {
-            mSphereModel->SetColor(QVector4D(1, 1, 0, 1));
-            mSphereModel->SetScale(2 * r, 2 * r, 2 * r);
-        }
+        data.lightColor[i] = color[i];
+    }
 
-        mSphereModel->SetPosition(knot->GetPosition());
-        mModelShader->SetUniformValue("modelMatrix", mSphereModel->GetTransformation());
-        mModelShader->SetUniformValue("normalMatrix", mSphereModel->GetTransformation().normalMatrix());
-        mModelShader->SetUniformValue("model.color", mSphereModel->GetColor());
+    for (int i = 0; i < 3; ++i)
+    {
+        data.lightDirection[i] = direction[i];
+    }
 
-        mSphereModel->GetMesh()->Render();
+    data.lightAmbient = mLight->GetAmbient();
+    data.lightDiffuse = mLight->GetDiffuse();
+    std::fill(std::begin(data.padding), std::end(data.padding), 0.0f);
+    data.hoveredCurve = mHoveredCurveIndex;
+    std::fill(std::begin(data.unused), std::end(data.unused), 0);
+
+    // The impostors unproject their quads into view rays with it
+    std::memcpy(data.inverseViewProjectionMatrix, mCamera->GetViewProjectionMatrix().inverted().constData(), sizeof(data.inverseViewProjectionMatrix));
+
+    GLintptr offset = 0;
+    std::memcpy(mRingBuffer->Map(sizeof(FrameData), offset), &data, sizeof(FrameData));
+    mRingBuffer->Copy(offset, mFrameDataBuffer, 0, sizeof(FrameData));
+}
+
+long long BSplineRenderer::RendererManager::GetUploadedBytes() const
+{
+    return mRingBuffer->GetFrameBytes();
+}
+
+double BSplineRenderer::RendererManager::GetUploadStallTime() const
+{
+    return mRingBuffer->GetStallTime();
+}
+
+double BSplineRenderer::RendererManager::GetReadbackLatency() const
+{
+    return mCurveSelectionRenderer->GetReadbackLatency();
+}
+
+double BSplineRenderer::RendererManager::GetReadbackStallTime() const
+{
+    return mCurveSelectionRenderer->GetReadbackStallTime();
+}
+
+void BSplineRenderer::RendererManager::ResolveCurveIndex(const SplinePtr& curve, int& index) const
+{
+    const auto& curves = mCurveContainer->GetCurves();
+
+    if (curve == nullptr)
+    {
+        index = -1;
+    }
+    else if (index < 0 || index >= curves.size() || curves[index] != curve)
+    {
+        index = curves.indexOf(curve);
     }
+}
 
-    mModelShader->Release();
+float BSplineRenderer::RendererManager::GetPixelRadius(int index) const
+{
+    return index >= 0 ? mCurveCuller->GetPixelRadius(index) : 0.0f;
 }
@@ -4,10 +4,11 @@
 #include "Node/Camera/FreeCamera.h"
 #include "Node/Light/DirectionalLight.h"
 #include "Node/Mesh/Plane.h"
-#include "Node/Mesh/Sphere.h"
 #include "Node/Model/Model.h"
 #include "Node/SkyBox/SkyBox.h"
+#include "Renderer/Base/RingBuffer.h"
 #include "Renderer/Base/Shader.h"
+#include "Renderer/CurveCuller.h"
 #include "Renderer/CurveSelectionRenderer.h"
 
 #include <QMap>
@@ -19,7 +20,10 @@ namespace BSplineRenderer
 {
 
     class CurveContainer;
+    class KnotRenderer;
     class SplineRenderer;
+    class TubeMeshCache;
+    class SplineBufferCache;
 
     class RendererManager : protected QOpenGLFunctions_4_5_Core
     {
@@ -28,9 +32,21 @@ namespace BSplineRenderer
 
         void Initialize();
         void Resize(int width, int height);
+
+        // Draws the curves culled and the tube meshes built since the last frame, the curves must be up to date
         void Render();
 
-        CurveQueryInfo Query(const QPoint& queryPoint);
+        // CPU side of a frame, no OpenGL calls. Both may run on any thread in parallel to each other, but not to Render().
+        void Cull(const QMatrix4x4& viewProjection);
+        void BuildTubeMeshes();
+
+        // Only curves drawn as tubes need frames. After Cull(), defers the frames of the other curves from the
+        // next solve on and brings those of the tubes up to date. Must not run in parallel to readers of the curves.
+        void UpdateFrames();
+
+        // The curve under the point as of the last frame, resolved by a ResolveQueries() of a later frame
+        std::future<CurveQueryInfo> Query(const QPoint& queryPoint);
+        void ResolveQueries();
 
         void AddModel(ModelPtr model);
         void RemoveModel(ModelPtr model);
@@ -46,16 +62,95 @@ namespace BSplineRenderer
 
         bool* GetWireframe();
 
+        void SetCpuTubeMesh(bool enabled);
+        bool GetCpuTubeMesh() const;
+        int GetTubeMeshRebuildCount() const;
+        int GetVisibleCurveCount() const;
+
+        // Curves and knots small on screen are drawn as ray cast impostors instead of meshes
+        void SetImpostors(bool enabled) { mImpostors = enabled; }
+        bool GetImpostors() const { return mImpostors; }
+        int GetImpostorCurveCount() const;
+
+        // Bytes staged for upload in the last frame and the time waited for the GPU to release the staging memory
+        long long GetUploadedBytes() const;
+        double GetUploadStallTime() const;
+
+        // Time until the last query was resolved and the time the last query waited for a free read slot
+        double GetReadbackLatency() const;
+        double GetReadbackStallTime() const;
+
+        // Binding of the FrameData uniform block in every shader
+        static constexpr GLuint FRAME_DATA_BINDING = 0;
+
       public slots:
         void SetSelectedCurve(SplinePtr spline) { mSelectedCurve = spline; }
         void SetSelectedKnot(KnotPtr knot) { mSelectedKnot = knot; }
-        void SetKnotAround(KnotPtr knot) { mKnotAround = knot; }
+        void SetKnotAround(KnotPtr knot, SplinePtr curve)
+        {
+            mKnotAround = knot;
+            mKnotAroundCurve = curve;
+        }
+        void SetHoveredCurve(SplinePtr spline) { mHoveredCurve = spline; }
 
       private:
-        void RenderKnots(SplinePtr curve);
+        // std140 layout of FrameData in the shaders
+        struct FrameData
+        {
+            float viewProjectionMatrix[16];
+            float projectionMatrix[16];
+            float rotationMatrix[16];
+            float lightColor[4];
+            float lightDirection[3];
+            float lightAmbient;
+            float lightDiffuse;
+            float padding[3];
+            int hoveredCurve;
+            int unused[3];
+            float inverseViewProjectionMatrix[16];
+        };
+
+        // FrameData in GLSL, added to every shader by Shader::SetPrelude(). %1 is FRAME_DATA_BINDING.
+        static constexpr const char* FRAME_DATA_DECLARATION = R"(
+struct Light
+{
+    vec4 color;
+    vec3 direction;
+    float ambient;
+    float diffuse;
+};
+
+layout(std140, binding = %1) uniform FrameData
+{
+    mat4 viewProjectionMatrix;
+    mat4 projectionMatrix;
+    mat4 rotationMatrix;
+    Light light;
+    int hoveredCurve;
+    mat4 inverseViewProjectionMatrix;
+};
+)";
+
+        void UpdateFrameData();
+
+        // Index of the curve in the container, the cached index is only searched again once it no longer points at the curve
+        void ResolveCurveIndex(const SplinePtr& curve, int& index) const;
+
+        // Tube radius of the curve at the index in pixels as of the last Cull()
+        float GetPixelRadius(int index) const;
 
         Shader* mModelShader;
         Shader* mSkyBoxShader;
+
+        // Uniform locations, looked up once the shaders are linked
+        GLint mModelMatrixLocation{ -1 };
+        GLint mNormalMatrixLocation{ -1 };
+        GLint mModelColorLocation{ -1 };
+        GLint mModelAmbientLocation{ -1 };
+        GLint mModelDiffuseLocation{ -1 };
+        GLint mSkyBoxLocation{ -1 };
+        GLint mSkyBoxBrightnessLocation{ -1 };
+
         CurveContainer* mCurveContainer;
         FreeCameraPtr mCamera;
         DirectionalLightPtr mLight;
@@ -63,13 +158,27 @@ namespace BSplineRenderer
         QVector<ModelPtr> mModels;
 
         SkyBoxPtr mSkyBox;
-        Model* mSphereModel;
 
         SplineRenderer* mSplineRenderer;
         CurveSelectionRenderer* mCurveSelectionRenderer;
+        KnotRenderer* mKnotRenderer;
+        TubeMeshCache* mTubeMeshCache;
+        SplineBufferCache* mSplineBufferCache;
+        CurveCuller* mCurveCuller;
+        RingBuffer* mRingBuffer;
+        GLuint mFrameDataBuffer{ 0 };
 
         SplinePtr mSelectedCurve{ nullptr };
         KnotPtr mSelectedKnot{ nullptr };
         KnotPtr mKnotAround{ nullptr };
+        SplinePtr mKnotAroundCurve{ nullptr };
+        SplinePtr mHoveredCurve{ nullptr };
+
+        // Indices of the curves above, resolved once per frame
+        int mSelectedCurveIndex{ -1 };
+        int mKnotAroundCurveIndex{ -1 };
+        int mHoveredCurveIndex{ -1 };
+
+        bool mImpostors{ true };
     };
 }
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include "SplineBufferCache.h"
+
+#include "Util/JobSystem.h"
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+    constexpr int INITIAL_VERTEX_CAPACITY = 1 << 16;
+    constexpr int INITIAL_CURVE_CAPACITY = 256;
+    constexpr int CURVES_PER_JOB = 256;
+}
+
+BSplineRenderer::SplineBufferCache::SplineBufferCache()
+{
+    initializeOpenGLFunctions();
+
+    glGenVertexArrays(1, &mVertexArray);
+    glGenVertexArrays(1, &mImpostorVertexArray);
+
+    if (mVertexArray == 0 || mImpostorVertexArray == 0)
+    {
+        BR_EXIT_FAILURE("SplineBufferCache::SplineBufferCache: OpenGL handle(s) could not be created!");
+    }
+
+    GrowVertexBuffer(INITIAL_VERTEX_CAPACITY);
+    GrowCurveBuffers(INITIAL_CURVE_CAPACITY);
+
+    glPatchParameteri(GL_PATCH_VERTICES, Spline::NUM_OF_PATCH_POINTS);
+}
+
+BSplineRenderer::SplineBufferCache::~SplineBufferCache()
+{
+    glDeleteVertexArrays(1, &mVertexArray);
+    glDeleteVertexArrays(1, &mImpostorVertexArray);
+    glDeleteBuffers(1, &mVertexBuffer);
+    glDeleteBuffers(1, &mCurveIndexBuffer);
+    glDeleteBuffers(1, &mCurveDataBuffer);
+}
+
+void BSplineRenderer::SplineBufferCache::UpdatePatches(const QVector<SplinePtr>& curves)
+{
+    struct Upload
+    {
+        Spline* curve;
+        int firstPoint;
+        int count;
+        int offset;
+        int stagingOffset;
+    };
+
+    for (auto& [id, entry] : mEntries)
+    {
+        entry.alive = false;
+    }
+
+    // Removed curves first so that their ranges can be reused
+    for (const auto& curve : curves)
+    {
+        const auto it = mEntries.find(curve->GetId());
+
+        if (it != mEntries.end())
+        {
+            it->second.alive = true;
+        }
+    }
+
+    for (auto it = mEntries.begin(); it != mEntries.end();)
+    {
+        if (it->second.alive == false)
+        {
+            mArena.Free(it->second.offset, it->second.capacity);
+            it = mEntries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    QVector<Upload> uploads;
+    int stagingSize = 0;
+
+    for (const auto& curve : curves)
+    {
+        Entry& entry = mEntries[curve->GetId()];
+        entry.alive = true;
+
+        const int pointCount = curve->GetBezierControlPoints().size();
+
+        if (pointCount > entry.capacity)
+        {
+            Reserve(entry, pointCount);
+
+            uploads << Upload{ curve.get(), 0, pointCount, entry.offset, stagingSize };
+            stagingSize += pointCount;
+        }
+        else if (entry.version != curve->GetVersion())
+        {
+            int firstPatch = 0;
+            int lastPatch = -1;
+            curve->GetChangedPatches(entry.version, firstPatch, lastPatch);
+
+            // A new knot count marks every patch as changed, so the range also covers a resized curve
+            if (firstPatch <= lastPatch)
+            {
+                const int first = Spline::NUM_OF_PATCH_POINTS * firstPatch;
+                const int count = Spline::NUM_OF_PATCH_POINTS * (lastPatch - firstPatch + 1);
+
+                uploads << Upload{ curve.get(), first, count, entry.offset + first, stagingSize };
+                stagingSize += count;
+            }
+        }
+
+        entry.version = curve->GetVersion();
+        entry.pointCount = pointCount;
+    }
+
+    if (uploads.isEmpty())
+    {
+        return;
+    }
+
+    GLintptr stagingOffset = 0;
+    PatchVertex* staging = reinterpret_cast<PatchVertex*>(mRingBuffer->Map(stagingSize * sizeof(PatchVertex), stagingOffset));
+
+    JobSystem::Instance().Map(uploads, [staging](const Upload& upload) {
+        const QVector3D* controlPoints = upload.curve->GetBezierControlPoints().constData() + upload.firstPoint;
+        const QVector3D* normals = upload.curve->GetFrameNormals().constData() + upload.firstPoint;
+        PatchVertex* vertices = staging + upload.stagingOffset;
+
+        for (int i = 0; i < upload.count; ++i)
+        {
+            vertices[i] = PatchVertex{ controlPoints[i], normals[i] };
+        }
+    });
+
+    // Curves next to each other in the arena are usually next to each other in the container too
+    int first = 0;
+
+    for (int i = 0; i < uploads.size(); ++i)
+    {
+        const bool last = i + 1 == uploads.size();
+
+        if (last || uploads[i + 1].offset != uploads[i].offset + uploads[i].count)
+        {
+            const int count = uploads[i].stagingOffset + uploads[i].count - uploads[first].stagingOffset;
+            mRingBuffer->Copy(stagingOffset + uploads[first].stagingOffset * sizeof(PatchVertex), mVertexBuffer, uploads[first].offset * sizeof(PatchVertex), count * sizeof(PatchVertex));
+            first = i + 1;
+        }
+    }
+}
+
+void BSplineRenderer::SplineBufferCache::UpdateCurveData(const QVector<SplinePtr>& curves)
+{
+    const int count = curves.size();
+
+    if (count > mCurveCapacity)
+    {
+        GrowCurveBuffers(std::max(2 * mCurveCapacity, count));
+    }
+
+    mCurveData.resize(count);
+
+    JobSystem::Instance().ParallelFor(count, CURVES_PER_JOB, [this, &curves](int first, int size) {
+        for (int index = first; index < first + size; ++index)
+        {
+            const Spline& curve = *curves[index];
+            const QMatrix3x3 normalMatrix = curve.GetModelMatrix().normalMatrix();
+
+            CurveData& data = mCurveData[index];
+            std::memcpy(data.modelMatrix, curve.GetModelMatrix().constData(), sizeof(data.modelMatrix));
+            std::fill(std::begin(data.normalMatrix), std::end(data.normalMatrix), 0.0f);
+
+            // Column major like the model matrix
+            for (int column = 0; column < 3; ++column)
+            {
+                for (int row = 0; row < 3; ++row)
+                {
+                    data.normalMatrix[4 * column + row] = normalMatrix(row, column);
+                }
+            }
+
+            data.normalMatrix[15] = 1.0f;
+
+            const QVector4D& color = curve.GetColor();
+            data.color[0] = color.x();
+            data.color[1] = color.y();
+            data.color[2] = color.z();
+            data.color[3] = color.w();
+            data.ambient = curve.GetAmbient();
+            data.diffuse = curve.GetDiffuse();
+            data.radius = curve.GetRadius();
+            data.padding = 0.0f;
+        }
+    });
+
+    // Only the span between the first and the last changed curve is uploaded, usually none or all of them
+    const int uploaded = std::min<int>(count, mUploadedCurveData.size());
+    int first = uploaded;
+    int last = count - 1;
+
+    for (int index = 0; index < uploaded; ++index)
+    {
+        if (std::memcmp(&mCurveData[index], &mUploadedCurveData[index], sizeof(CurveData)) != 0)
+        {
+            first = index;
+            break;
+        }
+    }
+
+    if (count == uploaded)
+    {
+        while (last >= first && std::memcmp(&mCurveData[last], &mUploadedCurveData[last], sizeof(CurveData)) == 0)
+        {
+            --last;
+        }
+    }
+
+    if (first <= last)
+    {
+        const GLsizeiptr size = (last - first + 1) * sizeof(CurveData);
+        GLintptr offset = 0;
+        std::memcpy(mRingBuffer->Map(size, offset), mCurveData.data() + first, size);
+        mRingBuffer->Copy(offset, mCurveDataBuffer, first * sizeof(CurveData), size);
+    }
+
+    std::swap(mCurveData, mUploadedCurveData);
+}
+
+void BSplineRenderer::SplineBufferCache::Draw(const QVector<SplinePtr>& curves, const CurveCuller& culler)
+{
+    mDrawCommands.clear();
+
+    for (int index = 0; index < curves.size(); ++index)
+    {
+        const auto it = mEntries.find(curves[index]->GetId());
+
+        if (it == mEntries.end() || it->second.pointCount == 0 || culler.IsVisible(index) == false || culler.IsImpostor(index))
+        {
+            continue;
+        }
+
+        mDrawCommands.push_back(DrawCommand{ GLuint(it->second.pointCount), 1, GLuint(it->second.offset), GLuint(index) });
+    }
+
+    MultiDraw(mVertexArray, GL_PATCHES);
+}
+
+void BSplineRenderer::SplineBufferCache::DrawImpostors(const QVector<SplinePtr>& curves, const CurveCuller& culler)
+{
+    constexpr int VERTICES_PER_PATCH = 6 * CAPSULES_PER_PATCH;
+
+    mDrawCommands.clear();
+
+    for (int index = 0; index < curves.size(); ++index)
+    {
+        if (culler.IsImpostor(index) == false)
+        {
+            continue;
+        }
+
+        const auto it = mEntries.find(curves[index]->GetId());
+
+        if (it == mEntries.end() || it->second.pointCount == 0)
+        {
+            continue;
+        }
+
+        // The ranges start at a patch boundary, so gl_VertexID / VERTICES_PER_PATCH is the patch in the buffer
+        const int patchCount = it->second.pointCount / Spline::NUM_OF_PATCH_POINTS;
+        const int firstPatch = it->second.offset / Spline::NUM_OF_PATCH_POINTS;
+        mDrawCommands.push_back(DrawCommand{ GLuint(VERTICES_PER_PATCH * patchCount), 1, GLuint(VERTICES_PER_PATCH * firstPatch), GLuint(index) });
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PATCH_BINDING, mVertexBuffer);
+
+    MultiDraw(mImpostorVertexArray, GL_TRIANGLES);
+}
+
+void BSplineRenderer::SplineBufferCache::BindCurveData()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CURVE_DATA_BINDING, mCurveDataBuffer);
+}
+
+void BSplineRenderer::SplineBufferCache::MultiDraw(GLuint vertexArray, GLenum mode)
+{
+    if (mDrawCommands.empty())
+    {
+        return;
+    }
+
+    // Read by the GPU straight from the ring buffer
+    const GLsizeiptr size = mDrawCommands.size() * sizeof(DrawCommand);
+    GLintptr offset = 0;
+    std::memcpy(mRingBuffer->Map(size, offset), mDrawCommands.data(), size);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mRingBuffer->GetBuffer());
+
+    BindCurveData();
+
+    glBindVertexArray(vertexArray);
+    glMultiDrawArraysIndirect(mode, (void*) offset, GLsizei(mDrawCommands.size()), 0);
+    glBindVertexArray(0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void BSplineRenderer::SplineBufferCache::Reserve(Entry& entry, int pointCount)
+{
+    // A quarter spare for curves that are still being extended, doubled if the curve outgrows it anyway
+    int capacity = std::max(pointCount + pointCount / 4, 2 * entry.capacity);
+    capacity = (capacity + Spline::NUM_OF_PATCH_POINTS - 1) / Spline::NUM_OF_PATCH_POINTS * Spline::NUM_OF_PATCH_POINTS;
+
+    mArena.Free(entry.offset, entry.capacity);
+    entry.offset = Allocate(capacity);
+    entry.capacity = capacity;
+}
+
+int BSplineRenderer::SplineBufferCache::Allocate(int count)
+{
+    int offset = mArena.Allocate(count);
+
+    if (offset < 0)
+    {
+        GrowVertexBuffer(std::max(2 * mArena.GetCapacity(), mArena.GetCapacity() + count));
+        offset = mArena.Allocate(count);
+    }
+
+    return offset;
+}
+
+void BSplineRenderer::SplineBufferCache::GrowVertexBuffer(int capacity)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+
+    if (buffer == 0)
+    {
+        BR_EXIT_FAILURE("SplineBufferCache::GrowVertexBuffer: OpenGL handle could not be created! Capacity = {}", capacity);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity * sizeof(PatchVertex), nullptr, GL_DYNAMIC_DRAW);
+
+    // The ranges keep their offsets, so the old contents are copied as a whole
+    if (mVertexBuffer != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, mVertexBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, mArena.GetCapacity() * sizeof(PatchVertex));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &mVertexBuffer);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    LOG_DEBUG("SplineBufferCache::GrowVertexBuffer: Vertex capacity {} -> {}", mArena.GetCapacity(), capacity);
+
+    mVertexBuffer = buffer;
+    mArena.Grow(capacity);
+
+    SetupVertexArray();
+}
+
+void BSplineRenderer::SplineBufferCache::GrowCurveBuffers(int capacity)
+{
+    if (mCurveIndexBuffer == 0)
+    {
+        glGenBuffers(1, &mCurveIndexBuffer);
+        glGenBuffers(1, &mCurveDataBuffer);
+    }
+
+    if (mCurveIndexBuffer == 0 || mCurveDataBuffer == 0)
+    {
+        BR_EXIT_FAILURE("SplineBufferCache::GrowCurveBuffers: OpenGL handle(s) could not be created! Capacity = {}", capacity);
+    }
+
+    std::vector<GLuint> indices(capacity);
+
+    for (int index = 0; index < capacity; ++index)
+    {
+        indices[index] = index;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, mCurveIndexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Reallocated empty, the next update uploads every curve
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mCurveDataBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(CurveData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    mUploadedCurveData.clear();
+
+    mCurveCapacity = capacity;
+
+    SetupVertexArray();
+}
+
+void BSplineRenderer::SplineBufferCache::SetupVertexArray()
+{
+    glBindVertexArray(mVertexArray);
+
+    if (mVertexBuffer != 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PatchVertex), (void*) offsetof(PatchVertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(PatchVertex), (void*) offsetof(PatchVertex, normal));
+        glEnableVertexAttribArray(1);
+    }
+
+    if (mCurveIndexBuffer != 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, mCurveIndexBuffer);
+        glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*) 0);
+        glVertexAttribDivisor(2, 1);
+        glEnableVertexAttribArray(2);
+
+        glBindVertexArray(mImpostorVertexArray);
+        glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*) 0);
+        glVertexAttribDivisor(2, 1);
+        glEnableVertexAttribArray(2);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
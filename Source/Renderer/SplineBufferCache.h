@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Curve/Spline.h"
+#include "Renderer/Base/ArenaAllocator.h"
+#include "Renderer/Base/RingBuffer.h"
+#include "Renderer/CurveCuller.h"
+#include "Util/Macros.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+#include <QVector>
+#include <unordered_map>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // The Bezier patches of all curves in one vertex buffer, sub-allocated per curve and keyed by the
+    // curve ID, and the model matrix and material of every curve in a shader storage buffer indexed by
+    // the curve's index in the container. The visible curves are drawn with a single indirect draw call.
+    // A curve's patches are refreshed when its version has changed, only the changed patches are uploaded
+    // if the patch count is the same. Every curve's range has spare capacity, so a curve that gains knots is
+    // updated in place, and the buffers grow geometrically. All data is staged through the RingBuffer.
+    // Curves marked as impostors by the culler are drawn by DrawImpostors() instead, as capsules along
+    // chords of their patches that are ray cast on screen aligned quads, read from the same buffers.
+    // Lives on the context thread, the curves themselves have no GL state.
+    class SplineBufferCache : protected QOpenGLFunctions_4_5_Core
+    {
+        DISABLE_COPY(SplineBufferCache);
+
+      public:
+        SplineBufferCache();
+        ~SplineBufferCache();
+
+        // Uploads the changed patches and frees the ranges of removed curves. The curves must be up to date.
+        void UpdatePatches(const QVector<SplinePtr>& curves);
+
+        // Uploads the curve data that has changed since the last call
+        void UpdateCurveData(const QVector<SplinePtr>& curves);
+
+        // Draws the patches of the visible curves with the currently bound shader, both updates must be called first
+        void Draw(const QVector<SplinePtr>& curves, const CurveCuller& culler);
+
+        // Draws CAPSULES_PER_PATCH quads of six vertices per patch of the impostor curves with the currently bound shader
+        void DrawImpostors(const QVector<SplinePtr>& curves, const CurveCuller& culler);
+
+        // For shaders reading the curve data of a single curve given by a uniform
+        void BindCurveData();
+
+        void SetRingBuffer(RingBuffer* ringBuffer) { mRingBuffer = ringBuffer; }
+
+        static constexpr GLuint CURVE_DATA_BINDING = 0;
+
+        // std430 layout of CurveData in the shaders, the normal matrix is in the upper left 3x3
+        struct CurveData
+        {
+            float modelMatrix[16];
+            float normalMatrix[16];
+            float color[4];
+            float ambient;
+            float diffuse;
+            float radius;
+            float padding;
+        };
+
+        // CurveData in GLSL, added to every shader by Shader::SetPrelude(). %1 is CURVE_DATA_BINDING.
+        static constexpr const char* CURVE_DATA_DECLARATION = R"(
+struct CurveData
+{
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+    vec4 color;
+    float ambient;
+    float diffuse;
+    float radius;
+};
+
+layout(std430, binding = %1) readonly buffer CurveDataBuffer
+{
+    CurveData curves[];
+};
+)";
+
+        // The patch vertices as a shader storage buffer for the impostors
+        static constexpr GLuint PATCH_BINDING = 1;
+
+        // Matches TubeImpostor.vert
+        static constexpr int CAPSULES_PER_PATCH = 4;
+
+      private:
+        struct PatchVertex
+        {
+            QVector3D position;
+            QVector3D normal;
+        };
+
+        struct DrawCommand
+        {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint first;
+            GLuint baseInstance;
+        };
+
+        struct Entry
+        {
+            unsigned long long version{ 0 };
+            int offset{ -1 };
+            int pointCount{ 0 };
+            int capacity{ 0 };
+
+            // Set by every UpdatePatches() for the curves passed, entries left unset belong to removed curves
+            bool alive{ false };
+        };
+
+        void Reserve(Entry& entry, int pointCount);
+        int Allocate(int count);
+        void GrowVertexBuffer(int count);
+        void GrowCurveBuffers(int count);
+        void SetupVertexArray();
+        void MultiDraw(GLuint vertexArray, GLenum mode);
+
+        std::unordered_map<unsigned long long, Entry> mEntries;
+        ArenaAllocator mArena;
+
+        GLuint mVertexArray{ 0 };
+        GLuint mVertexBuffer{ 0 };
+
+        // Only the curve index, the impostors read the patches from the storage buffer
+        GLuint mImpostorVertexArray{ 0 };
+
+        // 0, 1, 2, ... as a per instance attribute, the base instance of a draw command selects the curve index
+        GLuint mCurveIndexBuffer{ 0 };
+        GLuint mCurveDataBuffer{ 0 };
+        int mCurveCapacity{ 0 };
+
+        RingBuffer* mRingBuffer;
+
+        std::vector<CurveData> mCurveData;
+        std::vector<CurveData> mUploadedCurveData;
+        std::vector<DrawCommand> mDrawCommands;
+    };
+}
@@ -13,6 +13,21 @@ void BSplineRenderer::SplineRenderer::Initialize()
     mSplineShader->AddPath(QOpenGLShader::TessellationEvaluation, ":/Resources/Shaders/Spline.tes");
     mSplineShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Spline.frag");
     mSplineShader->Initialize();
+
+    mNumberOfSegmentsLocation = mSplineShader->GetUniformLocation("numberOfSegments");
+    mNumberOfSectorsLocation = mSplineShader->GetUniformLocation("numberOfSectors");
+
+    mTubeShader = new Shader("Tube Shader");
+    mTubeShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/Tube.vert");
+    mTubeShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Spline.frag");
+    mTubeShader->Initialize();
+
+    mCurveIndexLocation = mTubeShader->GetUniformLocation("curveIndex");
+
+    mTubeImpostorShader = new Shader("Tube Impostor Shader");
+    mTubeImpostorShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/TubeImpostor.vert");
+    mTubeImpostorShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/TubeImpostor.frag");
+    mTubeImpostorShader->Initialize();
 }
 
 void BSplineRenderer::SplineRenderer::Render()
@@ -22,34 +37,52 @@ void BSplineRenderer::SplineRenderer::Render()
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
 
-    mSplineShader->Bind();
-    mSplineShader->SetUniformValue("numberOfSegments", mNumberOfSegments);
-    mSplineShader->SetUniformValue("numberOfSectors", mNumberOfSectors);
-    mSplineShader->SetUniformValue("VP", mCamera->GetProjectionMatrix() * mCamera->GetViewMatrix());
+    Shader* shader = mCpuTubeMesh ? mTubeShader : mSplineShader;
 
-    mSplineShader->SetUniformValue("light.color", mLight->GetColor());
-    mSplineShader->SetUniformValue("light.direction", mLight->GetDirection());
-    mSplineShader->SetUniformValue("light.ambient", mLight->GetAmbient());
-    mSplineShader->SetUniformValue("light.diffuse", mLight->GetDiffuse());
+    // The camera and the light are in the frame data block, the materials in the curve data buffer
+    shader->Bind();
+
+    if (mCpuTubeMesh == false)
+    {
+        shader->SetUniformValue(mNumberOfSegmentsLocation, mNumberOfSegments);
+        shader->SetUniformValue(mNumberOfSectorsLocation, mNumberOfSectors);
+    }
 
     const auto& curves = mCurveContainer->GetCurves();
 
-    for (int index = 0; index < curves.size(); ++index)
+    if (mCpuTubeMesh)
+    {
+        mSplineBufferCache->BindCurveData();
+
+        for (int index = 0; index < curves.size(); ++index)
+        {
+            if (mCurveCuller->IsVisible(index))
+            {
+                shader->SetUniformValue(mCurveIndexLocation, index);
+                mTubeMeshCache->Render(curves[index]);
+            }
+        }
+    }
+    else
     {
-        const auto& curve = curves[index];
-        mSplineShader->SetUniformValue("curve.color", curve->GetColor());
-        mSplineShader->SetUniformValue("curve.ambient", curve->GetAmbient());
-        mSplineShader->SetUniformValue("curve.diffuse", curve->GetDiffuse());
-        mSplineShader->SetUniformValue("radius", curve->GetRadius());
-        curve->Render();
+        // All visible curves in a single indirect draw call
+        mSplineBufferCache->Draw(curves, *mCurveCuller);
     }
 
-    mSplineShader->Release();
+    shader->Release();
 
     if (mWireframe)
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     }
+
+    // Curves too small on screen to be worth tessellating, ray cast along the patches of the GPU path
+    if (mCpuTubeMesh == false && mCurveCuller->GetImpostorCount() > 0)
+    {
+        mTubeImpostorShader->Bind();
+        mSplineBufferCache->DrawImpostors(curves, *mCurveCuller);
+        mTubeImpostorShader->Release();
+    }
 }
 
 void BSplineRenderer::SplineRenderer::SetCurveContainer(CurveContainer* curveContainer)
@@ -57,12 +90,17 @@ void BSplineRenderer::SplineRenderer::SetCurveContainer(CurveContainer* curveCon
     mCurveContainer = curveContainer;
 }
 
-void BSplineRenderer::SplineRenderer::SetCamera(FreeCameraPtr camera)
+void BSplineRenderer::SplineRenderer::SetTubeMeshCache(TubeMeshCache* tubeMeshCache)
+{
+    mTubeMeshCache = tubeMeshCache;
+}
+
+void BSplineRenderer::SplineRenderer::SetSplineBufferCache(SplineBufferCache* splineBufferCache)
 {
-    mCamera = camera;
+    mSplineBufferCache = splineBufferCache;
 }
 
-void BSplineRenderer::SplineRenderer::SetLight(DirectionalLightPtr light)
+void BSplineRenderer::SplineRenderer::SetCurveCuller(CurveCuller* curveCuller)
 {
-    mLight = light;
+    mCurveCuller = curveCuller;
 }
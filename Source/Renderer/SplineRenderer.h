@@ -1,10 +1,10 @@
 #pragma once
 
-#include "Node/Camera/FreeCamera.h"
-#include "Node/Light/DirectionalLight.h"
-#include "Node/Mesh/Sphere.h"
-#include "Node/Model/Model.h"
+#include "Core/Constants.h"
 #include "Renderer/Base/Shader.h"
+#include "Renderer/CurveCuller.h"
+#include "Renderer/SplineBufferCache.h"
+#include "Renderer/TubeMeshCache.h"
 
 #include <QOpenGLFunctions_4_5_Core>
 
@@ -20,18 +20,31 @@ namespace BSplineRenderer
         void Initialize();
         void Render();
         void SetCurveContainer(CurveContainer* CurveContainer);
-        void SetCamera(FreeCameraPtr camera);
-        void SetLight(DirectionalLightPtr light);
+        void SetTubeMeshCache(TubeMeshCache* tubeMeshCache);
+        void SetSplineBufferCache(SplineBufferCache* splineBufferCache);
+        void SetCurveCuller(CurveCuller* curveCuller);
 
       private:
         CurveContainer* mCurveContainer;
-        FreeCameraPtr mCamera;
-        DirectionalLightPtr mLight;
+
+        TubeMeshCache* mTubeMeshCache;
+        SplineBufferCache* mSplineBufferCache;
+        CurveCuller* mCurveCuller;
 
         Shader* mSplineShader;
+        Shader* mTubeShader;
+        Shader* mTubeImpostorShader;
+
+        // Uniform locations of the spline and the tube shader, looked up once they are linked
+        GLint mNumberOfSegmentsLocation{ -1 };
+        GLint mNumberOfSectorsLocation{ -1 };
+        GLint mCurveIndexLocation{ -1 };
 
         DEFINE_MEMBER(bool, Wireframe, false);
         DEFINE_MEMBER(int, NumberOfSegments, DEFAULT_NUMBER_OF_SEGMENTS);
         DEFINE_MEMBER(int, NumberOfSectors, DEFAULT_NUMBER_OF_SECTORS);
+
+        // Draws the triangle meshes of TubeMeshCache instead of tessellating on the GPU
+        DEFINE_MEMBER(bool, CpuTubeMesh, false);
     };
 }
\ No newline at end of file
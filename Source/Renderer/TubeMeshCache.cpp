@@ -0,0 +1,303 @@
+#include "TubeMeshCache.h"
+
+#include "Util/JobSystem.h"
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+namespace
+{
+    // Long curves are split into jobs of this many patches so that a single curve also uses all cores
+    constexpr int PATCHES_PER_JOB = 64;
+}
+
+BSplineRenderer::TubeMeshCache::TubeMeshCache()
+{
+    initializeOpenGLFunctions();
+}
+
+BSplineRenderer::TubeMeshCache::~TubeMeshCache()
+{
+    for (auto& [curve, entry] : mEntries)
+    {
+        Destroy(entry);
+    }
+
+    for (auto& entry : mReleasedEntries)
+    {
+        Destroy(entry);
+    }
+}
+
+void BSplineRenderer::TubeMeshCache::Build(const QVector<SplinePtr>& curves, int segments, int sectors)
+{
+    std::unordered_set<unsigned long long> alive;
+
+    for (const auto& curve : curves)
+    {
+        alive.insert(curve->GetId());
+    }
+
+    for (auto it = mEntries.begin(); it != mEntries.end();)
+    {
+        if (alive.contains(it->first) == false)
+        {
+            mReleasedEntries.push_back(std::move(it->second));
+            it = mEntries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    struct Job
+    {
+        Entry* entry;
+        const Spline* curve;
+        int firstPatch;
+        int lastPatch;
+    };
+
+    QVector<Job> jobs;
+    int rebuiltCount = 0;
+
+    for (const auto& curve : curves)
+    {
+        Entry& entry = mEntries[curve->GetId()];
+        const int patchCount = curve->GetPatchCount();
+
+        const bool resized = entry.mesh.patchCount != patchCount ||
+                             entry.mesh.segments != segments ||
+                             entry.mesh.sectors != sectors;
+
+        int firstPatch = 0;
+        int lastPatch = patchCount - 1;
+
+        if (resized)
+        {
+            TubeMeshBuilder::Allocate(*curve, segments, sectors, entry.mesh);
+            entry.restage = true;
+        }
+        else if (entry.radius == curve->GetRadius())
+        {
+            if (entry.version == curve->GetVersion())
+            {
+                continue;
+            }
+
+            curve->GetChangedPatches(entry.version, firstPatch, lastPatch);
+        }
+
+        entry.version = curve->GetVersion();
+        entry.radius = curve->GetRadius();
+
+        if (resized == false && firstPatch > lastPatch)
+        {
+            continue;
+        }
+
+        for (int first = firstPatch; first <= lastPatch; first += PATCHES_PER_JOB)
+        {
+            jobs << Job{ &entry, curve.get(), first, std::min(first + PATCHES_PER_JOB - 1, lastPatch) };
+        }
+
+        if (entry.pending == false)
+        {
+            entry.pending = true;
+            entry.pendingFirst = firstPatch;
+            entry.pendingLast = lastPatch;
+            mPendingUploads << curve->GetId();
+        }
+        else
+        {
+            entry.pendingFirst = std::min(entry.pendingFirst, firstPatch);
+            entry.pendingLast = std::max(entry.pendingLast, lastPatch);
+        }
+
+        ++rebuiltCount;
+    }
+
+    JobSystem::Instance().Map(jobs, [](const Job& job) {
+        TubeMeshBuilder::BuildPatches(*job.curve, job.firstPatch, job.lastPatch, job.entry->mesh);
+    });
+
+    mRebuildCount = rebuiltCount;
+}
+
+void BSplineRenderer::TubeMeshCache::Upload()
+{
+    for (auto& entry : mReleasedEntries)
+    {
+        Destroy(entry);
+    }
+
+    // Entries dropped since they were rebuilt are not found
+    for (const auto& id : mPendingUploads)
+    {
+        const auto it = mEntries.find(id);
+
+        if (it != mEntries.end() && it->second.pending)
+        {
+            Upload(it->second);
+            it->second.pending = false;
+        }
+    }
+
+    mReleasedEntries.clear();
+    mPendingUploads.clear();
+}
+
+void BSplineRenderer::TubeMeshCache::Render(const SplinePtr& curve)
+{
+    const auto it = mEntries.find(curve->GetId());
+
+    if (it == mEntries.end() || it->second.indexCount == 0)
+    {
+        return;
+    }
+
+    glBindVertexArray(it->second.vertexArray);
+    glDrawElements(GL_TRIANGLES, it->second.indexCount, GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+}
+
+void BSplineRenderer::TubeMeshCache::Upload(Entry& entry)
+{
+    const TubeMesh& mesh = entry.mesh;
+
+    if (entry.vertexArray == 0)
+    {
+        glGenVertexArrays(1, &entry.vertexArray);
+        glGenBuffers(1, &entry.vertexBuffer);
+        glGenBuffers(1, &entry.indexBuffer);
+
+        if (entry.vertexArray == 0 || entry.vertexBuffer == 0 || entry.indexBuffer == 0)
+        {
+            BR_EXIT_FAILURE("TubeMeshCache::Upload: OpenGL handle(s) could not be created!");
+        }
+    }
+
+    const int vertexCount = mesh.vertices.size();
+    const int indexCount = mesh.indices.size();
+
+    // Positions in the first part of the buffer, normals from the vertex capacity on
+    if (vertexCount > entry.vertexCapacity)
+    {
+        entry.vertexCapacity = std::max(vertexCount + vertexCount / 4, 2 * entry.vertexCapacity);
+        entry.restage = true;
+
+        glBindVertexArray(entry.vertexArray);
+
+        glBindBuffer(GL_ARRAY_BUFFER, entry.vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, 2 * entry.vertexCapacity * sizeof(QVector3D), nullptr, GL_DYNAMIC_DRAW);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(QVector3D), (void*) 0);
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(QVector3D), (void*) (entry.vertexCapacity * sizeof(QVector3D)));
+        glEnableVertexAttribArray(1);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, entry.indexBuffer);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    if (indexCount > entry.indexCapacity)
+    {
+        entry.indexCapacity = std::max(indexCount + indexCount / 4, 2 * entry.indexCapacity);
+        entry.restage = true;
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, entry.indexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, entry.indexCapacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // The indices of a patch only depend on its place and the resolution, they are copied with the whole mesh only
+    int firstVertex = 0;
+    int copiedVertexCount = vertexCount;
+    int copiedIndexCount = indexCount;
+
+    if (entry.restage == false)
+    {
+        firstVertex = entry.pendingFirst * mesh.GetVertexCountPerPatch();
+        copiedVertexCount = (entry.pendingLast - entry.pendingFirst + 1) * mesh.GetVertexCountPerPatch();
+        copiedIndexCount = 0;
+    }
+
+    const GLintptr positionOffset = firstVertex * sizeof(QVector3D);
+    const GLintptr normalOffset = (entry.vertexCapacity + firstVertex) * sizeof(QVector3D);
+    const GLsizeiptr vertexSize = copiedVertexCount * sizeof(QVector3D);
+    const GLsizeiptr indexSize = copiedIndexCount * sizeof(unsigned int);
+    const GLsizeiptr size = 2 * vertexSize + indexSize;
+
+    const QVector3D* positions = mesh.vertices.constData() + firstVertex;
+    const QVector3D* normals = mesh.normals.constData() + firstVertex;
+
+    entry.indexCount = indexCount;
+    entry.restage = false;
+    entry.pendingFirst = 0;
+    entry.pendingLast = -1;
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (size <= mRingBuffer->GetAvailableSize())
+    {
+        GLintptr offset = 0;
+        char* staging = mRingBuffer->Map(size, offset);
+        std::memcpy(staging, positions, vertexSize);
+        std::memcpy(staging + vertexSize, normals, vertexSize);
+        std::memcpy(staging + 2 * vertexSize, mesh.indices.constData(), indexSize);
+
+        mRingBuffer->Copy(offset, entry.vertexBuffer, positionOffset, vertexSize);
+        mRingBuffer->Copy(offset + vertexSize, entry.vertexBuffer, normalOffset, vertexSize);
+
+        if (indexSize > 0)
+        {
+            mRingBuffer->Copy(offset + 2 * vertexSize, entry.indexBuffer, 0, indexSize);
+        }
+    }
+    else
+    {
+        // A restage too large for this frame's region would grow the ring buffer for good, the driver stages it instead
+        glBindBuffer(GL_COPY_WRITE_BUFFER, entry.vertexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, positionOffset, vertexSize, positions);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, normalOffset, vertexSize, normals);
+
+        if (indexSize > 0)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, entry.indexBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, 0, indexSize, mesh.indices.constData());
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+void BSplineRenderer::TubeMeshCache::Destroy(Entry& entry)
+{
+    if (entry.vertexArray != 0)
+    {
+        glDeleteVertexArrays(1, &entry.vertexArray);
+        entry.vertexArray = 0;
+    }
+
+    if (entry.vertexBuffer != 0)
+    {
+        glDeleteBuffers(1, &entry.vertexBuffer);
+        entry.vertexBuffer = 0;
+    }
+
+    if (entry.indexBuffer != 0)
+    {
+        glDeleteBuffers(1, &entry.indexBuffer);
+        entry.indexBuffer = 0;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Curve/Spline.h"
+#include "Curve/TubeMesh.h"
+#include "Renderer/Base/RingBuffer.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QVector>
+#include <memory>
+#include <unordered_map>
+
+namespace BSplineRenderer
+{
+    // Triangle meshes of the curves generated on the CPU, an alternative to the tessellation shaders.
+    // Every patch has the same number of vertices and indices, so a patch has a fixed place in the buffers
+    // and only the patches changed since the last build are rebuilt and copied through the RingBuffer.
+    // The whole mesh is restaged only if the patch count or the resolution changes. The buffers of a mesh
+    // are kept with spare capacity.
+    class TubeMeshCache : protected QOpenGLExtraFunctions
+    {
+        DISABLE_COPY(TubeMeshCache);
+
+      public:
+        TubeMeshCache();
+        ~TubeMeshCache();
+
+        // Rebuilds the changed patches in parallel and drops the meshes of removed curves. Does not touch
+        // OpenGL, so it can run on any thread while the context thread does something else.
+        void Build(const QVector<SplinePtr>& curves, int segments, int sectors);
+
+        // Uploads the meshes rebuilt and deletes the buffers dropped by Build(), on the context thread
+        void Upload();
+
+        // Draws the mesh of the curve with the currently bound shader, Upload() must be called first
+        void Render(const SplinePtr& curve);
+
+        int GetRebuildCount() const { return mRebuildCount; }
+
+        void SetRingBuffer(RingBuffer* ringBuffer) { mRingBuffer = ringBuffer; }
+
+      private:
+        struct Entry
+        {
+            unsigned long long version{ 0 };
+            float radius{ 0.0f };
+
+            TubeMesh mesh;
+
+            GLuint vertexArray{ 0 };
+            GLuint vertexBuffer{ 0 };
+            GLuint indexBuffer{ 0 };
+            int indexCount{ 0 };
+
+            // Allocated sizes of the buffers in vertices and indices
+            int vertexCapacity{ 0 };
+            int indexCapacity{ 0 };
+
+            // Rebuilt but not uploaded yet, the whole mesh if restage is set and the patches
+            // [pendingFirst, pendingLast] otherwise
+            bool pending{ false };
+            bool restage{ false };
+            int pendingFirst{ 0 };
+            int pendingLast{ -1 };
+        };
+
+        void Upload(Entry& entry);
+        void Destroy(Entry& entry);
+
+        // Keyed by the curve ID
+        std::unordered_map<unsigned long long, Entry> mEntries;
+
+        // Left for Upload() by Build()
+        QVector<unsigned long long> mPendingUploads;
+        std::vector<Entry> mReleasedEntries;
+
+        RingBuffer* mRingBuffer;
+
+        // Number of meshes rebuilt by the last Build()
+        int mRebuildCount{ 0 };
+    };
+}
@@ -0,0 +1,149 @@
+#include "Bvh.h"
+
+void BSplineRenderer::Bvh::Build(const std::vector<Box>& boxes)
+{
+    const int count = boxes.size();
+
+    mNodes.clear();
+    mPrimitives.resize(count);
+    mLeaves.resize(count);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::vector<QVector3D> centers(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        mPrimitives[i] = i;
+        centers[i] = 0.5f * (boxes[i].min + boxes[i].max);
+    }
+
+    mNodes.reserve(2 * (count / MAX_LEAF_SIZE + 1));
+    mNodes.push_back(Node{ Box(), 0, 0, -1 });
+    BuildNode(boxes, centers, 0, 0, count);
+}
+
+void BSplineRenderer::Bvh::Refit(const std::vector<Box>& boxes, int first, int last)
+{
+    first = std::max(first, 0);
+    last = std::min(last, int(mLeaves.size()) - 1);
+
+    for (int primitive = first; primitive <= last; ++primitive)
+    {
+        int index = mLeaves[primitive];
+
+        // Neighbouring primitives mostly share their leaf, it is refit once
+        if (primitive > first && mLeaves[primitive - 1] == index)
+        {
+            continue;
+        }
+
+        Box box = LeafBox(boxes, mNodes[index]);
+
+        while (index >= 0)
+        {
+            Node& node = mNodes[index];
+
+            if (node.box.min == box.min && node.box.max == box.max)
+            {
+                break;
+            }
+
+            node.box = box;
+            index = node.parent;
+
+            if (index >= 0)
+            {
+                const int left = mNodes[index].first;
+                box = Merge(mNodes[left].box, mNodes[left + 1].box);
+            }
+        }
+    }
+}
+
+bool BSplineRenderer::Bvh::Intersect(const Box& box, const QVector3D& origin, const QVector3D& inverseDirection, float margin, float maxT, float& t)
+{
+    float near = 0.0f;
+    float far = maxT;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float t0 = (box.min[axis] - margin - origin[axis]) * inverseDirection[axis];
+        const float t1 = (box.max[axis] + margin - origin[axis]) * inverseDirection[axis];
+
+        near = std::max(near, std::min(t0, t1));
+        far = std::min(far, std::max(t0, t1));
+    }
+
+    t = near;
+
+    return near <= far;
+}
+
+BSplineRenderer::Bvh::Box BSplineRenderer::Bvh::Merge(const Box& a, const Box& b)
+{
+    Box box;
+    box.min = QVector3D(std::min(a.min.x(), b.min.x()), std::min(a.min.y(), b.min.y()), std::min(a.min.z(), b.min.z()));
+    box.max = QVector3D(std::max(a.max.x(), b.max.x()), std::max(a.max.y(), b.max.y()), std::max(a.max.z(), b.max.z()));
+    return box;
+}
+
+void BSplineRenderer::Bvh::BuildNode(const std::vector<Box>& boxes, std::vector<QVector3D>& centers, int index, int first, int count)
+{
+    mNodes[index].first = first;
+    mNodes[index].count = count;
+
+    if (count <= MAX_LEAF_SIZE)
+    {
+        for (int i = first; i < first + count; ++i)
+        {
+            mLeaves[mPrimitives[i]] = index;
+        }
+
+        mNodes[index].box = LeafBox(boxes, mNodes[index]);
+        return;
+    }
+
+    // Median split along the longest axis of the centers
+    Box centerBounds;
+
+    for (int i = first; i < first + count; ++i)
+    {
+        const QVector3D& center = centers[mPrimitives[i]];
+        centerBounds = Merge(centerBounds, Box{ center, center });
+    }
+
+    const QVector3D extent = centerBounds.max - centerBounds.min;
+    const int axis = extent.x() >= extent.y() && extent.x() >= extent.z() ? 0 : (extent.y() >= extent.z() ? 1 : 2);
+
+    const int half = count / 2;
+    const auto begin = mPrimitives.begin() + first;
+    std::nth_element(begin, begin + half, begin + count, [&centers, axis](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+    const int left = mNodes.size();
+    mNodes.push_back(Node{ Box(), 0, 0, index });
+    mNodes.push_back(Node{ Box(), 0, 0, index });
+
+    mNodes[index].first = left;
+    mNodes[index].count = 0;
+
+    BuildNode(boxes, centers, left, first, half);
+    BuildNode(boxes, centers, left + 1, first + half, count - half);
+
+    mNodes[index].box = Merge(mNodes[left].box, mNodes[left + 1].box);
+}
+
+BSplineRenderer::Bvh::Box BSplineRenderer::Bvh::LeafBox(const std::vector<Box>& boxes, const Node& node) const
+{
+    Box box;
+
+    for (int i = node.first; i < node.first + node.count; ++i)
+    {
+        box = Merge(box, boxes[mPrimitives[i]]);
+    }
+
+    return box;
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <QVector3D>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // Bounding volume hierarchy over axis aligned boxes, built top down with median splits. The boxes
+    // are owned by the caller and passed again when they change: the bounds of the nodes above a changed
+    // box are refit without changing the tree, which is fine as long as the boxes move coherently.
+    class Bvh
+    {
+      public:
+        struct Box
+        {
+            QVector3D min{ INFINITY, INFINITY, INFINITY };
+            QVector3D max{ -INFINITY, -INFINITY, -INFINITY };
+        };
+
+        Bvh() = default;
+
+        void Build(const std::vector<Box>& boxes);
+
+        // The boxes [first, last] have changed, their number must be the same as in Build()
+        void Refit(const std::vector<Box>& boxes, int first, int last);
+
+        // Calls function(primitive, maxT) for the boxes, widened by margin, hit by origin + t * direction
+        // with 0 <= t <= maxT, nearest nodes first. The function may lower maxT to prune farther nodes.
+        template <typename Function>
+        void Traverse(const QVector3D& origin, const QVector3D& direction, float margin, float& maxT, const Function& function) const;
+
+        // Calls function(primitive) for the primitives of the leaves overlapping the box, a superset of the boxes overlapping it
+        template <typename Function>
+        void Query(const Box& box, const Function& function) const;
+
+        bool IsEmpty() const { return mNodes.empty(); }
+        int GetPrimitiveCount() const { return int(mPrimitives.size()); }
+        const Box& GetBounds() const { return mNodes.front().box; }
+
+        // Entry distance of the ray into the box widened by margin, false if it is not within [0, maxT]
+        static bool Intersect(const Box& box, const QVector3D& origin, const QVector3D& inverseDirection, float margin, float maxT, float& t);
+
+        static Box Merge(const Box& a, const Box& b);
+
+        static constexpr int MAX_LEAF_SIZE = 4;
+
+      private:
+        struct Node
+        {
+            Box box;
+
+            // Leaf: first index into mPrimitives, otherwise the left child, the right child follows it
+            int first;
+            int count;
+            int parent;
+        };
+
+        void BuildNode(const std::vector<Box>& boxes, std::vector<QVector3D>& centers, int index, int first, int count);
+        Box LeafBox(const std::vector<Box>& boxes, const Node& node) const;
+
+        std::vector<Node> mNodes;
+        std::vector<int> mPrimitives;
+
+        // Leaf node of every primitive
+        std::vector<int> mLeaves;
+    };
+
+    template <typename Function>
+    void Bvh::Traverse(const QVector3D& origin, const QVector3D& direction, float margin, float& maxT, const Function& function) const
+    {
+        if (mNodes.empty())
+        {
+            return;
+        }
+
+        const QVector3D inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+
+        float t = 0.0f;
+
+        if (Intersect(mNodes.front().box, origin, inverseDirection, margin, maxT, t) == false)
+        {
+            return;
+        }
+
+        struct Entry
+        {
+            int node;
+            float t;
+        };
+
+        Entry stack[64];
+        int size = 0;
+        stack[size++] = Entry{ 0, t };
+
+        while (size > 0)
+        {
+            const Entry entry = stack[--size];
+
+            // Lowered by a hit found after it was pushed
+            if (entry.t > maxT)
+            {
+                continue;
+            }
+
+            const Node& node = mNodes[entry.node];
+
+            if (node.count > 0)
+            {
+                for (int i = node.first; i < node.first + node.count; ++i)
+                {
+                    function(mPrimitives[i], maxT);
+                }
+
+                continue;
+            }
+
+            float leftT = 0.0f;
+            float rightT = 0.0f;
+            const bool left = Intersect(mNodes[node.first].box, origin, inverseDirection, margin, maxT, leftT);
+            const bool right = Intersect(mNodes[node.first + 1].box, origin, inverseDirection, margin, maxT, rightT);
+
+            // The nearer child is pushed last so that it is visited first
+            if (left && right)
+            {
+                if (leftT < rightT)
+                {
+                    stack[size++] = Entry{ node.first + 1, rightT };
+                    stack[size++] = Entry{ node.first, leftT };
+                }
+                else
+                {
+                    stack[size++] = Entry{ node.first, leftT };
+                    stack[size++] = Entry{ node.first + 1, rightT };
+                }
+            }
+            else if (left)
+            {
+                stack[size++] = Entry{ node.first, leftT };
+            }
+            else if (right)
+            {
+                stack[size++] = Entry{ node.first + 1, rightT };
+            }
+        }
+    }
+
+    template <typename Function>
+    void Bvh::Query(const Box& box, const Function& function) const
+    {
+        if (mNodes.empty())
+        {
+            return;
+        }
+
+        int stack[64];
+        int size = 0;
+        stack[size++] = 0;
+
+        while (size > 0)
+        {
+            const Node& node = mNodes[stack[--size]];
+            bool overlaps = true;
+
+            for (int axis = 0; axis < 3 && overlaps; ++axis)
+            {
+                overlaps = node.box.min[axis] <= box.max[axis] && box.min[axis] <= node.box.max[axis];
+            }
+
+            if (overlaps == false)
+            {
+                continue;
+            }
+
+            if (node.count > 0)
+            {
+                for (int i = node.first; i < node.first + node.count; ++i)
+                {
+                    function(mPrimitives[i]);
+                }
+
+                continue;
+            }
+
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+BSplineRenderer::Frustum::Frustum(const QMatrix4x4& viewProjection)
+{
+    // Gribb and Hartmann, a point p is inside if dot(plane, (p, 1)) >= 0 for every plane
+    const QVector4D x = viewProjection.row(0);
+    const QVector4D y = viewProjection.row(1);
+    const QVector4D z = viewProjection.row(2);
+    const QVector4D w = viewProjection.row(3);
+
+    mPlanes[0] = w + x;
+    mPlanes[1] = w - x;
+    mPlanes[2] = w + y;
+    mPlanes[3] = w - y;
+    mPlanes[4] = w + z;
+    mPlanes[5] = w - z;
+}
+
+bool BSplineRenderer::Frustum::Intersects(const QVector3D& min, const QVector3D& max) const
+{
+    for (const QVector4D& plane : mPlanes)
+    {
+        // The corner furthest along the plane normal
+        const float x = plane.x() >= 0.0f ? max.x() : min.x();
+        const float y = plane.y() >= 0.0f ? max.y() : min.y();
+        const float z = plane.z() >= 0.0f ? max.z() : min.z();
+
+        if (plane.x() * x + plane.y() * y + plane.z() * z + plane.w() < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+void BSplineRenderer::Frustum::Transform(const QMatrix4x4& model, const QVector3D& min, const QVector3D& max, float margin, QVector3D& worldMin, QVector3D& worldMax)
+{
+    const QVector3D center = model.map(0.5f * (min + max));
+    const QVector3D extent = 0.5f * (max - min);
+
+    QVector3D worldExtent;
+
+    for (int row = 0; row < 3; ++row)
+    {
+        worldExtent[row] = margin + std::abs(model(row, 0)) * extent.x() + std::abs(model(row, 1)) * extent.y() + std::abs(model(row, 2)) * extent.z();
+    }
+
+    worldMin = center - worldExtent;
+    worldMax = center + worldExtent;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QVector4D>
+
+namespace BSplineRenderer
+{
+    // The six planes of a view frustum, extracted from a view projection matrix
+    class Frustum
+    {
+      public:
+        explicit Frustum(const QMatrix4x4& viewProjection);
+
+        // Conservative, false only if the box is completely outside of a plane
+        bool Intersects(const QVector3D& min, const QVector3D& max) const;
+
+        // World space bounds of a model space box, widened by margin in every direction
+        static void Transform(const QMatrix4x4& model, const QVector3D& min, const QVector3D& max, float margin, QVector3D& worldMin, QVector3D& worldMax);
+
+      private:
+        QVector4D mPlanes[6];
+    };
+}
@@ -0,0 +1,189 @@
+#include "JobSystem.h"
+
+#include <QThread>
+#include <algorithm>
+
+namespace
+{
+    // Queue of the current thread, 0 for the threads outside the pool
+    thread_local int tQueue = 0;
+}
+
+BSplineRenderer::JobSystem::JobSystem()
+{
+    Start(std::max(1, QThread::idealThreadCount()) - 1);
+}
+
+BSplineRenderer::JobSystem::~JobSystem()
+{
+    Stop();
+}
+
+void BSplineRenderer::JobSystem::Submit(Job job, std::atomic<int>& counter)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+
+    Queue& queue = *mQueues[tQueue];
+
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back({ std::move(job), &counter });
+    }
+
+    mQueuedCount.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders the wake up after the check of a worker about to sleep
+    {
+        std::lock_guard lock(mSleepMutex);
+    }
+
+    mWakeUp.notify_one();
+}
+
+void BSplineRenderer::JobSystem::Wait(const std::atomic<int>& counter)
+{
+    while (counter.load(std::memory_order_acquire) > 0)
+    {
+        if (RunOne(tQueue) == false)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void BSplineRenderer::JobSystem::ParallelFor(int count, int grain, const std::function<void(int, int)>& function)
+{
+    grain = std::max(1, grain);
+
+    if (count <= grain || mWorkers.empty())
+    {
+        if (count > 0)
+            function(0, count);
+
+        return;
+    }
+
+    std::atomic<int> counter{ 0 };
+
+    for (int first = grain; first < count; first += grain)
+    {
+        const int size = std::min(grain, count - first);
+        Submit([&function, first, size]() { function(first, size); }, counter);
+    }
+
+    function(0, grain);
+    Wait(counter);
+}
+
+void BSplineRenderer::JobSystem::SetThreadCount(int threadCount)
+{
+    threadCount = std::max(1, threadCount);
+
+    if (threadCount == GetThreadCount())
+        return;
+
+    Stop();
+    Start(threadCount - 1);
+}
+
+void BSplineRenderer::JobSystem::Start(int workerCount)
+{
+    mStopping = false;
+    mQueues.clear();
+
+    for (int i = 0; i <= workerCount; ++i)
+    {
+        mQueues.push_back(std::make_unique<Queue>());
+    }
+
+    for (int i = 0; i < workerCount; ++i)
+    {
+        mWorkers.emplace_back([this, i]() { Work(i + 1); });
+    }
+}
+
+void BSplineRenderer::JobSystem::Stop()
+{
+    {
+        std::lock_guard lock(mSleepMutex);
+        mStopping = true;
+    }
+
+    mWakeUp.notify_all();
+
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+
+    mWorkers.clear();
+}
+
+void BSplineRenderer::JobSystem::Work(int queue)
+{
+    tQueue = queue;
+
+    while (true)
+    {
+        if (RunOne(queue))
+            continue;
+
+        std::unique_lock lock(mSleepMutex);
+        mWakeUp.wait(lock, [this]() { return mStopping || mQueuedCount.load(std::memory_order_acquire) > 0; });
+
+        if (mStopping)
+            return;
+    }
+}
+
+bool BSplineRenderer::JobSystem::RunOne(int queue)
+{
+    Task task;
+
+    if (Pop(queue, task) == false && Steal(queue, task) == false)
+    {
+        return false;
+    }
+
+    task.job();
+    task.counter->fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+bool BSplineRenderer::JobSystem::Pop(int queue, Task& task)
+{
+    Queue& own = *mQueues[queue];
+    std::lock_guard lock(own.mutex);
+
+    if (own.tasks.empty())
+        return false;
+
+    task = std::move(own.tasks.back());
+    own.tasks.pop_back();
+    mQueuedCount.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool BSplineRenderer::JobSystem::Steal(int queue, Task& task)
+{
+    const int count = mQueues.size();
+
+    for (int i = 1; i < count; ++i)
+    {
+        Queue& victim = *mQueues[(queue + i) % count];
+        std::lock_guard lock(victim.mutex);
+
+        if (victim.tasks.empty())
+            continue;
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        mQueuedCount.fetch_sub(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    return false;
+}
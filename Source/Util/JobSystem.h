@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Util/Macros.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // Work-stealing thread pool with one thread per core. Every worker owns a queue: it runs its own
+    // jobs newest first and steals the oldest jobs of the others when it runs dry. Jobs submitted by
+    // other threads go to a shared queue. A thread waiting for jobs runs queued jobs meanwhile, so
+    // jobs may submit and wait for nested jobs without blocking a core.
+    class JobSystem
+    {
+        DISABLE_COPY(JobSystem);
+
+      public:
+        using Job = std::function<void()>;
+
+        static JobSystem& Instance()
+        {
+            static JobSystem instance;
+            return instance;
+        }
+
+        // Queues the job. The counter is incremented now and decremented after the job has run.
+        void Submit(Job job, std::atomic<int>& counter);
+
+        // Runs queued jobs until the counter drops to zero
+        void Wait(const std::atomic<int>& counter);
+
+        // Calls function(first, count) for chunks of at most grain indices of [0, count) on all threads.
+        // Returns when every chunk is done, the calling thread runs chunks too.
+        void ParallelFor(int count, int grain, const std::function<void(int, int)>& function);
+
+        // Calls function(item) for every item on all threads, like QtConcurrent::blockingMap.
+        // The items are handed out in a few chunks per thread.
+        template <typename Container, typename Function>
+        void Map(Container& items, const Function& function)
+        {
+            const int count = items.size();
+            const int grain = count / (CHUNKS_PER_THREAD * GetThreadCount());
+
+            ParallelFor(count, grain, [&items, &function](int first, int size) {
+                for (int i = first; i < first + size; ++i)
+                {
+                    function(items[i]);
+                }
+            });
+        }
+
+        // Threads running jobs, the workers and the waiting thread
+        int GetThreadCount() const { return int(mWorkers.size()) + 1; }
+
+        // Restarts the pool with threadCount - 1 workers. No job may be queued or running.
+        void SetThreadCount(int threadCount);
+
+        static constexpr int CHUNKS_PER_THREAD = 4;
+
+      private:
+        JobSystem();
+        ~JobSystem();
+
+        struct Task
+        {
+            Job job;
+            std::atomic<int>* counter;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void Start(int workerCount);
+        void Stop();
+        void Work(int queue);
+
+        // Runs one job of the own queue, the shared queue or another worker's queue
+        bool RunOne(int queue);
+        bool Pop(int queue, Task& task);
+        bool Steal(int queue, Task& task);
+
+        // Queue 0 is shared by the threads outside the pool, queue i + 1 belongs to worker i
+        std::vector<std::unique_ptr<Queue>> mQueues;
+        std::vector<std::thread> mWorkers;
+
+        // Queued jobs, idle workers sleep while there is none
+        std::atomic<int> mQueuedCount{ 0 };
+        std::mutex mSleepMutex;
+        std::condition_variable mWakeUp;
+        bool mStopping{ false };
+    };
+}
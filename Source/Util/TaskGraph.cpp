@@ -0,0 +1,63 @@
+#include "TaskGraph.h"
+
+#include "Util/JobSystem.h"
+
+#include <chrono>
+
+int BSplineRenderer::TaskGraph::AddTask(const std::string& name, std::function<void()> function)
+{
+    auto task = std::make_unique<Task>();
+    task->name = name;
+    task->function = std::move(function);
+    mTasks.push_back(std::move(task));
+
+    return int(mTasks.size()) - 1;
+}
+
+void BSplineRenderer::TaskGraph::AddDependency(int task, int dependency)
+{
+    mTasks[dependency]->successors.push_back(task);
+    mTasks[task]->dependencyCount++;
+}
+
+void BSplineRenderer::TaskGraph::Run()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (const auto& task : mTasks)
+    {
+        task->waitCount.store(task->dependencyCount, std::memory_order_relaxed);
+    }
+
+    std::atomic<int> counter{ 0 };
+
+    for (int task = 0; task < GetTaskCount(); ++task)
+    {
+        if (mTasks[task]->dependencyCount == 0)
+            Start(task, counter);
+    }
+
+    JobSystem::Instance().Wait(counter);
+
+    mRunTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BSplineRenderer::TaskGraph::Start(int index, std::atomic<int>& counter)
+{
+    // The successors are submitted before this job counts as done, so the counter stays above zero until the last task
+    JobSystem::Instance().Submit(
+        [this, index, &counter]() {
+            Task& task = *mTasks[index];
+
+            const auto start = std::chrono::steady_clock::now();
+            task.function();
+            task.time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            for (const int successor : task.successors)
+            {
+                if (mTasks[successor]->waitCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    Start(successor, counter);
+            }
+        },
+        counter);
+}
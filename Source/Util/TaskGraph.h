@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Util/Macros.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BSplineRenderer
+{
+    // Tasks with dependencies run on the JobSystem. A task starts as soon as every task it depends on
+    // has finished, independent tasks run in parallel. Built once and run any number of times.
+    class TaskGraph
+    {
+        DISABLE_COPY(TaskGraph);
+
+      public:
+        TaskGraph() = default;
+
+        // Returns the index of the task
+        int AddTask(const std::string& name, std::function<void()> function);
+
+        // The task starts after the dependency has finished
+        void AddDependency(int task, int dependency);
+
+        // Runs every task once and returns when all have finished
+        void Run();
+
+        int GetTaskCount() const { return int(mTasks.size()); }
+        const std::string& GetTaskName(int task) const { return mTasks[task]->name; }
+
+        // Milliseconds the task has taken in the last run
+        double GetTaskTime(int task) const { return mTasks[task]->time; }
+
+        // Milliseconds from the start to the end of the last run
+        double GetRunTime() const { return mRunTime; }
+
+      private:
+        struct Task
+        {
+            std::string name;
+            std::function<void()> function;
+            std::vector<int> successors;
+            int dependencyCount{ 0 };
+
+            // Unfinished dependencies in the current run
+            std::atomic<int> waitCount{ 0 };
+            double time{ 0.0 };
+        };
+
+        void Start(int index, std::atomic<int>& counter);
+
+        std::vector<std::unique_ptr<Task>> mTasks;
+        double mRunTime{ 0.0 };
+    };
+}